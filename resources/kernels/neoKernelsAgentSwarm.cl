@@ -19,9 +19,9 @@ void kernel alDeriveInputs(read_only image2d_t inputs, read_only image2d_t outpu
 }
 
 void kernel alActivate(read_only image2d_t visibleStates,
-    read_only image3d_t weights,
+    global const float2* weights,
     read_only image2d_t hiddenSummationBack, write_only image2d_t hiddenSummationFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius)
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -33,6 +33,8 @@ void kernel alActivate(read_only image2d_t visibleStates,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
@@ -42,7 +44,7 @@ void kernel alActivate(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)].x;
 
                 float state = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -54,10 +56,58 @@ void kernel alActivate(read_only image2d_t visibleStates,
     write_imagef(hiddenSummationFront, hiddenPosition, (float4)(sum + q / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
 }
 
+// Local memory tiled variant of alActivate, the work-group shares one load of the visible patch its fields overlap
+void kernel alActivateTiled(read_only image2d_t visibleStates,
+    global const float2* weights,
+    read_only image2d_t hiddenSummationBack, write_only image2d_t hiddenSummationFront,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius,
+    local float* visibleTile, int2 visibleTileSize)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    // Visible patch shared by the work-group
+    int2 tileOrigin = project(groupPosition(), hiddenToVisible) - (int2)(radius);
+
+    loadTile(visibleStates, visibleTile, tileOrigin, visibleTileSize);
+
+    if (!inBounds0(hiddenPosition, hiddenSize))
+        return;
+
+    float sum = read_imagef(hiddenSummationBack, defaultSampler, hiddenPosition).x;
+
+    float q = 0.0f;
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)].x;
+
+                float state = readTile(visibleStates, visibleTile, tileOrigin, visibleTileSize, visiblePosition);
+
+                q += state * weight;
+				stateSum += state;
+            }
+        }
+
+    write_imagef(hiddenSummationFront, hiddenPosition, (float4)(sum + q / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
+}
+
 void kernel alLearnQ(read_only image2d_t visibleStates,
     read_only image2d_t oneHotActions, read_only image2d_t tdErrors,
-    read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius, float alpha, float lambda, int2 subActionDims)
+    global float2* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float alpha, float lambda, int2 subActionDims)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	
@@ -68,6 +118,8 @@ void kernel alLearnQ(read_only image2d_t visibleStates,
 	int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);		
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
 	
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
@@ -78,13 +130,15 @@ void kernel alLearnQ(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float2 weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+                int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+                float2 weightPrev = weights[index];
 
                 float2 state = read_imagef(visibleStates, defaultSampler, visiblePosition).xy;
 
                 float2 weight = (float2)(weightPrev.x + alpha * tdError * weightPrev.y, fmax(lambda * weightPrev.y, oneHotAction * state.x * state.y));
 
-                write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight.x, weight.y, 0.0f, 0.0f));
+                weights[index] = weight;
             }
         }
 }
@@ -140,6 +194,35 @@ void kernel alGetAction(read_only image2d_t activations,
 	write_imagef(actionsTakenMax, position, (float4)(maxIndex, 0.0f, 0.0f, 0.0f));
 }
 
+// Work-group per action tile variant of alGetAction (parallel argmax), launched with the action tile size as work-group size
+void kernel alGetActionGroup(read_only image2d_t activations,
+	write_only image2d_t actionsTaken, write_only image2d_t actionsTakenMax, int2 subActionDims, float epsilon, uint2 seed,
+	local float* maxValues, local int* maxKeys)
+{
+	int2 position = (int2)(get_group_id(0), get_group_id(1));
+	int2 delta = (int2)(get_local_id(0), get_local_id(1));
+
+	float value = read_imagef(activations, defaultSampler, position * subActionDims + delta).x;
+
+	// Keys in the scan order of alGetAction (x major), so ties resolve the same way
+	int maxKey = groupArgmaxSeeded(value, true, delta.y + delta.x * subActionDims.y, maxValues, maxKeys);
+
+	if (delta.x != 0 || delta.y != 0)
+		return;
+
+	uint2 seedValue = seed + (uint2)(position.x * 73 + 2, position.y * 45 + 12) * 44;
+
+	int maxIndex = maxKey / subActionDims.y + (maxKey % subActionDims.y) * subActionDims.x;
+
+	int exploreIndex = maxIndex;
+
+	if (randFloat(&seedValue) < epsilon)
+		exploreIndex = (int)(randFloat(&seedValue) * (subActionDims.x * subActionDims.y));
+
+	write_imagef(actionsTaken, position, (float4)(exploreIndex, 0.0f, 0.0f, 0.0f));
+	write_imagef(actionsTakenMax, position, (float4)(maxIndex, 0.0f, 0.0f, 0.0f));
+}
+
 void kernel alSetAction(read_only image2d_t modulator,
     read_only image2d_t actionsTaken, read_only image2d_t actionsTakenPrev,
     read_only image2d_t actionsTakenMax, read_only image2d_t actionsTakenMaxPrev,
@@ -9,8 +9,8 @@
 // ----------------------------------------- Sparse Coder -----------------------------------------
 
 void kernel scStimulus(read_only image2d_t visibleStates,
-    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
-    int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle)
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
@@ -22,6 +22,8 @@ void kernel scStimulus(read_only image2d_t visibleStates,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             if (ignoreMiddle && dx == 0 && dy == 0)
@@ -34,7 +36,7 @@ void kernel scStimulus(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
 
                 float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -46,8 +48,59 @@ void kernel scStimulus(read_only image2d_t visibleStates,
     write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(1.0f, count)));
 }
 
+// Local memory tiled variant of scStimulus, the work-group shares one load of the visible patch its fields overlap
+void kernel scStimulusTiled(read_only image2d_t visibleStates,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle,
+    local float* visibleTile, int2 visibleTileSize)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+    // Visible patch shared by the work-group
+    int2 groupStart = groupPosition();
+    int2 tileOrigin = (int2)(groupStart.x * hiddenToVisible.x + 0.5f, groupStart.y * hiddenToVisible.y + 0.5f) - (int2)(radius);
+
+    loadTile(visibleStates, visibleTile, tileOrigin, visibleTileSize);
+
+    if (!inBounds0(hiddenPosition, hiddenSize))
+        return;
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+    float count = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            if (ignoreMiddle && dx == 0 && dy == 0)
+                continue;
+
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
+
+                float visibleState = readTile(visibleStates, visibleTile, tileOrigin, visibleTileSize, visiblePosition);
+
+                subSum += visibleState * weight;
+                count += 1.0f;
+            }
+        }
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(1.0f, count)));
+}
+
 void kernel scReverse(read_only image2d_t hiddenStates, read_only image2d_t visibleStates,
-    write_only image2d_t reconErrors, read_only image3d_t weights,
+    write_only image2d_t reconErrors, global const float* weights,
     int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
 {
     int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
@@ -56,6 +109,8 @@ void kernel scReverse(read_only image2d_t hiddenStates, read_only image2d_t visi
     float recon = 0.0f;
     float div = 0.0f;
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
         for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
             int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
@@ -75,7 +130,7 @@ void kernel scReverse(read_only image2d_t hiddenStates, read_only image2d_t visi
 
                     int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                    float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                    float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
 
                     recon += hiddenState * weight;
                     div += hiddenState;
@@ -90,7 +145,7 @@ void kernel scReverse(read_only image2d_t hiddenStates, read_only image2d_t visi
 
 void kernel scSolveHidden(read_only image2d_t activations,
     write_only image2d_t hiddenStatesFront,
-    int2 hiddenSize, int radius, float activeRatio)
+    int2 hiddenSize, int radius, int stride, float activeRatio)
 {
     //uint2 seedValue = seed + (uint2)(get_global_id(0) * 51 + 23, get_global_id(1) * 82 + 59) * 24;
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
@@ -99,40 +154,25 @@ void kernel scSolveHidden(read_only image2d_t activations,
 
     float activation = read_imagef(activations, defaultSampler, hiddenPosition).x;
 
-    float inhibition = 0.0f;
-
-    float count = 0.0f;
-
-    for (int dx = -radius; dx <= radius; dx++)
-        for (int dy = -radius; dy <= radius; dy++) {
-            if (dx == 0 && dy == 0)
-                continue;
-
-            int2 otherPosition = hiddenPosition + (int2)(dx, dy);
-
-            if (inBounds0(otherPosition, hiddenSize)) {
-                float otherActivation = read_imagef(activations, defaultSampler, otherPosition).x;
-
-                inhibition += otherActivation >= activation ? 1.0f : 0.0f;
-                count += 1.0f;
-            }
-        }
+    float2 inhibition = sampleInhibition(activations, hiddenPosition, hiddenSize, radius, stride, activation);
 
-    float state = inhibition <= activeRatio * count ? 1.0f : 0.0f;
+    float state = inhibition.x <= activeRatio * inhibition.y ? 1.0f : 0.0f;
 
     write_imagef(hiddenStatesFront, hiddenPosition, (float4)(state));
 }
 
 void kernel scLearnWeights(read_only image2d_t hiddenStates, read_only image2d_t hiddenStatesPrev,
     read_only image2d_t reconErrors,
-    read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius, float activeRatio, float weightAlpha)
+    global float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float activeRatio, float weightAlpha)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     float hiddenState = read_imagef(hiddenStates, defaultSampler, hiddenPosition).x;
     float hiddenStatePrev = read_imagef(hiddenStatesPrev, defaultSampler, hiddenPosition).x;
 
@@ -145,11 +185,13 @@ void kernel scLearnWeights(read_only image2d_t hiddenStates, read_only image2d_t
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+                float weightPrev = weights[index];
 
                 float reconError = read_imagef(reconErrors, defaultSampler, visiblePosition).x;
 
-                write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weightPrev + weightAlpha * hiddenState * reconError));
+                weights[index] = weightPrev + weightAlpha * hiddenState * reconError;
             }
         }
 }
@@ -175,7 +217,7 @@ void kernel scDeriveInputs(read_only image2d_t inputs, read_only image2d_t outpu
 }
 
 void kernel scReconstruct(read_only image2d_t hiddenStates,
-    write_only image2d_t reconstruction, read_only image3d_t weights,
+    write_only image2d_t reconstruction, global const float* weights,
     int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
 {
     int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
@@ -184,6 +226,8 @@ void kernel scReconstruct(read_only image2d_t hiddenStates,
     float recon = 0.0f;
     float div = 0.0f;
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
         for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
             int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
@@ -203,7 +247,7 @@ void kernel scReconstruct(read_only image2d_t hiddenStates,
 
                     int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                    float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                    float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
 
                     recon += hiddenState * weight;
                     div += hiddenState;
@@ -275,3 +319,172 @@ void kernel whiten(read_only image2d_t input, write_only image2d_t result, int2
 
     write_imagef(result, position, whitenedColor);
 }
+
+// ----------------------------------------- Summed Area Whitening -----------------------------------------
+
+// Same result as whiten, per pixel cost independent of kernelRadius. Built as a summed area table in two scans
+// (row prefix sums, then column prefix sums of the horizontal box sums) so float error stays bounded per axis.
+
+// Inclusive prefix sums along each row, launched over rows
+void kernel whitenRowPrefix(read_only image2d_t input, global float4* rowPrefix, int2 imageSize) {
+    int y = get_global_id(0);
+
+    float4 sum = (float4)(0.0f);
+
+    for (int x = 0; x < imageSize.x; x++) {
+        sum += read_imagef(input, defaultSampler, (int2)(x, y));
+
+        rowPrefix[x + imageSize.x * y] = sum;
+    }
+}
+
+// Inclusive prefix sums along each column of the horizontal box sums, launched over columns
+void kernel whitenColumnPrefix(global const float4* rowPrefix, global float4* boxPrefix, int2 imageSize, int kernelRadius) {
+    int x = get_global_id(0);
+
+    int upper = min(x + kernelRadius, imageSize.x - 1);
+    int lower = x - kernelRadius - 1;
+
+    float4 sum = (float4)(0.0f);
+
+    for (int y = 0; y < imageSize.y; y++) {
+        sum += rowPrefix[upper + imageSize.x * y] - (lower >= 0 ? rowPrefix[lower + imageSize.x * y] : (float4)(0.0f));
+
+        boxPrefix[x + imageSize.x * y] = sum;
+    }
+}
+
+void kernel whitenSummedArea(read_only image2d_t input, global const float4* boxPrefix, write_only image2d_t result, int2 imageSize, int kernelRadius, float intensity) {
+    int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+    float4 currentColor = read_imagef(input, defaultSampler, position);
+
+    int upper = min(position.y + kernelRadius, imageSize.y - 1);
+    int lower = position.y - kernelRadius - 1;
+
+    // Sum over the window clipped to the image, including the current pixel
+    float4 boxSum = boxPrefix[position.x + imageSize.x * upper] - (lower >= 0 ? boxPrefix[position.x + imageSize.x * lower] : (float4)(0.0f));
+
+    int2 boxLowerBound = max(position - (int2)(kernelRadius), (int2)(0));
+    int2 boxUpperBound = min(position + (int2)(kernelRadius), imageSize - (int2)(1));
+
+    float count = (float)((boxUpperBound.x - boxLowerBound.x + 1) * (boxUpperBound.y - boxLowerBound.y + 1) - 1);
+
+    float4 center = boxSum / (count + 1.0f);
+
+    float4 centeredCurrentColor = currentColor - center;
+
+    // Sum over others of (other - center) * (current - center)
+    float4 covariances = (boxSum - currentColor - count * center) * centeredCurrentColor;
+
+    covariances /= fmax(1.0f, count);
+
+    // Modify color
+    float4 whitenedColor = fmin(1.0f, fmax(-1.0f, (centeredCurrentColor > 0.0f ? (float4)(1.0f) : (float4)(-1.0f)) * (1.0f - exp(-fabs(intensity * covariances)))));
+
+    write_imagef(result, position, whitenedColor);
+}
+
+// ----------------------------------------- Scalar Encoder -----------------------------------------
+
+// Device side ScalarEncoder, one output unit per pixel of the output image, weights indexed with wi = input index
+
+void kernel seActivate(global const float* inputs, global const float* weightsEncode, read_only image2d_t biases,
+    write_only image2d_t activations, int2 outputSize, int numInputs)
+{
+    int2 outputPosition = (int2)(get_global_id(0), get_global_id(1));
+
+    float sum = read_imagef(biases, defaultSampler, outputPosition).x;
+
+    for (int i = 0; i < numInputs; i++) {
+        float delta = inputs[i] - weightsEncode[weightIndex(outputPosition, i, outputSize, numInputs)];
+
+        sum += -delta * delta;
+    }
+
+    write_imagef(activations, outputPosition, (float4)(sum, 0.0f, 0.0f, 0.0f));
+}
+
+void kernel seInhibit(read_only image2d_t activations, write_only image2d_t outputs,
+    read_only image2d_t biasesBack, write_only image2d_t biasesFront,
+    int2 outputSize, float activeRatio, float beta)
+{
+    int2 outputPosition = (int2)(get_global_id(0), get_global_id(1));
+
+    float activation = read_imagef(activations, defaultSampler, outputPosition).x;
+
+    float numHigher = 0.0f;
+
+    for (int x = 0; x < outputSize.x; x++)
+        for (int y = 0; y < outputSize.y; y++) {
+            if (x == outputPosition.x && y == outputPosition.y)
+                continue;
+
+            float otherActivation = read_imagef(activations, defaultSampler, (int2)(x, y)).x;
+
+            if (otherActivation >= activation)
+                numHigher++;
+        }
+
+    float state = numHigher < activeRatio * outputSize.x * outputSize.y ? 1.0f : 0.0f;
+
+    write_imagef(outputs, outputPosition, (float4)(state, 0.0f, 0.0f, 0.0f));
+
+    float biasPrev = read_imagef(biasesBack, defaultSampler, outputPosition).x;
+
+    write_imagef(biasesFront, outputPosition, (float4)(biasPrev + beta * (activeRatio - state), 0.0f, 0.0f, 0.0f));
+}
+
+void kernel seReconstruct(global const float* inputs, read_only image2d_t outputs, global const float* weightsDecode,
+    global float* errors, int2 outputSize, int numInputs, float activeRatio)
+{
+    int i = get_global_id(0);
+
+    float sum = 0.0f;
+
+    for (int x = 0; x < outputSize.x; x++)
+        for (int y = 0; y < outputSize.y; y++) {
+            int2 outputPosition = (int2)(x, y);
+
+            float output = read_imagef(outputs, defaultSampler, outputPosition).x;
+
+            sum += weightsDecode[weightIndex(outputPosition, i, outputSize, numInputs)] * output;
+        }
+
+    errors[i] = inputs[i] - sum * activeRatio;
+}
+
+void kernel seLearn(read_only image2d_t outputs, global const float* errors, global float* weightsDecode,
+    int2 outputSize, int numInputs, float alpha)
+{
+    int2 outputPosition = (int2)(get_global_id(0), get_global_id(1));
+
+    float output = read_imagef(outputs, defaultSampler, outputPosition).x;
+
+    if (output == 0.0f)
+        return;
+
+    for (int i = 0; i < numInputs; i++)
+        weightsDecode[weightIndex(outputPosition, i, outputSize, numInputs)] += alpha * errors[i] * output;
+}
+
+void kernel seDecode(read_only image2d_t outputs, global const float* weightsEncode, global float* decoderOutputs,
+    int2 outputSize, int numInputs)
+{
+    int i = get_global_id(0);
+
+    float sum = 0.0f;
+    float count = 0.0f;
+
+    for (int x = 0; x < outputSize.x; x++)
+        for (int y = 0; y < outputSize.y; y++) {
+            int2 outputPosition = (int2)(x, y);
+
+            float output = read_imagef(outputs, defaultSampler, outputPosition).x;
+
+            sum += weightsEncode[weightIndex(outputPosition, i, outputSize, numInputs)] * output;
+            count += output;
+        }
+
+    decoderOutputs[i] = sum / fmax(1.0f, count);
+}
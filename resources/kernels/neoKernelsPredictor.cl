@@ -20,8 +20,8 @@ void kernel plDeriveInputs(read_only image2d_t inputs, read_only image2d_t outpu
 
 void kernel plStimulus(read_only image2d_t visibleStates,
     read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
-    read_only image3d_t weights,
-    int2 visibleSize, float2 hiddenToVisible, int radius)
+    global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -33,6 +33,56 @@ void kernel plStimulus(read_only image2d_t visibleStates,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
+
+                float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
+
+                subSum += visibleState * weight;
+				stateSum += visibleState;
+            }
+        }
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
+}
+
+// Local memory tiled variant of plStimulus, the work-group shares one load of the visible patch its fields overlap
+void kernel plStimulusTiled(read_only image2d_t visibleStates,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+    global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius,
+    local float* visibleTile, int2 visibleTileSize)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    // Visible patch shared by the work-group
+    int2 tileOrigin = project(groupPosition(), hiddenToVisible) - (int2)(radius);
+
+    loadTile(visibleStates, visibleTile, tileOrigin, visibleTileSize);
+
+    if (!inBounds0(hiddenPosition, hiddenSize))
+        return;
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
@@ -42,7 +92,54 @@ void kernel plStimulus(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
+
+                float visibleState = readTile(visibleStates, visibleTile, tileOrigin, visibleTileSize, visiblePosition);
+
+                subSum += visibleState * weight;
+				stateSum += visibleState;
+            }
+        }
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
+}
+
+// Same result as plStimulus for inputs that are one-hot per chunk, only visits the winner of each chunk overlapping the field
+void kernel plStimulusChunk(read_only image2d_t visibleStates, read_only image2d_t chunkWinners,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+    global const float* weights,
+    int2 hiddenSize, int2 visibleSize, int2 chunkSize, float2 hiddenToVisible, int radius)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+    int2 fieldUpperBound = visiblePositionCenter + (int2)(radius + 1); // So is included in inBounds
+
+    int2 chunkLowerBound = max(fieldLowerBound, (int2)(0)) / chunkSize;
+    int2 chunkUpperBound = (min(fieldUpperBound, visibleSize) - (int2)(1)) / chunkSize;
+
+    for (int cx = chunkLowerBound.x; cx <= chunkUpperBound.x; cx++)
+        for (int cy = chunkLowerBound.y; cy <= chunkUpperBound.y; cy++) {
+            int2 chunkPosition = (int2)(cx, cy);
+
+            float2 chunkWinnerf = read_imagef(chunkWinners, defaultSampler, chunkPosition).xy;
+
+            int2 visiblePosition = chunkPosition * chunkSize + (int2)(chunkWinnerf.x, chunkWinnerf.y);
+
+            if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound) && inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = weights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
 
                 float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -54,10 +151,100 @@ void kernel plStimulus(read_only image2d_t visibleStates,
     write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
 }
 
+// Quantized (int8, per unit scale) variant of plStimulus, the scale is applied once to the integer weighted sum
+void kernel plStimulusQuantized(read_only image2d_t visibleStates,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+    global const char* quantizedWeights, global const float* scales,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = (float)quantizedWeights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
+
+                float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
+
+                subSum += visibleState * weight;
+				stateSum += visibleState;
+            }
+        }
+
+    float scale = scales[scaleIndex(hiddenPosition, hiddenSize)];
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum * scale / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
+}
+
+// Quantized (int8, per unit scale) variant of plStimulusChunk
+void kernel plStimulusChunkQuantized(read_only image2d_t visibleStates, read_only image2d_t chunkWinners,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+    global const char* quantizedWeights, global const float* scales,
+    int2 hiddenSize, int2 visibleSize, int2 chunkSize, float2 hiddenToVisible, int radius)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+    int2 fieldUpperBound = visiblePositionCenter + (int2)(radius + 1); // So is included in inBounds
+
+    int2 chunkLowerBound = max(fieldLowerBound, (int2)(0)) / chunkSize;
+    int2 chunkUpperBound = (min(fieldUpperBound, visibleSize) - (int2)(1)) / chunkSize;
+
+    for (int cx = chunkLowerBound.x; cx <= chunkUpperBound.x; cx++)
+        for (int cy = chunkLowerBound.y; cy <= chunkUpperBound.y; cy++) {
+            int2 chunkPosition = (int2)(cx, cy);
+
+            float2 chunkWinnerf = read_imagef(chunkWinners, defaultSampler, chunkPosition).xy;
+
+            int2 visiblePosition = chunkPosition * chunkSize + (int2)(chunkWinnerf.x, chunkWinnerf.y);
+
+            if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound) && inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = (float)quantizedWeights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)];
+
+                float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
+
+                subSum += visibleState * weight;
+				stateSum += visibleState;
+            }
+        }
+
+    float scale = scales[scaleIndex(hiddenPosition, hiddenSize)];
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum * scale / fmax(0.0001f, stateSum), 0.0f, 0.0f, 0.0f));
+}
+
 void kernel plLearnPredWeights(read_only image2d_t visibleStatesPrev,
     read_only image2d_t targets, read_only image2d_t hiddenStatesPrev,
-    read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius, float alpha)
+    global float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float alpha)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -66,6 +253,8 @@ void kernel plLearnPredWeights(read_only image2d_t visibleStatesPrev,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
@@ -75,13 +264,15 @@ void kernel plLearnPredWeights(read_only image2d_t visibleStatesPrev,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+                float weightPrev = weights[index];
 
                 float2 visibleStatePrev = read_imagef(visibleStatesPrev, defaultSampler, visiblePosition).xy;
 
                 float weight = weightPrev + alpha * error * visibleStatePrev.x * visibleStatePrev.y;
 
-                write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f, 0.0f));
+                weights[index] = weight;
             }
         }
 }
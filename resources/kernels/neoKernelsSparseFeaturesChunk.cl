@@ -5,27 +5,130 @@
 
 // ----------------------------------------- Sparse Features -----------------------------------------
 
+// Samples are a ring buffer, sample s (0 is newest) is in slice (head + s) % numSamples
 void kernel sfcAddSample(read_only image2d_t visibleStates,
-    read_only image3d_t samplesBack, write_only image3d_t samplesFront,
-    int numSamples)
+    write_only image3d_t samples,
+    int head)
 {
     int2 position = (int2)(get_global_id(0), get_global_id(1));
     
     float visibleState = read_imagef(visibleStates, defaultSampler, position).x;
 
-    for (int s = 1; s < numSamples; s++) {
-        float samplePrev = read_imagef(samplesBack, defaultSampler, (int4)(position.x, position.y, s - 1, 0)).x;
+    write_imagef(samples, (int4)(position.x, position.y, head, 0), (float4)(visibleState, 0.0f, 0.0f, 0.0f));
+}
+
+void kernel sfcStimulus(read_only image3d_t samples,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	global const float* weights,
+	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, int numSamples, int head, uchar ignoreMiddle, uchar halfPrecision)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	int2 chunkPosition = (int2)(hiddenPosition.x / chunkSize.x, hiddenPosition.y / chunkSize.y);
+	float2 chunkCenter = (float2)(chunkPosition.x + 0.5f, chunkPosition.y + 0.5f);
+	
+	int2 visiblePositionCenter = projectf(chunkCenter, chunkToVisible);
 
-        write_imagef(samplesFront, (int4)(position.x, position.y, s, 0), (float4)(samplePrev, 0.0f, 0.0f, 0.0f));
-    }
+	float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
 
-    write_imagef(samplesFront, (int4)(position.x, position.y, 0, 0), (float4)(visibleState, 0.0f, 0.0f, 0.0f));
+    float subSum = 0.0f;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
+	for (int s = 0; s < numSamples; s++) {
+		for (int dx = -radius; dx <= radius; dx++)
+			for (int dy = -radius; dy <= radius; dy++) {
+				int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+				if (ignoreMiddle && dx == 0 && dy == 0)
+					continue;
+				
+				if (inBounds0(visiblePosition, visibleSize)) {
+					int2 offset = visiblePosition - fieldLowerBound;
+	
+					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
+
+					float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
+
+					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (head + s) % numSamples, 0)).x;
+
+					float delta = sample - weight;
+					
+					subSum += -delta * delta;
+				}
+			}
+	}
+		
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum, 0.0f, 0.0f, 0.0f));
 }
 
-void kernel sfcStimulus(read_only image3d_t samples,
+// Local memory tiled variant of sfcStimulus, the work-group shares one load of the sample patch its fields overlap
+void kernel sfcStimulusTiled(read_only image3d_t samples,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	global const float* weights,
+	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, int numSamples, int head, uchar ignoreMiddle, uchar halfPrecision,
+	local float* sampleTile, int2 sampleTileSize)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	int2 chunkPosition = (int2)(hiddenPosition.x / chunkSize.x, hiddenPosition.y / chunkSize.y);
+	float2 chunkCenter = (float2)(chunkPosition.x + 0.5f, chunkPosition.y + 0.5f);
+	
+	int2 visiblePositionCenter = projectf(chunkCenter, chunkToVisible);
+
+	// Sample patch (all samples) shared by the work-group
+	int2 groupStart = groupPosition();
+	float2 groupChunkCenter = (float2)(groupStart.x / chunkSize.x + 0.5f, groupStart.y / chunkSize.y + 0.5f);
+
+	int2 tileOrigin = projectf(groupChunkCenter, chunkToVisible) - (int2)(radius);
+
+	loadTile3D(samples, sampleTile, tileOrigin, sampleTileSize, numSamples);
+
+	if (!inBounds0(hiddenPosition, hiddenSize))
+		return;
+
+	float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
+	for (int s = 0; s < numSamples; s++) {
+		for (int dx = -radius; dx <= radius; dx++)
+			for (int dy = -radius; dy <= radius; dy++) {
+				int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+				if (ignoreMiddle && dx == 0 && dy == 0)
+					continue;
+				
+				if (inBounds0(visiblePosition, visibleSize)) {
+					int2 offset = visiblePosition - fieldLowerBound;
+	
+					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
+
+					float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
+
+					float sample = readTile3D(samples, sampleTile, tileOrigin, sampleTileSize, (int3)(visiblePosition.x, visiblePosition.y, (head + s) % numSamples));
+
+					float delta = sample - weight;
+					
+					subSum += -delta * delta;
+				}
+			}
+	}
+		
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum, 0.0f, 0.0f, 0.0f));
+}
+
+// Quantized (int8, per unit scale) variant of sfcStimulus, used for frozen (inference only) encoders
+void kernel sfcStimulusQuantized(read_only image3d_t samples,
 	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
-	read_only image3d_t weights,
-	int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, int numSamples, uchar ignoreMiddle)
+	global const char* quantizedWeights, global const float* scales,
+	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, int numSamples, int head, uchar ignoreMiddle)
 {
 	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	
@@ -36,10 +139,14 @@ void kernel sfcStimulus(read_only image3d_t samples,
 
 	float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
 
+	float scale = scales[scaleIndex(hiddenPosition, hiddenSize)];
+
     float subSum = 0.0f;
 
 	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
 	for (int s = 0; s < numSamples; s++) {
 		for (int dx = -radius; dx <= radius; dx++)
 			for (int dy = -radius; dy <= radius; dy++) {
@@ -53,9 +160,9 @@ void kernel sfcStimulus(read_only image3d_t samples,
 	
 					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
 
-					float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+					float weight = (float)quantizedWeights[weightIndex(hiddenPosition, wi, hiddenSize, numWeights)] * scale;
 
-					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, s, 0)).x;
+					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (head + s) % numSamples, 0)).x;
 
 					float delta = sample - weight;
 					
@@ -160,38 +267,96 @@ void kernel sfcInhibitOther(read_only image2d_t activations,
 		}
 }
 
+// Work-group per chunk variant of sfcInhibit (parallel argmax), launched with the chunk size as work-group size
+void kernel sfcInhibitGroup(read_only image2d_t activations,
+	write_only image2d_t hiddenStatesFront,
+	write_only image2d_t chunkWinners,
+	int2 hiddenSize, int2 chunkSize,
+	local float* maxValues, local int* maxKeys)
+{
+	int2 chunkPosition = (int2)(get_group_id(0), get_group_id(1));
+	int2 delta = (int2)(get_local_id(0), get_local_id(1));
+
+	int2 hiddenPosition = chunkPosition * chunkSize + delta;
+
+	bool inBounds = inBounds0(hiddenPosition, hiddenSize);
+
+	float activation = inBounds ? read_imagef(activations, defaultSampler, hiddenPosition).x : 0.0f;
+
+	// Keys in the scan order of sfcInhibit (dx major), so ties resolve the same way
+	int maxKey = groupArgmaxSeeded(activation, inBounds, delta.y + delta.x * chunkSize.y, maxValues, maxKeys);
+
+	int2 maxDelta = (int2)(maxKey / chunkSize.y, maxKey % chunkSize.y);
+
+	if (delta.x == 0 && delta.y == 0)
+		write_imagef(chunkWinners, chunkPosition, (float4)((float)maxDelta.x, (float)maxDelta.y, 0.0f, 0.0f));
+
+	if (inBounds)
+		write_imagef(hiddenStatesFront, hiddenPosition, (float4)((delta.x == maxDelta.x && delta.y == maxDelta.y) ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+// Work-group per chunk variant of sfcInhibitOther
+void kernel sfcInhibitOtherGroup(read_only image2d_t activations,
+	write_only image2d_t hiddenStatesFront,
+	int2 hiddenSize, int2 chunkSize,
+	local float* maxValues, local int* maxKeys)
+{
+	int2 chunkPosition = (int2)(get_group_id(0), get_group_id(1));
+	int2 delta = (int2)(get_local_id(0), get_local_id(1));
+
+	int2 hiddenPosition = chunkPosition * chunkSize + delta;
+
+	bool inBounds = inBounds0(hiddenPosition, hiddenSize);
+
+	float activation = inBounds ? read_imagef(activations, defaultSampler, hiddenPosition).x : 0.0f;
+
+	// Keys in the scan order of sfcInhibit (dx major), so ties resolve the same way
+	int maxKey = groupArgmaxSeeded(activation, inBounds, delta.y + delta.x * chunkSize.y, maxValues, maxKeys);
+
+	int2 maxDelta = (int2)(maxKey / chunkSize.y, maxKey % chunkSize.y);
+
+	if (inBounds)
+		write_imagef(hiddenStatesFront, hiddenPosition, (float4)((delta.x == maxDelta.x && delta.y == maxDelta.y) ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+// Launched over 3x3 units per chunk, centered on the chunk winner. All other units have zero strength
 void kernel sfcLearnWeights(read_only image2d_t chunkWinners, read_only image2d_t chunkWinnersPrev,
     read_only image3d_t samples,
-	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, float weightAlpha, int numSamples)
+	global float* weights,
+	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, float weightAlpha, int numSamples, int head, uchar halfPrecision)
 {
-	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
-
-	int2 chunkPosition = (int2)(hiddenPosition.x / chunkSize.x, hiddenPosition.y / chunkSize.y);
-	float2 chunkCenter = (float2)(chunkPosition.x + 0.5f, chunkPosition.y + 0.5f);
-	
-	int2 visiblePositionCenter = projectf(chunkCenter, chunkToVisible);
-	
-	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+	int2 chunkPosition = (int2)(get_global_id(0) / 3, get_global_id(1) / 3);
+	int2 neighborDelta = (int2)(get_global_id(0) % 3 - 1, get_global_id(1) % 3 - 1);
 
 	float2 chunkWinnerf = read_imagef(chunkWinners, defaultSampler, chunkPosition).xy;
 	float2 chunkWinnerPrevf = read_imagef(chunkWinnersPrev, defaultSampler, chunkPosition).xy;
 
+	// Winner unchanged, nothing to learn for the whole chunk
+	if (chunkWinnerf.x == chunkWinnerPrevf.x && chunkWinnerf.y == chunkWinnerPrevf.y)
+		return;
+
 	int2 chunkWinner = (int2)(chunkWinnerf.x, chunkWinnerf.y);
 
-	int2 hiddenStartPosition = chunkPosition * chunkSize;
-	
-	int2 delta = (hiddenStartPosition + chunkWinner) - hiddenPosition;
+	// Neighbors must lie in the same chunk
+	int2 inChunkPosition = chunkWinner + neighborDelta;
 
-	float hiddenState = (delta.x == 0 && delta.y == 0) ? 1.0f : 0.0f;
-	
-	float manhattanDist = abs(delta.x) + abs(delta.y);
+	if (!inBounds0(inChunkPosition, chunkSize))
+		return;
+
+	int2 hiddenPosition = chunkPosition * chunkSize + inChunkPosition;
+
+	if (!inBounds0(hiddenPosition, hiddenSize))
+		return;
+
+	float2 chunkCenter = (float2)(chunkPosition.x + 0.5f, chunkPosition.y + 0.5f);
 	
-	float neighbor = (manhattanDist == 1 || (abs(delta.x) == 1 && abs(delta.y) == 1)) ? 1.0f : 0.0f;
+	int2 visiblePositionCenter = projectf(chunkCenter, chunkToVisible);
 	
-	float strength = (chunkWinnerf.x == chunkWinnerPrevf.x && chunkWinnerf.y == chunkWinnerPrevf.y) ? 0.0f : hiddenState + neighbor;
-	//float strength = hiddenState + neighbor;
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
 
+	// Winner and its neighbors all learn with strength 1
 	for (int s = 0; s < numSamples; s++) {
 		for (int dx = -radius; dx <= radius; dx++)
 			for (int dy = -radius; dy <= radius; dy++) {
@@ -202,15 +367,15 @@ void kernel sfcLearnWeights(read_only image2d_t chunkWinners, read_only image2d_
 
 					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
 
-					float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+					int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+					float weightPrev = loadWeight(weights, index, halfPrecision);
 
-					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, s, 0)).x;
+					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (head + s) % numSamples, 0)).x;
 
 					float delta = sample - weightPrev;
-					
-					float sLearn = strength * delta; 
 
-					write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weightPrev + weightAlpha * sLearn, 0.0f, 0.0f, 0.0f));
+					storeWeight(weights, index, weightPrev + weightAlpha * delta, halfPrecision);
 				}
 			}
 	}
@@ -226,4 +391,96 @@ void kernel sfcDeriveInputs(read_only image2d_t inputs, read_only image2d_t outp
 	float trace = lambda * tracePrev + (1.0f - lambda) * input;
 		
 	write_imagef(outputsFront, position, (float4)(input - tracePrev, trace, 0.0f, 0.0f));
-}
\ No newline at end of file
+}
+// Fused activation path: sfcDeriveInputs + sfcAddSample, and sfcStimulus + sfcActivate + sfcInhibit
+
+void kernel sfcDeriveInputsAddSample(read_only image2d_t inputs, read_only image2d_t outputsBack, write_only image2d_t outputsFront,
+	write_only image3d_t samples,
+	float lambda, int head)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float input = read_imagef(inputs, defaultSampler, position).x;
+
+	float tracePrev = read_imagef(outputsBack, defaultSampler, position).y;
+
+	float trace = lambda * tracePrev + (1.0f - lambda) * input;
+
+	write_imagef(outputsFront, position, (float4)(input - tracePrev, trace, 0.0f, 0.0f));
+
+	write_imagef(samples, (int4)(position.x, position.y, head, 0), (float4)(input - tracePrev, 0.0f, 0.0f, 0.0f));
+}
+
+// One work-group per chunk, one work-item per hidden unit. Chunk winner is found in local memory
+void kernel sfcStimulusInhibit(read_only image3d_t samples,
+	read_only image2d_t hiddenSummationTempBack,
+	global const float* weights,
+	write_only image2d_t hiddenActivationsFront, write_only image2d_t hiddenStatesFront, write_only image2d_t chunkWinners,
+	int2 hiddenSize, int2 visibleSize, float2 chunkToVisible, int2 chunkSize, int radius, int numSamples, int head, uchar ignoreMiddle, uchar accumulate, uchar halfPrecision,
+	local float* activations, local int* indices)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	int2 chunkPosition = (int2)(get_group_id(0), get_group_id(1));
+	float2 chunkCenter = (float2)(chunkPosition.x + 0.5f, chunkPosition.y + 0.5f);
+
+	int2 visiblePositionCenter = projectf(chunkCenter, chunkToVisible);
+
+	int2 localPosition = (int2)(get_local_id(0), get_local_id(1));
+
+	bool inBounds = inBounds0(hiddenPosition, hiddenSize);
+
+	float activation = 0.0f;
+
+	if (inBounds) {
+		float sum = accumulate ? read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x : 0.0f;
+
+		float subSum = 0.0f;
+
+		int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+		int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
+		for (int s = 0; s < numSamples; s++) {
+			for (int dx = -radius; dx <= radius; dx++)
+				for (int dy = -radius; dy <= radius; dy++) {
+					int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+					if (ignoreMiddle && dx == 0 && dy == 0)
+						continue;
+
+					if (inBounds0(visiblePosition, visibleSize)) {
+						int2 offset = visiblePosition - fieldLowerBound;
+
+						int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
+
+						float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
+
+						float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (head + s) % numSamples, 0)).x;
+
+						float delta = sample - weight;
+
+						subSum += -delta * delta;
+					}
+				}
+		}
+
+		activation = sum + subSum;
+
+		write_imagef(hiddenActivationsFront, hiddenPosition, (float4)(activation, 0.0f, 0.0f, 0.0f));
+	}
+
+	// Keys in the scan order of sfcInhibit (dx major)
+	int maxKey = groupArgmaxSeeded(activation, inBounds, localPosition.y + localPosition.x * chunkSize.y, activations, indices);
+
+	int2 maxDelta = (int2)(maxKey / chunkSize.y, maxKey % chunkSize.y);
+
+	if (localPosition.x == 0 && localPosition.y == 0)
+		write_imagef(chunkWinners, chunkPosition, (float4)((float)maxDelta.x, (float)maxDelta.y, 0.0f, 0.0f));
+
+	if (inBounds) {
+		float hiddenState = (localPosition.x == maxDelta.x && localPosition.y == maxDelta.y) ? 1.0f : 0.0f;
+
+		write_imagef(hiddenStatesFront, hiddenPosition, (float4)(hiddenState, 0.0f, 0.0f, 0.0f));
+	}
+}
@@ -9,8 +9,8 @@
 // ----------------------------------------- Delay Encoder -----------------------------------------
 
 void kernel sfdStimulus(read_only image2d_t visibleStates,
-    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
-    int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle)
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float4* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle, uchar halfPrecision)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -23,6 +23,8 @@ void kernel sfdStimulus(read_only image2d_t visibleStates,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             if (ignoreMiddle && dx == 0 && dy == 0)
@@ -35,7 +37,7 @@ void kernel sfdStimulus(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weight = loadWeight4(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision).x;
 
                 float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -47,6 +49,57 @@ void kernel sfdStimulus(read_only image2d_t visibleStates,
     write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum, 0.0f, 0.0f, 0.0f));
 }
 
+// Local memory tiled variant of sfdStimulus, the work-group shares one load of the visible patch its fields overlap
+void kernel sfdStimulusTiled(read_only image2d_t visibleStates,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float4* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle, uchar halfPrecision,
+    local float* visibleTile, int2 visibleTileSize)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    // Visible patch shared by the work-group
+    int2 tileOrigin = project(groupPosition(), hiddenToVisible) - (int2)(radius);
+
+    loadTile(visibleStates, visibleTile, tileOrigin, visibleTileSize);
+
+    if (!inBounds0(hiddenPosition, hiddenSize))
+        return;
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	
+	float stateSum = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            if (ignoreMiddle && dx == 0 && dy == 0)
+                continue;
+
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = loadWeight4(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision).x;
+
+                float visibleState = readTile(visibleStates, visibleTile, tileOrigin, visibleTileSize, visiblePosition);
+
+                subSum += weight * visibleState;
+				stateSum += visibleState * visibleState;
+            }
+        }
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum, 0.0f, 0.0f, 0.0f));
+}
+
 void kernel sfdActivate(read_only image2d_t stimuli, read_only image2d_t hiddenStates, read_only image2d_t biases,
     read_only image2d_t hiddenActivationsBack, write_only image2d_t hiddenActivationsFront)
 {
@@ -99,14 +152,16 @@ void kernel sfdInhibit(read_only image2d_t activations,
 
 void kernel sfdLearnWeights(read_only image2d_t hiddenStates, read_only image2d_t hiddenStatesPrev,
     read_only image2d_t visibleStates, read_only image2d_t visibleStatesPrev,
-    read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius, float activeRatio, float weightAlpha, float lambda, float gamma)
+    global float4* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float activeRatio, float weightAlpha, float lambda, float gamma, uchar halfPrecision)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     float2 hiddenState = read_imagef(hiddenStates, defaultSampler, hiddenPosition).xy;
     float2 hiddenStatePrev = read_imagef(hiddenStatesPrev, defaultSampler, hiddenPosition).xy;
 
@@ -121,7 +176,7 @@ void kernel sfdLearnWeights(read_only image2d_t hiddenStates, read_only image2d_
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weightPrev = loadWeight4(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision).x;
 
                 weightSum += weightPrev * weightPrev;
             }
@@ -138,7 +193,9 @@ void kernel sfdLearnWeights(read_only image2d_t hiddenStates, read_only image2d_
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float3 weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xyz;
+                int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+                float3 weightPrev = loadWeight4(weights, index, halfPrecision).xyz;
 
                 float2 visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).xy;
                 float2 visibleStatePrev = read_imagef(visibleStatesPrev, defaultSampler, visiblePosition).xy;
@@ -148,7 +205,7 @@ void kernel sfdLearnWeights(read_only image2d_t hiddenStates, read_only image2d_
 
                 float learn = traceLong - traceShort;
 
-                write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weightPrev.x * scale + weightAlpha * learn, traceShort, traceLong, 0.0f));
+                storeWeight4(weights, index, (float4)(weightPrev.x * scale + weightAlpha * learn, traceShort, traceLong, 0.0f), halfPrecision);
             }
         }
 }
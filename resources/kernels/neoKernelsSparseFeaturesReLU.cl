@@ -5,27 +5,22 @@
 
 // ----------------------------------------- Sparse Features -----------------------------------------
 
+// Samples are a ring buffer of historySize (numSamples + 1) slices, sample s (0 is newest) is in slice (head + s) % historySize
 void kernel sfrAddSample(read_only image2d_t visibleStates,
-    read_only image3d_t samplesBack, write_only image3d_t samplesFront,
-    int numSamples)
+    write_only image3d_t samples,
+    int head)
 {
     int2 position = (int2)(get_global_id(0), get_global_id(1));
     
     float visibleState = read_imagef(visibleStates, defaultSampler, position).x;
 
-    for (int s = 1; s < numSamples; s++) {
-        float samplePrev = read_imagef(samplesBack, defaultSampler, (int4)(position.x, position.y, s - 1, 0)).x;
-
-        write_imagef(samplesFront, (int4)(position.x, position.y, s, 0), (float4)(samplePrev, 0.0f, 0.0f, 0.0f));
-    }
-
-    write_imagef(samplesFront, (int4)(position.x, position.y, 0, 0), (float4)(visibleState, 0.0f, 0.0f, 0.0f));
+    write_imagef(samples, (int4)(position.x, position.y, head, 0), (float4)(visibleState, 0.0f, 0.0f, 0.0f));
 }
 
 void kernel sfrStimulus(read_only image3d_t samples,
 	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
-	read_only image3d_t weights,
-	int2 visibleSize, float2 hiddenToVisible, int radius, int numSamples, uchar ignoreMiddle)
+	global const float* weights,
+	int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, int numSamples, int head, int historySize, uchar ignoreMiddle, uchar halfPrecision)
 {
 	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	
@@ -37,6 +32,8 @@ void kernel sfrStimulus(read_only image3d_t samples,
 
 	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
 	for (int s = 0; s < numSamples; s++) {
 		for (int dx = -radius; dx <= radius; dx++)
 			for (int dy = -radius; dy <= radius; dy++) {
@@ -50,9 +47,9 @@ void kernel sfrStimulus(read_only image3d_t samples,
 	
 					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
 
-					float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+					float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
 
-					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, s, 0)).x;
+					float sample = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (head + s) % historySize, 0)).x;
 
 					subSum += sample * weight;
 				}
@@ -129,8 +126,8 @@ void kernel sfrInhibitOther(read_only image2d_t activations,
 }
 
 void kernel sfrPredict(read_only image2d_t visibleStates,
-	read_only image3d_t weights, write_only image2d_t predictions,
-	int2 visibleSize, float2 hiddenToVisible, int radius)
+	global const float* weights, write_only image2d_t predictions,
+	int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar halfPrecision)
 {
 	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	
@@ -140,6 +137,8 @@ void kernel sfrPredict(read_only image2d_t visibleStates,
 
 	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+	int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
 	for (int dx = -radius; dx <= radius; dx++)
 		for (int dy = -radius; dy <= radius; dy++) {
 			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
@@ -149,7 +148,7 @@ void kernel sfrPredict(read_only image2d_t visibleStates,
 
 				int wi = offset.y + offset.x * (radius * 2 + 1);
 
-				float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
 
 				float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -163,8 +162,8 @@ void kernel sfrPredict(read_only image2d_t visibleStates,
 void kernel sfrErrorProp(read_only image2d_t visibleStates, read_only image2d_t predictionsPrev,
 	read_only image2d_t hiddenStates,
     read_only image2d_t hiddenErrorSummationTempBack, write_only image2d_t hiddenErrorSummationTempFront, 
-	read_only image3d_t weights,
-    int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+	global const float* weights,
+    int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii, uchar halfPrecision)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -173,6 +172,8 @@ void kernel sfrErrorProp(read_only image2d_t visibleStates, read_only image2d_t
 
 	float subError = 0.0f;
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
         for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
             int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
@@ -193,7 +194,7 @@ void kernel sfrErrorProp(read_only image2d_t visibleStates, read_only image2d_t
 
                     int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                    float weight = read_imagef(weights, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).x;
+                    float weight = loadWeight(weights, weightIndex(visiblePosition, wi, visibleSize, numWeights), halfPrecision);
 
                     subError += weight * (visibleState - predictionPrev);
                 }
@@ -205,9 +206,9 @@ void kernel sfrErrorProp(read_only image2d_t visibleStates, read_only image2d_t
 
 void kernel sfrLearnWeightsHidden(read_only image2d_t hiddenStatesPrev,
 	read_only image2d_t errors,
-    read_only image3d_t samplesPrev,
-	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, int numSamples, float activeRatio)
+    read_only image3d_t samples,
+	global float* weights,
+	int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, int numSamples, int headPrev, int historySize, float activeRatio, uchar halfPrecision)
 {
 	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 
@@ -215,6 +216,8 @@ void kernel sfrLearnWeightsHidden(read_only image2d_t hiddenStatesPrev,
 	
 	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+	int numWeights = numSamples * (radius * 2 + 1) * (radius * 2 + 1);
+
 	float2 hiddenStatePrev = read_imagef(hiddenStatesPrev, defaultSampler, hiddenPosition).xy;
 	
 	float error = (hiddenStatePrev.x == 0.0f ? 0.0f : 1.0f - hiddenStatePrev.x * hiddenStatePrev.x) * (read_imagef(errors, defaultSampler, hiddenPosition).x > 0.0f ? 1.0f : -1.0f);
@@ -229,22 +232,24 @@ void kernel sfrLearnWeightsHidden(read_only image2d_t hiddenStatesPrev,
 
 					int wi = s + numSamples * (offset.y + offset.x * (radius * 2 + 1));
 
-					float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+					int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+					float weightPrev = loadWeight(weights, index, halfPrecision);
 
-					float samplePrev = read_imagef(samplesPrev, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, s, 0)).x;
+					float samplePrev = read_imagef(samples, defaultSampler, (int4)(visiblePosition.x, visiblePosition.y, (headPrev + s) % historySize, 0)).x;
 
 					float sLearn = error * samplePrev; 
 
-					write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weightPrev + weightAlpha * sLearn, 0.0f, 0.0f, 0.0f));
+					storeWeight(weights, index, weightPrev + weightAlpha * sLearn, halfPrecision);
 				}
 			}
 	}
 }
 
 void kernel sfrLearnWeightsVisible(read_only image2d_t visibleStates,
-	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	global float* weights,
 	read_only image2d_t hiddenStates, read_only image2d_t predictionsPrev,
-	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+	int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, uchar halfPrecision)
 {
 	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 	
@@ -252,6 +257,8 @@ void kernel sfrLearnWeightsVisible(read_only image2d_t visibleStates,
 	
 	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+	int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
 	float error = read_imagef(hiddenStates, defaultSampler, hiddenPosition).x - read_imagef(predictionsPrev, defaultSampler, hiddenPosition).x;
 	
 	for (int dx = -radius; dx <= radius; dx++)
@@ -263,13 +270,15 @@ void kernel sfrLearnWeightsVisible(read_only image2d_t visibleStates,
 
 				int wi = offset.y + offset.x * (radius * 2 + 1);
 
-				float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+				float weightPrev = loadWeight(weights, index, halfPrecision);
 
 				float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
 				float weight = weightPrev + weightAlpha * error * visibleState;
 				
-				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f, 0.0f));
+				storeWeight(weights, index, weight, halfPrecision);
 			}
 		}
 }
@@ -9,8 +9,8 @@
 // ----------------------------------------- Delay Encoder -----------------------------------------
 
 void kernel sfsStimulus(read_only image2d_t visibleStates,
-    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
-    int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle)
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle, uchar halfPrecision)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
@@ -22,6 +22,8 @@ void kernel sfsStimulus(read_only image2d_t visibleStates,
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     for (int dx = -radius; dx <= radius; dx++)
         for (int dy = -radius; dy <= radius; dy++) {
             if (ignoreMiddle && dx == 0 && dy == 0)
@@ -34,7 +36,7 @@ void kernel sfsStimulus(read_only image2d_t visibleStates,
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weight = read_imagef(weights, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
 
                 float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 
@@ -46,6 +48,56 @@ void kernel sfsStimulus(read_only image2d_t visibleStates,
     write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(0.0001f, count), 0.0f, 0.0f, 0.0f));
 }
 
+// Local memory tiled variant of sfsStimulus, the work-group shares one load of the visible patch its fields overlap
+void kernel sfsStimulusTiled(read_only image2d_t visibleStates,
+    read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, global const float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle, uchar halfPrecision,
+    local float* visibleTile, int2 visibleTileSize)
+{
+    int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+    int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
+
+    // Visible patch shared by the work-group
+    int2 tileOrigin = project(groupPosition(), hiddenToVisible) - (int2)(radius);
+
+    loadTile(visibleStates, visibleTile, tileOrigin, visibleTileSize);
+
+    if (!inBounds0(hiddenPosition, hiddenSize))
+        return;
+
+    float sum = read_imagef(hiddenSummationTempBack, defaultSampler, hiddenPosition).x;
+
+    float subSum = 0.0f;
+	float count = 0.0f;
+
+    int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
+    for (int dx = -radius; dx <= radius; dx++)
+        for (int dy = -radius; dy <= radius; dy++) {
+            if (ignoreMiddle && dx == 0 && dy == 0)
+                continue;
+
+            int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+            if (inBounds0(visiblePosition, visibleSize)) {
+                int2 offset = visiblePosition - fieldLowerBound;
+
+                int wi = offset.y + offset.x * (radius * 2 + 1);
+
+                float weight = loadWeight(weights, weightIndex(hiddenPosition, wi, hiddenSize, numWeights), halfPrecision);
+
+                float visibleState = readTile(visibleStates, visibleTile, tileOrigin, visibleTileSize, visiblePosition);
+
+                subSum += weight * visibleState;
+				count += weight;
+            }
+        }
+
+    write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum / fmax(0.0001f, count), 0.0f, 0.0f, 0.0f));
+}
+
 void kernel sfsActivate(read_only image2d_t stimuli, read_only image2d_t hiddenStatesPrev, read_only image2d_t biases,
     read_only image2d_t hiddenActivationsBack, write_only image2d_t hiddenActivationsFront, uint2 seed)
 {
@@ -69,32 +121,15 @@ void kernel sfsActivate(read_only image2d_t stimuli, read_only image2d_t hiddenS
 
 void kernel sfsInhibit(read_only image2d_t activations,
     read_only image2d_t hiddenStatesBack, write_only image2d_t hiddenStatesFront,
-    int2 hiddenSize, int radius, float activeRatio, float gamma)
+    int2 hiddenSize, int radius, int stride, float activeRatio, float gamma)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 
     float activation = read_imagef(activations, defaultSampler, hiddenPosition).x;
 
-    float inhibition = 0.0f;
-
-    float count = 0.0f;
-
-    for (int dx = -radius; dx <= radius; dx++)
-        for (int dy = -radius; dy <= radius; dy++) {
-            if (dx == 0 && dy == 0)
-                continue;
-
-            int2 otherPosition = hiddenPosition + (int2)(dx, dy);
-
-            if (inBounds0(otherPosition, hiddenSize)) {
-                float otherActivation = read_imagef(activations, defaultSampler, otherPosition).x;
+    float2 inhibition = sampleInhibition(activations, hiddenPosition, hiddenSize, radius, stride, activation);
 
-                inhibition += otherActivation >= activation ? 1.0f : 0.0f;
-                count += 1.0f;
-            }
-        }
-
-    float state = inhibition < activeRatio * count ? 1.0f : 0.0f;
+    float state = inhibition.x < activeRatio * inhibition.y ? 1.0f : 0.0f;
 
 	float tracePrev = read_imagef(hiddenStatesBack, defaultSampler, hiddenPosition).y;
 	
@@ -103,46 +138,31 @@ void kernel sfsInhibit(read_only image2d_t activations,
 
 void kernel sfsInhibitOther(read_only image2d_t activations,
     write_only image2d_t hiddenStatesFront,
-    int2 hiddenSize, int radius, float activeRatio)
+    int2 hiddenSize, int radius, int stride, float activeRatio)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
 
     float activation = read_imagef(activations, defaultSampler, hiddenPosition).x;
 
-    float inhibition = 0.0f;
-
-    float count = 0.0f;
-
-    for (int dx = -radius; dx <= radius; dx++)
-        for (int dy = -radius; dy <= radius; dy++) {
-            if (dx == 0 && dy == 0)
-                continue;
+    float2 inhibition = sampleInhibition(activations, hiddenPosition, hiddenSize, radius, stride, activation);
 
-            int2 otherPosition = hiddenPosition + (int2)(dx, dy);
-
-            if (inBounds0(otherPosition, hiddenSize)) {
-                float otherActivation = read_imagef(activations, defaultSampler, otherPosition).x;
-
-                inhibition += otherActivation >= activation ? 1.0f : 0.0f;
-                count += 1.0f;
-            }
-        }
-
-    float state = inhibition < activeRatio * count ? 1.0f : 0.0f;
+    float state = inhibition.x < activeRatio * inhibition.y ? 1.0f : 0.0f;
 
     write_imagef(hiddenStatesFront, hiddenPosition, (float4)(state, 0.0f, 0.0f, 0.0f));
 }
 
 void kernel sfsLearnWeights(read_only image2d_t hiddenStates, read_only image2d_t hiddenStatesPrev,
     read_only image2d_t visibleStates, read_only image2d_t visibleStatesPrev,
-    read_only image3d_t weightsBack, write_only image3d_t weightsFront,
-    int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+    global float* weights,
+    int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, uchar halfPrecision)
 {
     int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
     int2 visiblePositionCenter = project(hiddenPosition, hiddenToVisible);
 
     int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
 
+    int numWeights = (radius * 2 + 1) * (radius * 2 + 1);
+
     float hiddenState = read_imagef(hiddenStates, defaultSampler, hiddenPosition).x;
     float hiddenStatePrev = read_imagef(hiddenStatesPrev, defaultSampler, hiddenPosition).x;
 
@@ -155,14 +175,16 @@ void kernel sfsLearnWeights(read_only image2d_t hiddenStates, read_only image2d_
 
                 int wi = offset.y + offset.x * (radius * 2 + 1);
 
-                float weightPrev = read_imagef(weightsBack, defaultSampler, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+                int index = weightIndex(hiddenPosition, wi, hiddenSize, numWeights);
+
+                float weightPrev = loadWeight(weights, index, halfPrecision);
 
                 float visibleState = read_imagef(visibleStates, defaultSampler, visiblePosition).x;
 				float visibleStatePrev = read_imagef(visibleStatesPrev, defaultSampler, visiblePosition).x;
 
                 float learn = hiddenStatePrev * visibleStatePrev * (1.0f - weightPrev) - hiddenStatePrev * visibleState * weightPrev;
 
-                write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(fmin(1.0f, fmax(0.0f, weightPrev + weightAlpha * learn)), 0.0f, 0.0f, 0.0f));
+                storeWeight(weights, index, fmin(1.0f, fmax(0.0f, weightPrev + weightAlpha * learn)), halfPrecision);
             }
         }
 }
@@ -87,6 +87,175 @@ int2 projectf(float2 position, float2 toScalars) {
     return (int2)(position.x * toScalars.x, position.y * toScalars.y);
 }
 
+// Element index into a weight buffer. By default in the same linear order as an image3d of (layerSize.x, layerSize.y, numWeights),
+// with WEIGHTS_UNIT_MAJOR the weights of a unit are contiguous ([y][x][wi])
+int weightIndex(int2 position, int wi, int2 layerSize, int numWeights) {
+#ifdef WEIGHTS_UNIT_MAJOR
+    return wi + numWeights * (position.x + layerSize.x * position.y);
+#else
+    return position.x + layerSize.x * (position.y + layerSize.y * wi);
+#endif
+}
+
+// Weight buffer access, half precision buffers hold fp16 values (vload_half/vstore_half are core, no cl_khr_fp16 needed)
+float loadWeight(global const float* weights, int index, uchar halfPrecision) {
+    return halfPrecision ? vload_half(index, (global const half*)weights) : weights[index];
+}
+
+void storeWeight(global float* weights, int index, float value, uchar halfPrecision) {
+    if (halfPrecision)
+        vstore_half_rte(value, index, (global half*)weights);
+    else
+        weights[index] = value;
+}
+
+// Four channel weights (index counts float4 elements)
+float4 loadWeight4(global const float4* weights, int index, uchar halfPrecision) {
+    return halfPrecision ? vload_half4(index, (global const half*)weights) : weights[index];
+}
+
+void storeWeight4(global float4* weights, int index, float4 value, uchar halfPrecision) {
+    if (halfPrecision)
+        vstore_half4_rte(value, index, (global half*)weights);
+    else
+        weights[index] = value;
+}
+
+// Quantized weights are int8 with one float scale per unit (weight = value * scale)
+int scaleIndex(int2 position, int2 layerSize) {
+    return position.x + layerSize.x * position.y;
+}
+
+// ----------------------------------------- Inhibition -----------------------------------------
+
+// Local inhibition on a strided sample of the neighbourhood within radius (every stride-th unit per axis, stride 1 is exact).
+// The sampling lattice is offset per unit so neighbouring units sample different neighbours, which keeps the error unbiased
+// across the layer. The host clamps stride to at most radius. Units whose lattice has no neighbour in bounds fall back to the
+// exact neighbourhood. Returns (number of sampled neighbours with an activation >= activation, number sampled)
+float2 sampleInhibition(read_only image2d_t activations, int2 hiddenPosition, int2 hiddenSize, int radius, int stride, float activation) {
+    float inhibition = 0.0f;
+    float count = 0.0f;
+
+    int2 strideOffset = (int2)(hiddenPosition.y % stride, hiddenPosition.x % stride);
+
+    for (int pass = 0; pass < 2 && count == 0.0f; pass++) {
+        for (int dx = -radius + strideOffset.x; dx <= radius; dx += stride)
+            for (int dy = -radius + strideOffset.y; dy <= radius; dy += stride) {
+                if (dx == 0 && dy == 0)
+                    continue;
+
+                int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+                if (inBounds0(otherPosition, hiddenSize)) {
+                    float otherActivation = read_imagef(activations, defaultSampler, otherPosition).x;
+
+                    inhibition += otherActivation >= activation ? 1.0f : 0.0f;
+                    count += 1.0f;
+                }
+            }
+
+        // Exact pass, only reached if the strided one sampled nothing
+        stride = 1;
+        strideOffset = (int2)(0);
+    }
+
+    return (float2)(inhibition, count);
+}
+
+// ----------------------------------------- Tiles -----------------------------------------
+
+// Tiled kernels run a work-group over a tile of hidden units, whose receptive fields mostly overlap.
+// The visible patch they read is loaded into local memory once, reads outside the patch fall back to the image.
+
+// First hidden position of the work-group
+int2 groupPosition() {
+    return (int2)(get_group_id(0) * get_local_size(0), get_group_id(1) * get_local_size(1));
+}
+
+// Cooperatively load [tileOrigin, tileOrigin + tileSize) of an image (X field) into local memory, out of bounds reads give 0
+void loadTile(read_only image2d_t values, local float* tile, int2 tileOrigin, int2 tileSize) {
+    int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+    int localCount = get_local_size(0) * get_local_size(1);
+
+    for (int i = localIndex; i < tileSize.x * tileSize.y; i += localCount)
+        tile[i] = read_imagef(values, defaultSampler, tileOrigin + (int2)(i % tileSize.x, i / tileSize.x)).x;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+float readTile(read_only image2d_t values, local const float* tile, int2 tileOrigin, int2 tileSize, int2 position) {
+    int2 offset = position - tileOrigin;
+
+    if (inBounds0(offset, tileSize))
+        return tile[offset.x + tileSize.x * offset.y];
+
+    return read_imagef(values, defaultSampler, position).x;
+}
+
+// Same for all depth slices [0, depth) of a 3D image
+void loadTile3D(read_only image3d_t values, local float* tile, int2 tileOrigin, int2 tileSize, int depth) {
+    int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+    int localCount = get_local_size(0) * get_local_size(1);
+
+    int sliceSize = tileSize.x * tileSize.y;
+
+    for (int i = localIndex; i < sliceSize * depth; i += localCount) {
+        int si = i % sliceSize;
+
+        tile[i] = read_imagef(values, defaultSampler, (int4)(tileOrigin.x + si % tileSize.x, tileOrigin.y + si / tileSize.x, i / sliceSize, 0)).x;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+float readTile3D(read_only image3d_t values, local const float* tile, int2 tileOrigin, int2 tileSize, int3 position) {
+    int2 offset = position.xy - tileOrigin;
+
+    if (inBounds0(offset, tileSize))
+        return tile[offset.x + tileSize.x * (offset.y + tileSize.y * position.z)];
+
+    return read_imagef(values, defaultSampler, (int4)(position, 0)).x;
+}
+
+// ----------------------------------------- Reductions -----------------------------------------
+
+// Work-group argmax. Every work-item offers a value and a key, all receive the key of the maximum
+// (lowest key on ties, same as a serial scan in key order). Scratch holds one element per work-item.
+int groupArgmax(float value, int key, local float* values, local int* keys) {
+    int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+    int localCount = get_local_size(0) * get_local_size(1);
+
+    values[localIndex] = value;
+    keys[localIndex] = key;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = 1; stride < localCount; stride *= 2) {
+        int otherIndex = localIndex + stride;
+
+        if (localIndex % (stride * 2) == 0 && otherIndex < localCount) {
+            float otherValue = values[otherIndex];
+
+            if (otherValue > values[localIndex] || (otherValue == values[localIndex] && keys[otherIndex] < keys[localIndex])) {
+                values[localIndex] = otherValue;
+                keys[localIndex] = keys[otherIndex];
+            }
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    return keys[0];
+}
+
+// groupArgmax seeded like the serial scans (maximum -99999 at key 0). Invalid work-items (e.g. out of bounds) and values
+// not above the seed offer the seed, so the result matches the serial kernels, ties and all-low inputs included
+int groupArgmaxSeeded(float value, bool valid, int key, local float* values, local int* keys) {
+    bool beatsSeed = valid && value > -99999.0f;
+
+    return groupArgmax(beatsSeed ? value : -99999.0f, beatsSeed ? key : 0, values, keys);
+}
+
 // Initialize a random uniform 2D image (X field)
 void kernel randomUniform2D(write_only image2d_t values, uint2 seed, float2 minMax) {
     uint2 seedValue = seed + (uint2)(get_global_id(0) * 29 + 12, get_global_id(1) * 16 + 23) * 36;
@@ -163,3 +332,40 @@ void kernel randomUniform3DXZ(write_only image3d_t values, uint2 seed, float2 mi
 
     write_imagef(values, (int4)(position, 0), (float4)(v.x, 0.0f, v.y, 0.0f));
 }
+
+// Initialize a random uniform weight buffer (X field, remaining channels zeroed)
+void kernel randomUniformWeights(global float* values, uint2 seed, float2 minMax, int channels, uchar halfPrecision) {
+    uint2 seedValue = seed + (uint2)(get_global_id(0) * 12 + 76 + get_global_id(2) * 3, get_global_id(1) * 21 + 42 + get_global_id(2) * 7) * 12;
+
+    int index = weightIndex((int2)(get_global_id(0), get_global_id(1)), get_global_id(2), (int2)(get_global_size(0), get_global_size(1)), get_global_size(2)) * channels;
+
+    storeWeight(values, index, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, halfPrecision);
+
+    for (int c = 1; c < channels; c++)
+        storeWeight(values, index + c, 0.0f, halfPrecision);
+}
+
+// Symmetric per unit int8 quantization of a weight buffer (X field), launched over the units
+void kernel quantizeWeights(global const float* weights, global char* quantizedWeights, global float* scales,
+    int numWeights, int channels, uchar halfPrecision)
+{
+    int2 position = (int2)(get_global_id(0), get_global_id(1));
+    int2 layerSize = (int2)(get_global_size(0), get_global_size(1));
+
+    float maxWeight = 0.0f;
+
+    for (int wi = 0; wi < numWeights; wi++)
+        maxWeight = fmax(maxWeight, fabs(loadWeight(weights, weightIndex(position, wi, layerSize, numWeights) * channels, halfPrecision)));
+
+    float scale = maxWeight / 127.0f;
+
+    scales[scaleIndex(position, layerSize)] = scale;
+
+    float invScale = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+    for (int wi = 0; wi < numWeights; wi++) {
+        int index = weightIndex(position, wi, layerSize, numWeights);
+
+        quantizedWeights[index] = convert_char_sat_rte(loadWeight(weights, index * channels, halfPrecision) * invScale);
+    }
+}
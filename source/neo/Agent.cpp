@@ -9,47 +9,232 @@
 #include "Agent.h"
 
 #include <assert.h>
+#include <cstring>
 
 using namespace ogmaneo;
 
 void Agent::simStep(float reward, std::vector<ValueField2D> &inputs, bool learn) {
-    // Write input
-    for (int i = 0; i < _inputImages.size(); i++)
-        _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, inputs[i].getData().data());
+    simStepWait();
+
+    writeInputs(inputs);
 
     _as.simStep(*_resources->_cs, reward, _inputImages, _inputImages, _rng, learn);
 
-    // Get actions
-    for (int i = 0; i < _actions.size(); i++)
-        _resources->_cs->getQueue().enqueueReadImage(_as.getAction(i), CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(_actions[i].getSize().x), static_cast<cl::size_type>(_actions[i].getSize().y), 1 }, 0, 0, _actions[i].getData().data());
+    readActions();
 }
 
 void Agent::simStep(float reward, std::vector<ValueField2D> &inputs, std::vector<ValueField2D> &corruptedInputs, bool learn) {
-    // Write input
-    for (int i = 0; i < _inputImages.size(); i++)
-        _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, inputs[i].getData().data());
+    simStepWait();
+
+    writeInputs(inputs);
 
     for (int i = 0; i < _inputImages.size(); i++)
         _resources->_cs->getQueue().enqueueWriteImage(_corruptedInputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(corruptedInputs[i].getSize().x), static_cast<cl::size_type>(corruptedInputs[i].getSize().y), 1 }, 0, 0, corruptedInputs[i].getData().data());
 
     _as.simStep(*_resources->_cs, reward, _inputImages, _corruptedInputImages, _rng, learn);
 
-    // Get actions
-    for (int i = 0; i < _actions.size(); i++)
-        _resources->_cs->getQueue().enqueueReadImage(_as.getAction(i), CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(_actions[i].getSize().x), static_cast<cl::size_type>(_actions[i].getSize().y), 1 }, 0, 0, _actions[i].getData().data());
+    readActions();
+}
+
+void Agent::writeInputs(const std::vector<ValueField2D> &inputs) {
+    for (int i = 0; i < _inputImages.size(); i++) {
+        cl_int2 size = { inputs[i].getSize().x, inputs[i].getSize().y };
+
+        if (_zeroCopy) {
+            // Images alias the (host owned) input fields, only copy if given other fields
+            if (&inputs[i] != &_inputFields[i])
+                std::memcpy(_inputFields[i].getData().data(), inputs[i].getData().data(), inputs[i].getData().size() * sizeof(float));
+        }
+        else
+            _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 }, 0, 0, inputs[i].getData().data());
+    }
+
+    // Hand the input fields to the device for the step
+    if (_zeroCopy)
+        unmapInputImages();
+}
+
+void Agent::readActions(bool toStaging, cl_bool blocking) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    // The copies below write the action images, the device has to own them first
+    if (_zeroCopy)
+        unmapActionImages();
+
+    for (int i = 0; i < _actions.size(); i++) {
+        cl::array<cl::size_type, 3> region = { static_cast<cl::size_type>(_actions[i].getSize().x), static_cast<cl::size_type>(_actions[i].getSize().y), 1 };
+
+        if (_zeroCopy)
+            cs.getQueue().enqueueCopyImage(_as.getAction(i), _actionImages[i], { 0, 0, 0 }, { 0, 0, 0 }, region);
+        else
+            cs.getQueue().enqueueReadImage(_as.getAction(i), blocking, { 0, 0, 0 }, region, 0, 0,
+                toStaging ? _actionStaging[i]._ptr : _actions[i].getData().data());
+    }
+
+    // Back to the host once the step is done (mapped before any marker the caller adds)
+    if (_zeroCopy)
+        mapHostImages(CL_MAP_WRITE_INVALIDATE_REGION, blocking);
+}
+
+void Agent::mapHostImages(cl_map_flags inputFlags, cl_bool blocking) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    for (int i = 0; i < _inputImages.size(); i++) {
+        if (_inputMaps[i] == nullptr)
+            _inputMaps[i] = mapHostImage2D(cs, _inputImages[i], { _inputFields[i].getSize().x, _inputFields[i].getSize().y }, inputFlags, blocking);
+    }
+
+    // Also writable, load overwrites the actions on the host
+    for (int i = 0; i < _actionImages.size(); i++) {
+        if (_actionMaps[i] == nullptr)
+            _actionMaps[i] = mapHostImage2D(cs, _actionImages[i], { _actions[i].getSize().x, _actions[i].getSize().y }, CL_MAP_READ | CL_MAP_WRITE, blocking);
+    }
+}
+
+void Agent::unmapInputImages() {
+    for (int i = 0; i < _inputImages.size(); i++) {
+        if (_inputMaps[i] != nullptr) {
+            unmapHostImage2D(*_resources->_cs, _inputImages[i], _inputMaps[i]);
+
+            _inputMaps[i] = nullptr;
+        }
+    }
+}
+
+void Agent::unmapActionImages() {
+    for (int i = 0; i < _actionImages.size(); i++) {
+        if (_actionMaps[i] != nullptr) {
+            unmapHostImage2D(*_resources->_cs, _actionImages[i], _actionMaps[i]);
+
+            _actionMaps[i] = nullptr;
+        }
+    }
+}
+
+bool Agent::setZeroCopy(bool zeroCopy) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    if (zeroCopy == _zeroCopy || (zeroCopy && !hasHostUnifiedMemory(cs)))
+        return _zeroCopy;
+
+    simStepWait();
+
+    if (zeroCopy) {
+        _inputFields.resize(_inputImages.size());
+
+        for (int i = 0; i < _inputImages.size(); i++) {
+            cl_int2 size = { static_cast<cl_int>(_inputImages[i].getImageInfo<CL_IMAGE_WIDTH>()), static_cast<cl_int>(_inputImages[i].getImageInfo<CL_IMAGE_HEIGHT>()) };
+
+            _inputFields[i].create(Vec2i(size.x, size.y));
+
+            _inputImages[i] = createHostImage2D(cs, size, _inputFields[i].getData().data());
+        }
+
+        _actionImages.resize(_actions.size());
+
+        for (int i = 0; i < _actions.size(); i++)
+            _actionImages[i] = createHostImage2D(cs, { _actions[i].getSize().x, _actions[i].getSize().y }, _actions[i].getData().data());
+
+        _inputMaps.assign(_inputImages.size(), nullptr);
+        _actionMaps.assign(_actionImages.size(), nullptr);
+
+        // The host owns them until the next step
+        mapHostImages(CL_MAP_WRITE_INVALIDATE_REGION, CL_TRUE);
+    }
+    else {
+        unmapInputImages();
+        unmapActionImages();
+
+        // The host memory is released below
+        cs.getPrimaryQueue().finish();
+
+        for (int i = 0; i < _inputImages.size(); i++)
+            _inputImages[i] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _inputFields[i].getSize().x, _inputFields[i].getSize().y);
+
+        _inputFields.clear();
+        _actionImages.clear();
+        _inputMaps.clear();
+        _actionMaps.clear();
+    }
+
+    _zeroCopy = zeroCopy;
+
+    return _zeroCopy;
+}
+
+cl::Event Agent::simStepAsync(float reward, const std::vector<ValueField2D> &inputs, bool learn) {
+    // Only one step in flight, so staging can be reused
+    simStepWait();
+
+    ComputeSystem &cs = *_resources->_cs;
+
+    if (_inputStaging.empty() && !_zeroCopy) {
+        for (int i = 0; i < _inputImages.size(); i++)
+            _inputStaging.push_back(createPinnedHostBuffer(cs, inputs[i].getData().size() * sizeof(float)));
+
+        for (int i = 0; i < _actions.size(); i++)
+            _actionStaging.push_back(createPinnedHostBuffer(cs, _actions[i].getData().size() * sizeof(float)));
+    }
+
+    // Write input
+    if (_zeroCopy)
+        writeInputs(inputs);
+    else {
+        for (int i = 0; i < _inputImages.size(); i++) {
+            std::memcpy(_inputStaging[i]._ptr, inputs[i].getData().data(), _inputStaging[i]._size);
+
+            cs.getQueue().enqueueWriteImage(_inputImages[i], CL_FALSE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, _inputStaging[i]._ptr);
+        }
+    }
+
+    _as.simStep(cs, reward, _inputImages, _inputImages, _rng, learn);
+
+    // Zero-copy actions are mapped back before the marker, so the host owns them again after simStepWait
+    readActions(true, CL_FALSE);
+
+    cs.getQueue().enqueueMarkerWithWaitList(nullptr, &_stepEvent);
+    cs.getQueue().flush();
+
+    _stepPending = true;
+
+    return _stepEvent;
+}
+
+void Agent::simStepWait() {
+    if (!_stepPending)
+        return;
+
+    _stepEvent.wait();
+
+    // Zero-copy actions are already in place
+    if (!_zeroCopy) {
+        for (int i = 0; i < _actions.size(); i++)
+            std::memcpy(_actions[i].getData().data(), _actionStaging[i]._ptr, _actionStaging[i]._size);
+    }
+
+    _stepPending = false;
 }
 
 void Agent::load(const schemas::Agent* fbAgent, ComputeSystem &cs) {
     assert(_inputImages.size() == fbAgent->_inputImages()->Length());
-    assert(_corruptedInputImages.size() == fbAgent->_corruptedInputImages()->Length());
+    // Compact checkpoints leave the corrupted inputs out
+    assert(fbAgent->_corruptedInputImages()->Length() == 0 || _corruptedInputImages.size() == fbAgent->_corruptedInputImages()->Length());
     assert(_actions.size() == fbAgent->_actions()->Length());
 
     _as.load(fbAgent->_as(), cs);
 
+    // Input images are written through the device
+    if (_zeroCopy)
+        unmapInputImages();
+
     for (flatbuffers::uoffset_t i = 0; i < fbAgent->_inputImages()->Length(); i++) {
         ogmaneo::load(_inputImages[i], fbAgent->_inputImages()->Get(i), cs);
     }
 
+    // Keeping the loaded contents
+    if (_zeroCopy)
+        mapHostImages(CL_MAP_WRITE, CL_TRUE);
+
     for (flatbuffers::uoffset_t i = 0; i < fbAgent->_corruptedInputImages()->Length(); i++) {
         ogmaneo::load(_corruptedInputImages[i], fbAgent->_corruptedInputImages()->Get(i), cs);
     }
@@ -60,16 +245,26 @@ void Agent::load(const schemas::Agent* fbAgent, ComputeSystem &cs) {
 }
 
 flatbuffers::Offset<schemas::Agent> Agent::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    // Input images are read through the device
+    if (_zeroCopy)
+        unmapInputImages();
+
     std::vector<flatbuffers::Offset<schemas::Image2D>> inputImages;
-    for (cl::Image2D image : _inputImages)
+    for (cl::Image2D &image : _inputImages)
         inputImages.push_back(ogmaneo::save(image, builder, cs));
 
+    if (_zeroCopy)
+        mapHostImages(CL_MAP_WRITE, CL_TRUE);
+
+    // Corrupted inputs are written every step they are used, compact checkpoints leave them out
     std::vector<flatbuffers::Offset<schemas::Image2D>> corruptedInputImages;
-    for (cl::Image2D image : _corruptedInputImages)
-        corruptedInputImages.push_back(ogmaneo::save(image, builder, cs));
+    if (cs.getCheckpointProfile() != ComputeSystem::_compact) {
+        for (cl::Image2D &image : _corruptedInputImages)
+            corruptedInputImages.push_back(ogmaneo::save(image, builder, cs));
+    }
 
     std::vector<flatbuffers::Offset<schemas::ValueField2D>> actions;
-    for (ValueField2D values : _actions)
+    for (ValueField2D &values : _actions)
         actions.push_back(values.save(builder, cs));
 
     return schemas::CreateAgent(builder,
@@ -80,22 +275,20 @@ flatbuffers::Offset<schemas::Agent> Agent::save(flatbuffers::FlatBufferBuilder &
 }
 
 void Agent::load(ComputeSystem &cs, const std::string &fileName) {
-    FILE* file = fopen(fileName.c_str(), "rb");
-    fseek(file, 0L, SEEK_END);
-    size_t length = ftell(file);
-    fseek(file, 0L, SEEK_SET);
-    std::vector<uint8_t> data(length);
-    fread(data.data(), sizeof(uint8_t), length, file);
-    fclose(file);
+    // Device uploads read straight from the mapping
+    MappedFile file;
 
-    flatbuffers::Verifier verifier = flatbuffers::Verifier(data.data(), length);
+    if (!file.open(fileName))
+        return;
+
+    flatbuffers::Verifier verifier = flatbuffers::Verifier(file.getData(), file.getSize());
 
     bool verified =
         schemas::VerifyAgentBuffer(verifier) |
-        schemas::AgentBufferHasIdentifier(data.data());
+        schemas::AgentBufferHasIdentifier(file.getData());
 
     if (verified) {
-        const schemas::Agent* agent = schemas::GetAgent(data.data());
+        const schemas::Agent* agent = schemas::GetAgent(file.getData());
 
         load(agent, cs);
     }
@@ -104,7 +297,9 @@ void Agent::load(ComputeSystem &cs, const std::string &fileName) {
 }
 
 void Agent::save(ComputeSystem &cs, const std::string &fileName) {
-    flatbuffers::FlatBufferBuilder builder;
+    CheckpointAllocator allocator;
+
+    flatbuffers::FlatBufferBuilder builder(1024, &allocator);
 
     flatbuffers::Offset<schemas::Agent> agent = save(builder, cs);
 
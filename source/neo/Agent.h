@@ -38,6 +38,49 @@ namespace ogmaneo {
 
         std::vector<std::shared_ptr<ComputeProgram>> _programs;
 
+        //!@{
+        /*!
+        \brief Asynchronous step state, staging is created on first use
+        */
+        std::vector<PinnedHostBuffer> _inputStaging;
+        std::vector<PinnedHostBuffer> _actionStaging;
+        cl::Event _stepEvent;
+        bool _stepPending;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Zero-copy state, input and action images alias host memory
+        The host owns (has mapped) the input fields and actions between steps, the device owns them during a step.
+        Map pointers are nullptr while the device owns an image.
+        */
+        bool _zeroCopy;
+        std::vector<ValueField2D> _inputFields;
+        std::vector<cl::Image2D> _actionImages;
+        std::vector<void*> _inputMaps;
+        std::vector<void*> _actionMaps;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Step helpers
+        readActions reads the actions into _actions or the pinned staging buffers.
+        Non-blocking reads are complete once a marker enqueued afterwards is.
+        */
+        void writeInputs(const std::vector<ValueField2D> &inputs);
+        void readActions(bool toStaging = false, cl_bool blocking = CL_TRUE);
+        //!@}
+
+        //!@{
+        /*!
+        \brief Zero-copy ownership transfers
+        mapHostImages maps all device owned input (with inputFlags) and action images back to the host.
+        */
+        void mapHostImages(cl_map_flags inputFlags, cl_bool blocking);
+        void unmapInputImages();
+        void unmapActionImages();
+        //!@}
+
         //!@{
         /*!
         \brief Serialization
@@ -47,12 +90,44 @@ namespace ogmaneo {
         //!@}
 
     public:
+        Agent()
+            : _stepPending(false), _zeroCopy(false)
+        {}
+
         /*!
         \brief Run a single simulation tick
         */
         void simStep(float reward, std::vector<ValueField2D> &inputs, bool learn = true);
         void simStep(float reward, std::vector<ValueField2D> &inputs, std::vector<ValueField2D> &corruptedInputs, bool learn = true);
 
+        /*!
+        \brief Start a simulation tick without waiting for it
+        Inputs are copied to pinned staging memory, so they may be modified as soon as this returns.
+        Actions are only updated by simStepWait. The returned event completes when the step (including readback) is done.
+        In zero-copy mode the inputs are copied to the input fields instead, which (like the actions) belong to the device until simStepWait.
+        */
+        cl::Event simStepAsync(float reward, const std::vector<ValueField2D> &inputs, bool learn = true);
+
+        /*!
+        \brief Wait for the step started by simStepAsync and update the actions, no-op if none is pending
+        */
+        void simStepWait();
+
+        /*!
+        \brief Back the input images and actions with host memory (CL_MEM_USE_HOST_PTR)
+        Only enabled on devices with host-unified memory, returns whether zero-copy is active.
+        Pass getInputFields() to simStep so inputs are not copied at all. Their previous contents are not kept
+        across steps (the host maps them with CL_MAP_WRITE_INVALIDATE_REGION), so every value has to be written before each step.
+        */
+        bool setZeroCopy(bool zeroCopy);
+
+        /*!
+        \brief Get the host input fields used in zero-copy mode
+        */
+        std::vector<ValueField2D> &getInputFields() {
+            return _inputFields;
+        }
+
         /*!
         \brief Get the action vector
         */
@@ -31,7 +31,7 @@ void AgentLayer::createRandom(ComputeSystem &cs, ComputeProgram &program,
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(program.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -58,9 +58,9 @@ void AgentLayer::createRandom(ComputeSystem &cs, ComputeProgram &program,
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._qWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT);
+            vl._qWeights = createWeightBuffer(cs, weightsSize, 2);
 
-            randomUniform(vl._qWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._qWeights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
@@ -88,9 +88,11 @@ void AgentLayer::createRandom(ComputeSystem &cs, ComputeProgram &program,
     // Create kernels
     _deriveInputsKernel = cl::Kernel(program.getProgram(), "alDeriveInputs");
     _activateKernel = cl::Kernel(program.getProgram(), "alActivate");
+    _activateTiledKernel = cl::Kernel(program.getProgram(), "alActivateTiled");
     _learnQKernel = cl::Kernel(program.getProgram(), "alLearnQ");
     _actionToOneHotKernel = cl::Kernel(program.getProgram(), "alActionToOneHot");
     _getActionKernel = cl::Kernel(program.getProgram(), "alGetAction");
+    _getActionGroupKernel = cl::Kernel(program.getProgram(), "alGetActionGroup");
     _setActionKernel = cl::Kernel(program.getProgram(), "alSetAction");
     _spreadKernel = cl::Kernel(program.getProgram(), "alSpread");
 }
@@ -121,17 +123,25 @@ void AgentLayer::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
         }
 
         {
-            int argIndex = 0;
+            LocalTile tile = getLocalTile(cs, _activateTiledKernel, vl._hiddenToVisible, vld._radius);
+
+            cl::Kernel &activateKernel = tile._enabled ? _activateTiledKernel : _activateKernel;
 
-            _activateKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _activateKernel.setArg(argIndex++, vl._qWeights[_back]);
-            _activateKernel.setArg(argIndex++, _hiddenSummationTempQ[_back]);
-            _activateKernel.setArg(argIndex++, _hiddenSummationTempQ[_front]);
-            _activateKernel.setArg(argIndex++, vld._size);
-            _activateKernel.setArg(argIndex++, vl._hiddenToVisible);
-            _activateKernel.setArg(argIndex++, vld._radius);
+            int argIndex = 0;
 
-            cs.getQueue().enqueueNDRangeKernel(_activateKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            activateKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            activateKernel.setArg(argIndex++, vl._qWeights._buffer);
+            activateKernel.setArg(argIndex++, _hiddenSummationTempQ[_back]);
+            activateKernel.setArg(argIndex++, _hiddenSummationTempQ[_front]);
+            activateKernel.setArg(argIndex++, _hiddenSize);
+            activateKernel.setArg(argIndex++, vld._size);
+            activateKernel.setArg(argIndex++, vl._hiddenToVisible);
+            activateKernel.setArg(argIndex++, vld._radius);
+
+            if (tile._enabled)
+                enqueueTiled(cs, activateKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(activateKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -147,16 +157,23 @@ void AgentLayer::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
 
         cl_uint2 seed = { static_cast<cl_uint>(seedDist(rng)), static_cast<cl_uint>(seedDist(rng)) };
 
+        bool group = useGroupReduction(cs, _getActionGroupKernel, _actionTileSize);
+
+        cl::Kernel &getActionKernel = group ? _getActionGroupKernel : _getActionKernel;
+
         int argIndex = 0;
 
-        _getActionKernel.setArg(argIndex++, _qStates[_front]);
-        _getActionKernel.setArg(argIndex++, _actionTaken[_front]);
-        _getActionKernel.setArg(argIndex++, _actionTakenMax[_front]);
-        _getActionKernel.setArg(argIndex++, _actionTileSize);
-        _getActionKernel.setArg(argIndex++, epsilon);
-        _getActionKernel.setArg(argIndex++, seed);
+        getActionKernel.setArg(argIndex++, _qStates[_front]);
+        getActionKernel.setArg(argIndex++, _actionTaken[_front]);
+        getActionKernel.setArg(argIndex++, _actionTakenMax[_front]);
+        getActionKernel.setArg(argIndex++, _actionTileSize);
+        getActionKernel.setArg(argIndex++, epsilon);
+        getActionKernel.setArg(argIndex++, seed);
 
-        cs.getQueue().enqueueNDRangeKernel(_getActionKernel, cl::NullRange, cl::NDRange(_numActionTiles.x, _numActionTiles.y));
+        if (group)
+            enqueueGroupReduction(cs, getActionKernel, argIndex, _actionTileSize, _numActionTiles);
+        else
+            cs.getQueue().enqueueNDRangeKernel(getActionKernel, cl::NullRange, cl::NDRange(_numActionTiles.x, _numActionTiles.y));
 
         std::swap(_actionTaken[_front], _actionTaken[_back]);
         std::swap(_actionTakenMax[_front], _actionTakenMax[_back]);
@@ -215,8 +232,8 @@ void AgentLayer::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
                 _learnQKernel.setArg(argIndex++, vl._derivedInput[_front]);
                 _learnQKernel.setArg(argIndex++, _spreadStates[_back]);
                 _learnQKernel.setArg(argIndex++, _tdError);
-                _learnQKernel.setArg(argIndex++, vl._qWeights[_back]);
-                _learnQKernel.setArg(argIndex++, vl._qWeights[_front]);
+                _learnQKernel.setArg(argIndex++, vl._qWeights._buffer);
+                _learnQKernel.setArg(argIndex++, _hiddenSize);
                 _learnQKernel.setArg(argIndex++, vld._size);
                 _learnQKernel.setArg(argIndex++, vl._hiddenToVisible);
                 _learnQKernel.setArg(argIndex++, vld._radius);
@@ -227,8 +244,6 @@ void AgentLayer::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
                 cs.getQueue().enqueueNDRangeKernel(_learnQKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
             }
 
-            std::swap(vl._qWeights[_front], vl._qWeights[_back]);
-
             std::swap(vl._derivedInput[_front], vl._derivedInput[_back]);
         }
     }
@@ -304,11 +319,11 @@ flatbuffers::Offset<schemas::AgentLayer> AgentLayer::save(flatbuffers::FlatBuffe
     schemas::int2 hiddenSize(_hiddenSize.x, _hiddenSize.y);
 
     std::vector<schemas::VisibleAgentLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder));
 
     std::vector<flatbuffers::Offset<schemas::VisibleAgentLayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     return schemas::CreateAgentLayer(builder,
@@ -318,7 +333,7 @@ flatbuffers::Offset<schemas::AgentLayer> AgentLayer::save(flatbuffers::FlatBuffe
         ogmaneo::save(_actionTakenMax, builder, cs),
         ogmaneo::save(_oneHotAction, builder, cs),
         ogmaneo::save(_tdError, builder, cs),
-        ogmaneo::save(_hiddenSummationTempQ, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTempQ, builder, cs),
         builder.CreateVectorOfStructs(visibleLayerDescs),
         builder.CreateVector(visibleLayers));
 }
\ No newline at end of file
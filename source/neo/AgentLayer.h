@@ -65,7 +65,7 @@ namespace ogmaneo {
             */
             DoubleBuffer2D _derivedInput;
 
-            DoubleBuffer3D _qWeights;
+            WeightBuffer _qWeights;
 
             cl_float2 _hiddenToVisible;
             cl_float2 _visibleToHidden;
@@ -131,9 +131,11 @@ namespace ogmaneo {
         */
         cl::Kernel _deriveInputsKernel;
         cl::Kernel _activateKernel;
+        cl::Kernel _activateTiledKernel;
         cl::Kernel _learnQKernel;
         cl::Kernel _actionToOneHotKernel;
         cl::Kernel _getActionKernel;
+        cl::Kernel _getActionGroupKernel;
         cl::Kernel _setActionKernel;
         cl::Kernel _spreadKernel;
         //!@}
@@ -81,7 +81,12 @@ void AgentSwarm::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
         if (_p.getHierarchy().getLayer(l)._tpReset || _p.getHierarchy().getLayer(l)._tpNextReset || (l < _aLayers.size() - 1 && (_p.getHierarchy().getLayer(l + 1)._tpReset || _p.getHierarchy().getLayer(l + 1)._tpNextReset))) {
             float totalReward = _rewardSums[l] / _rewardCounts[l];
 
+            // Layers within a level are independent of each other
+            cs.fork();
+
             for (int i = 0; i < _aLayers[l].size(); i++) {
+                cs.selectQueue(i);
+
                 cl::Image2D layerInput = (l == _aLayers.size() - 1) ? _p.getHierarchy().getLayer(l)._sf->getHiddenStates()[_back] : _aLayers[l + 1].front().getSpreadStates();
 
                 if (l == 0)
@@ -90,6 +95,8 @@ void AgentSwarm::simStep(ComputeSystem &cs, float reward, const std::vector<cl::
                     _aLayers[l][i].simStep(cs, totalReward, std::vector<cl::Image2D>(1, layerInput), _p.getHierarchy().getLayer(l - 1)._sf->getHiddenStates()[_back], _aLayerDescs[l][i]._qGamma, _aLayerDescs[l][i]._qLambda, _aLayerDescs[l][i]._epsilon, _aLayerDescs[l][i]._chunkGamma, _aLayerDescs[l][i]._chunkSize, rng, learn);
             }
 
+            cs.join();
+
             _rewardSums[l] = 0.0f;
             _rewardCounts[l] = 0.0f;
         }
@@ -155,18 +162,18 @@ void AgentSwarm::load(const schemas::AgentSwarm* fbAgentSwarm, ComputeSystem &cs
 
 flatbuffers::Offset<schemas::AgentSwarm> AgentSwarm::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
     std::vector<flatbuffers::Offset<schemas::AgentSwarmLayerDescs>> aLayerDescs;
-    for (std::vector<AgentLayerDesc> layerDescs : _aLayerDescs) {
+    for (std::vector<AgentLayerDesc> &layerDescs : _aLayerDescs) {
         std::vector<flatbuffers::Offset<schemas::AgentSwarmLayerDesc>> aLayerDesc;
-        for (AgentLayerDesc layerDesc : layerDescs)
+        for (AgentLayerDesc &layerDesc : layerDescs)
             aLayerDesc.push_back(layerDesc.save(builder));
 
         aLayerDescs.push_back(schemas::CreateAgentSwarmLayerDescs(builder, builder.CreateVector(aLayerDesc)));
     }
 
     std::vector<flatbuffers::Offset<schemas::AgentSwarmLayers>> aLayers;
-    for (std::vector<AgentLayer> layers : _aLayers) {
+    for (std::vector<AgentLayer> &layers : _aLayers) {
         std::vector<flatbuffers::Offset<schemas::AgentLayer>> aLayer;
-        for (AgentLayer layer : layers)
+        for (AgentLayer &layer : layers)
             aLayer.push_back(layer.save(builder, cs));
 
         aLayers.push_back(schemas::CreateAgentSwarmLayers(builder, builder.CreateVector(aLayer)));
@@ -176,7 +183,7 @@ flatbuffers::Offset<schemas::AgentSwarm> AgentSwarm::save(flatbuffers::FlatBuffe
     flatbuffers::Offset<flatbuffers::Vector<float>> rewardCounts = builder.CreateVector(_rewardCounts.data(), _rewardCounts.size());
 
     std::vector<flatbuffers::Offset<schemas::Image2D>> ones;
-    for (cl::Image2D image : _ones)
+    for (cl::Image2D &image : _ones)
         ones.push_back(ogmaneo::save(image, builder, cs));
 
     return schemas::CreateAgentSwarm(builder,
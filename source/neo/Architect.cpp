@@ -25,6 +25,10 @@ const std::string ogmaneo::ParameterModifier::_boolTrue = "true";
 const std::string ogmaneo::ParameterModifier::_boolFalse = "false";
 
 void Architect::initialize(unsigned int seed, const std::shared_ptr<Resources> &resources) {
+    // Every generated layer holds OpenCL images and kernels
+    if (resources->getComputeSystem()->isNative())
+        throw std::invalid_argument("Architect requires an OpenCL ComputeSystem, _native only runs the native layers (e.g. NativePredictorLayer)");
+
     _rng.seed(seed);
 
     _resources = resources;
@@ -77,6 +81,9 @@ std::shared_ptr<class Hierarchy> Architect::generateHierarchy(std::unordered_map
     h->_rng = _rng;
     h->_resources = _resources;
 
+    // Compile in the background while host side setup continues
+    std::vector<std::pair<std::string, std::future<bool>>> programBuilds = loadPrograms(false);
+
     h->_inputImages.resize(_inputLayers.size());
     h->_corruptedInputImages.resize(_inputLayers.size());
 
@@ -102,23 +109,8 @@ std::shared_ptr<class Hierarchy> Architect::generateHierarchy(std::unordered_map
         //}
     }
 
-    std::shared_ptr<ComputeProgram> hProg;
-
-    if (_resources->_programs.find("hierarchy") == _resources->_programs.end()) {
-        hProg = std::make_shared<ComputeProgram>();
-        hProg->loadHierarchyKernel(*_resources->_cs);
-    }
-    else
-        hProg = _resources->_programs["hierarchy"];
-
-    std::shared_ptr<ComputeProgram> pProg;
-
-    if (_resources->_programs.find("predictor") == _resources->_programs.end()) {
-        pProg = std::make_shared<ComputeProgram>();
-        pProg->loadPredictorKernel(*_resources->_cs);
-    }
-    else
-        pProg = _resources->_programs["predictor"];
+    std::shared_ptr<ComputeProgram> hProg = _resources->_programs["hierarchy"];
+    std::shared_ptr<ComputeProgram> pProg = _resources->_programs["predictor"];
 
     std::vector<Predictor::PredLayerDesc> pLayerDescs(_higherLayers.size());
     std::vector<FeatureHierarchy::LayerDesc> hLayerDescs(_higherLayers.size());
@@ -146,6 +138,9 @@ std::shared_ptr<class Hierarchy> Architect::generateHierarchy(std::unordered_map
             pLayerDescs[l]._radius = std::stoi(_higherLayers[l]._params["p_radius"]);
     }
 
+    // Kernels are created from here on
+    waitForPrograms(programBuilds);
+
     h->_p.createRandom(*_resources->_cs, *hProg, *pProg, pLayerDescs, hLayerDescs, initWeightRange, _rng);
 
     // Create readout layers
@@ -174,6 +169,9 @@ std::shared_ptr<class Agent> Architect::generateAgent(std::unordered_map<std::st
     a->_rng = _rng;
     a->_resources = _resources;
 
+    // Compile in the background while host side setup continues
+    std::vector<std::pair<std::string, std::future<bool>>> programBuilds = loadPrograms(true);
+
     a->_inputImages.resize(_inputLayers.size());
 
     for (int i = 0; i < _inputLayers.size(); i++)
@@ -189,32 +187,9 @@ std::shared_ptr<class Agent> Architect::generateAgent(std::unordered_map<std::st
         actionTileSizes[i] = { _actionLayers[i]._tileSize.x, _actionLayers[i]._tileSize.y };
     }
 
-    std::shared_ptr<ComputeProgram> asProg;
-
-    if (_resources->_programs.find("agentSwarm") == _resources->_programs.end()) {
-        asProg = std::make_shared<ComputeProgram>();
-        asProg->loadAgentSwarmKernel(*_resources->_cs);
-    }
-    else
-        asProg = _resources->_programs["agentSwarm"];
-
-    std::shared_ptr<ComputeProgram> hProg;
-
-    if (_resources->_programs.find("hierarchy") == _resources->_programs.end()) {
-        hProg = std::make_shared<ComputeProgram>();
-        hProg->loadHierarchyKernel(*_resources->_cs);
-    }
-    else
-        hProg = _resources->_programs["hierarchy"];
-
-    std::shared_ptr<ComputeProgram> pProg;
-
-    if (_resources->_programs.find("predictor") == _resources->_programs.end()) {
-        pProg = std::make_shared<ComputeProgram>();
-        pProg->loadPredictorKernel(*_resources->_cs);
-    }
-    else
-        pProg = _resources->_programs["predictor"];
+    std::shared_ptr<ComputeProgram> asProg = _resources->_programs["agentSwarm"];
+    std::shared_ptr<ComputeProgram> hProg = _resources->_programs["hierarchy"];
+    std::shared_ptr<ComputeProgram> pProg = _resources->_programs["predictor"];
 
     std::vector<std::vector<AgentSwarm::AgentLayerDesc>> aLayerDescs(_higherLayers.size());
     std::vector<Predictor::PredLayerDesc> pLayerDescs(_higherLayers.size());
@@ -299,11 +274,88 @@ std::shared_ptr<class Agent> Architect::generateAgent(std::unordered_map<std::st
         }
     }
 
+    // Kernels are created from here on
+    waitForPrograms(programBuilds);
+
     a->_as.createRandom(*_resources->_cs, *hProg, *pProg, *asProg, actionSizes, actionTileSizes, aLayerDescs, pLayerDescs, hLayerDescs, initWeightRange, _rng);
 
     return a;
 }
 
+std::vector<std::pair<std::string, std::future<bool>>> Architect::loadPrograms(bool forAgent) {
+    std::vector<std::pair<std::string, std::future<bool>>> programBuilds;
+
+    ComputeSystem &cs = *_resources->_cs;
+
+    std::vector<std::pair<std::string, std::function<bool(ComputeProgram &)>>> required;
+
+    required.push_back({ "hierarchy", [&cs](ComputeProgram &prog) { return prog.loadHierarchyKernel(cs); } });
+    required.push_back({ "predictor", [&cs](ComputeProgram &prog) { return prog.loadPredictorKernel(cs); } });
+
+    if (forAgent)
+        required.push_back({ "agentSwarm", [&cs](ComputeProgram &prog) { return prog.loadAgentSwarmKernel(cs); } });
+
+    for (int l = 0; l < _higherLayers.size(); l++) {
+        SparseFeaturesType type = _higherLayers[l]._type;
+
+        std::string name;
+
+        switch (type) {
+        case _stdp:     name = "stdp"; break;
+        case _delay:    name = "delay"; break;
+        case _chunk:    name = "chunk"; break;
+        case _ReLU:     name = "ReLU"; break;
+        }
+
+        required.push_back({ name, [&cs, type](ComputeProgram &prog) { return prog.loadSparseFeaturesKernel(cs, type); } });
+    }
+
+    for (int i = 0; i < required.size(); i++) {
+        if (_resources->_programs.find(required[i].first) != _resources->_programs.end())
+            continue;
+
+        // Registered right away so later lookups share the program being built
+        std::shared_ptr<ComputeProgram> prog = std::make_shared<ComputeProgram>();
+
+        _resources->_programs[required[i].first] = prog;
+
+        std::function<bool(ComputeProgram &)> load = required[i].second;
+
+        std::shared_ptr<std::packaged_task<bool()>> build = std::make_shared<std::packaged_task<bool()>>([prog, load] { return load(*prog); });
+
+        programBuilds.push_back({ required[i].first, build->get_future() });
+
+        cs.getPool().enqueue([build] { (*build)(); });
+    }
+
+    return programBuilds;
+}
+
+void Architect::waitForPrograms(std::vector<std::pair<std::string, std::future<bool>>> &programBuilds) {
+    std::string failed;
+
+    // Wait on all of them, none may still be building once the entries are removed
+    for (int i = 0; i < programBuilds.size(); i++) {
+        bool built;
+
+        try {
+            built = programBuilds[i].second.get();
+        }
+        catch (...) {
+            built = false;
+        }
+
+        if (!built) {
+            _resources->_programs.erase(programBuilds[i].first);
+
+            failed += (failed.empty() ? "" : ", ") + programBuilds[i].first;
+        }
+    }
+
+    if (!failed.empty())
+        throw std::runtime_error("Could not build program(s): " + failed);
+}
+
 std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(int layerIndex, SparseFeaturesType type, const Vec2i &size,
     SparseFeatures::InputType inputType, std::unordered_map<std::string, std::string> &params)
 {
@@ -322,6 +374,9 @@ std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(in
         if (params.find("sfs_inhibitionRadius") != params.end())
             sfDescSTDP->_inhibitionRadius = std::stoi(params["sfs_inhibitionRadius"]);
 
+        if (params.find("sfs_inhibitionStride") != params.end())
+            sfDescSTDP->_inhibitionStride = std::stoi(params["sfs_inhibitionStride"]);
+
         if (params.find("sfs_initWeightRange") != params.end()) {
             Vec2f initWeightRange = ParameterModifier::parseVec2f(params["sfs_initWeightRange"]);
             sfDescSTDP->_initWeightRange = { initWeightRange.x, initWeightRange.y };
@@ -344,6 +399,9 @@ std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(in
         if (params.find("sfs_gamma") != params.end())
             sfDescSTDP->_gamma = std::stof(params["sfs_gamma"]);
 
+        if (params.find("sfs_halfPrecision") != params.end())
+            sfDescSTDP->_halfPrecision = ParameterModifier::parseBool(params["sfs_halfPrecision"]);
+
         if (layerIndex == 0) {
             sfDescSTDP->_visibleLayerDescs.resize(_inputLayers.size() + 1);
 
@@ -449,6 +507,9 @@ std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(in
         if (params.find("sfd_activeRatio") != params.end())
             sfDescDelay->_activeRatio = std::stof(params["sfd_activeRatio"]);
 
+        if (params.find("sfd_halfPrecision") != params.end())
+            sfDescDelay->_halfPrecision = ParameterModifier::parseBool(params["sfd_halfPrecision"]);
+
         if (layerIndex == 0) {
             sfDescDelay->_visibleLayerDescs.resize(_inputLayers.size());
 
@@ -527,6 +588,9 @@ std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(in
         if (params.find("sfc_numSamples") != params.end())
             sfDescChunk->_numSamples = std::stoi(params["sfc_numSamples"]);
 
+        if (params.find("sfc_halfPrecision") != params.end())
+            sfDescChunk->_halfPrecision = ParameterModifier::parseBool(params["sfc_halfPrecision"]);
+
         if (layerIndex == 0) {
             sfDescChunk->_visibleLayerDescs.resize(_inputLayers.size());
 
@@ -638,6 +702,9 @@ std::shared_ptr<SparseFeatures::SparseFeaturesDesc> Architect::sfDescFromName(in
         if (params.find("sfr_biasAlpha") != params.end())
             sfDescReLU->_biasAlpha = std::stof(params["sfr_biasAlpha"]);
 
+        if (params.find("sfr_halfPrecision") != params.end())
+            sfDescReLU->_halfPrecision = ParameterModifier::parseBool(params["sfr_halfPrecision"]);
+
         if (layerIndex == 0) {
             sfDescReLU->_visibleLayerDescs.resize(_inputLayers.size() + 1);
 
@@ -753,10 +820,7 @@ void ValueField2D::load(const schemas::ValueField2D* fbValueField2D, ComputeSyst
     _size.x = fbValueField2D->_size()->x();
     _size.y = fbValueField2D->_size()->y();
 
-    flatbuffers::uoffset_t numValues = fbValueField2D->_data()->Length();
-    _data.resize(numValues);
-    for (flatbuffers::uoffset_t i = 0; i < numValues; i++)
-        _data[i] = fbValueField2D->_data()->Get(i);
+    _data.assign(fbValueField2D->_data()->begin(), fbValueField2D->_data()->end());
 }
 
 flatbuffers::Offset<schemas::ValueField2D> ValueField2D::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
@@ -911,15 +975,15 @@ void Architect::load(const schemas::Architect* fbArchitect, ComputeSystem &cs) {
 
 flatbuffers::Offset<schemas::Architect> Architect::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
     std::vector<flatbuffers::Offset<schemas::InputLayer>> inputLayers;
-    for (InputLayer layer : _inputLayers)
+    for (InputLayer &layer : _inputLayers)
         inputLayers.push_back(layer.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::ActionLayer>> actionLayers;
-    for (ActionLayer layer : _actionLayers)
+    for (ActionLayer &layer : _actionLayers)
         actionLayers.push_back(layer.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::HigherLayer>> higherLayers;
-    for (HigherLayer layer : _higherLayers)
+    for (HigherLayer &layer : _higherLayers)
         higherLayers.push_back(layer.save(builder, cs));
 
     return schemas::CreateArchitect(builder,
@@ -929,22 +993,20 @@ flatbuffers::Offset<schemas::Architect> Architect::save(flatbuffers::FlatBufferB
 }
 
 void Architect::load(const std::string &fileName) {
-    FILE* file = fopen(fileName.c_str(), "rb");
-    fseek(file, 0L, SEEK_END);
-    size_t length = ftell(file);
-    fseek(file, 0L, SEEK_SET);
-    std::vector<uint8_t> data(length);
-    fread(data.data(), sizeof(uint8_t), length, file);
-    fclose(file);
+    // Device uploads read straight from the mapping
+    MappedFile file;
+
+    if (!file.open(fileName))
+        return;
 
-    flatbuffers::Verifier verifier = flatbuffers::Verifier(data.data(), length);
+    flatbuffers::Verifier verifier = flatbuffers::Verifier(file.getData(), file.getSize());
 
     bool verified =
         schemas::VerifyArchitectBuffer(verifier) |
-        schemas::ArchitectBufferHasIdentifier(data.data());
+        schemas::ArchitectBufferHasIdentifier(file.getData());
 
     if (verified) {
-        const schemas::Architect* arch = schemas::GetArchitect(data.data());
+        const schemas::Architect* arch = schemas::GetArchitect(file.getData());
 
         load(arch, *_resources->_cs);
     }
@@ -953,7 +1015,9 @@ void Architect::load(const std::string &fileName) {
 }
 
 void Architect::save(const std::string &fileName) {
-    flatbuffers::FlatBufferBuilder builder;
+    CheckpointAllocator allocator;
+
+    flatbuffers::FlatBufferBuilder builder(1024, &allocator);
 
     flatbuffers::Offset<schemas::Architect> arch = save(builder, *_resources->_cs);
 
@@ -15,6 +15,8 @@
 
 #include <unordered_map>
 #include <sstream>
+#include <stdexcept>
+#include <future>
 
 namespace ogmaneo {
     /*!
@@ -69,7 +71,14 @@ namespace ogmaneo {
             create(type, platformIndex, deviceIndex);
         }
 
+        /*!
+        \brief Create the shared ComputeSystem
+        Hierarchies and agents need OpenCL, so _native is rejected (std::invalid_argument). Use the native layers directly instead.
+        */
         void create(ComputeSystem::DeviceType type, int platformIndex = -1, int deviceIndex = -1) {
+            if (type == ComputeSystem::_native)
+                throw std::invalid_argument("Resources require an OpenCL device type, _native only runs the native layers (e.g. NativePredictorLayer)");
+
             _cs = std::make_shared<ComputeSystem>();
             _cs->create(type, platformIndex, deviceIndex);
         }
@@ -127,6 +136,10 @@ namespace ogmaneo {
             return _data;
         }
 
+        const std::vector<float> &getData() const {
+            return _data;
+        }
+
         //!@{
         /*!
         \brief Serialization
@@ -288,6 +301,16 @@ namespace ogmaneo {
 
         std::shared_ptr<Resources> _resources;
 
+        //!@{
+        /*!
+        \brief Start building the programs required by the current layers that are not yet in the Resources, and wait for them
+        Builds run concurrently on the ComputeSystem's thread pool, waitForPrograms must be called before kernels are created.
+        Failed programs are removed from the Resources again (so a later generate retries them), then std::runtime_error is thrown.
+        */
+        std::vector<std::pair<std::string, std::future<bool>>> loadPrograms(bool forAgent);
+        void waitForPrograms(std::vector<std::pair<std::string, std::future<bool>>> &programBuilds);
+        //!@}
+
         //!@{
         /*!
         \brief Serialization
@@ -296,6 +319,10 @@ namespace ogmaneo {
         flatbuffers::Offset<ogmaneo::schemas::Architect> save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
 
     public:
+        /*!
+        \brief Initialize with a seed and the shared resources
+        The resources' ComputeSystem must be an OpenCL one, _native is rejected (std::invalid_argument).
+        */
         void initialize(unsigned int seed, const std::shared_ptr<Resources> &resources);
 
         ParameterModifier addInputLayer(const Vec2i &size);
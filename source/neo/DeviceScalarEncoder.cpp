@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "DeviceScalarEncoder.h"
+
+#include <assert.h>
+
+using namespace ogmaneo;
+
+void DeviceScalarEncoder::createRandom(ComputeSystem &cs, ComputeProgram &program, int numInputs, cl_int2 outputSize,
+    cl_float2 initWeightRange, std::mt19937 &rng)
+{
+    _numInputs = numInputs;
+    _outputSize = outputSize;
+
+    cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(program.getProgram(), "randomUniformWeights");
+
+    cl_int3 weightsSize = { _outputSize.x, _outputSize.y, _numInputs };
+
+    _weightsEncode = createWeightBuffer(cs, weightsSize);
+    _weightsDecode = createWeightBuffer(cs, weightsSize);
+
+    randomUniform(_weightsEncode, cs, randomUniformWeightsKernel, initWeightRange, rng);
+    randomUniform(_weightsDecode, cs, randomUniformWeightsKernel, initWeightRange, rng);
+
+    _biases = createDoubleBuffer2D(cs, _outputSize, CL_R, CL_FLOAT);
+
+    randomUniform(_biases[_back], cs, randomUniform2DKernel, _outputSize, initWeightRange, rng);
+
+    _activations = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _outputSize.x, _outputSize.y);
+
+    _inputs = cl::Buffer(cs.getContext(), CL_MEM_READ_ONLY, _numInputs * sizeof(cl_float));
+    _errors = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, _numInputs * sizeof(cl_float));
+    _decoded = cl::Buffer(cs.getContext(), CL_MEM_WRITE_ONLY, _numInputs * sizeof(cl_float));
+
+    _decoderOutputs.assign(_numInputs, 0.0f);
+
+    _activateKernel = cl::Kernel(program.getProgram(), "seActivate");
+    _inhibitKernel = cl::Kernel(program.getProgram(), "seInhibit");
+    _reconstructKernel = cl::Kernel(program.getProgram(), "seReconstruct");
+    _learnKernel = cl::Kernel(program.getProgram(), "seLearn");
+    _decodeKernel = cl::Kernel(program.getProgram(), "seDecode");
+}
+
+void DeviceScalarEncoder::encode(ComputeSystem &cs, const std::vector<float> &inputs, const cl::Image2D &outputs, float activeRatio, float alpha, float beta) {
+    assert(inputs.size() == _numInputs);
+
+    cs.getQueue().enqueueWriteBuffer(_inputs, CL_TRUE, 0, _numInputs * sizeof(cl_float), inputs.data());
+
+    // Activate
+    {
+        int argIndex = 0;
+
+        _activateKernel.setArg(argIndex++, _inputs);
+        _activateKernel.setArg(argIndex++, _weightsEncode._buffer);
+        _activateKernel.setArg(argIndex++, _biases[_back]);
+        _activateKernel.setArg(argIndex++, _activations);
+        _activateKernel.setArg(argIndex++, _outputSize);
+        _activateKernel.setArg(argIndex++, _numInputs);
+
+        cs.getQueue().enqueueNDRangeKernel(_activateKernel, cl::NullRange, cl::NDRange(_outputSize.x, _outputSize.y));
+    }
+
+    // Inhibit, also updates the biases
+    {
+        int argIndex = 0;
+
+        _inhibitKernel.setArg(argIndex++, _activations);
+        _inhibitKernel.setArg(argIndex++, outputs);
+        _inhibitKernel.setArg(argIndex++, _biases[_back]);
+        _inhibitKernel.setArg(argIndex++, _biases[_front]);
+        _inhibitKernel.setArg(argIndex++, _outputSize);
+        _inhibitKernel.setArg(argIndex++, activeRatio);
+        _inhibitKernel.setArg(argIndex++, beta);
+
+        cs.getQueue().enqueueNDRangeKernel(_inhibitKernel, cl::NullRange, cl::NDRange(_outputSize.x, _outputSize.y));
+    }
+
+    std::swap(_biases[_front], _biases[_back]);
+
+    if (alpha != 0.0f) {
+        // Reconstruct
+        {
+            int argIndex = 0;
+
+            _reconstructKernel.setArg(argIndex++, _inputs);
+            _reconstructKernel.setArg(argIndex++, outputs);
+            _reconstructKernel.setArg(argIndex++, _weightsDecode._buffer);
+            _reconstructKernel.setArg(argIndex++, _errors);
+            _reconstructKernel.setArg(argIndex++, _outputSize);
+            _reconstructKernel.setArg(argIndex++, _numInputs);
+            _reconstructKernel.setArg(argIndex++, activeRatio);
+
+            cs.getQueue().enqueueNDRangeKernel(_reconstructKernel, cl::NullRange, cl::NDRange(_numInputs));
+        }
+
+        // Learn
+        {
+            int argIndex = 0;
+
+            _learnKernel.setArg(argIndex++, outputs);
+            _learnKernel.setArg(argIndex++, _errors);
+            _learnKernel.setArg(argIndex++, _weightsDecode._buffer);
+            _learnKernel.setArg(argIndex++, _outputSize);
+            _learnKernel.setArg(argIndex++, _numInputs);
+            _learnKernel.setArg(argIndex++, alpha);
+
+            cs.getQueue().enqueueNDRangeKernel(_learnKernel, cl::NullRange, cl::NDRange(_outputSize.x, _outputSize.y));
+        }
+    }
+}
+
+void DeviceScalarEncoder::decode(ComputeSystem &cs, const cl::Image2D &outputs) {
+    int argIndex = 0;
+
+    _decodeKernel.setArg(argIndex++, outputs);
+    _decodeKernel.setArg(argIndex++, _weightsEncode._buffer);
+    _decodeKernel.setArg(argIndex++, _decoded);
+    _decodeKernel.setArg(argIndex++, _outputSize);
+    _decodeKernel.setArg(argIndex++, _numInputs);
+
+    cs.getQueue().enqueueNDRangeKernel(_decodeKernel, cl::NullRange, cl::NDRange(_numInputs));
+
+    cs.getQueue().enqueueReadBuffer(_decoded, CL_TRUE, 0, _numInputs * sizeof(cl_float), _decoderOutputs.data());
+}
@@ -0,0 +1,122 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "system/SharedLib.h"
+#include "system/ComputeSystem.h"
+#include "system/ComputeProgram.h"
+#include "Helpers.h"
+
+#include <vector>
+
+namespace ogmaneo {
+    /*!
+    \brief Device-resident RBF-based scalar encoder
+    Same encode/learn/decode cycle as ScalarEncoder, but on the OpenCL device. The SDR is written straight into an image
+    (e.g. one of Hierarchy::getInputImages), so only the raw scalars are uploaded and only the decoded scalars are read back.
+    */
+    class OGMA_API DeviceScalarEncoder {
+    private:
+        //!@{
+        /*!
+        \brief Weights, one weight per input for every output unit
+        */
+        WeightBuffer _weightsEncode;
+        WeightBuffer _weightsDecode;
+        //!@}
+
+        /*!
+        \brief Bias values
+        */
+        DoubleBuffer2D _biases;
+
+        /*!
+        \brief Output activations before inhibition
+        */
+        cl::Image2D _activations;
+
+        //!@{
+        /*!
+        \brief Scalar buffers (device side inputs, reconstruction errors and decoding)
+        */
+        cl::Buffer _inputs;
+        cl::Buffer _errors;
+        cl::Buffer _decoded;
+        //!@}
+
+        /*!
+        \brief Decoding read back to the host
+        */
+        std::vector<float> _decoderOutputs;
+
+        //!@{
+        /*!
+        \brief Sizes
+        */
+        cl_int2 _outputSize;
+        int _numInputs;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Kernels
+        */
+        cl::Kernel _activateKernel;
+        cl::Kernel _inhibitKernel;
+        cl::Kernel _reconstructKernel;
+        cl::Kernel _learnKernel;
+        cl::Kernel _decodeKernel;
+        //!@}
+
+    public:
+        /*!
+        \brief Randomly initialize the scalar encoder
+        \param cs is the ComputeSystem.
+        \param program is the ComputeProgram associated with the ComputeSystem and loaded with the extra kernel code.
+        \param numInputs to the encoder.
+        \param outputSize size of the output SDR image (2D), e.g. the size of a Hierarchy input.
+        \param initWeightRange are the minimum and maximum range values for weight initialization.
+        \param rng a random number generator.
+        */
+        void createRandom(ComputeSystem &cs, ComputeProgram &program, int numInputs, cl_int2 outputSize,
+            cl_float2 initWeightRange, std::mt19937 &rng);
+
+        /*!
+        \brief Perform encoding
+        \param cs is the ComputeSystem.
+        \param inputs the inputs to be encoded.
+        \param outputs CL_R CL_FLOAT image of the output size receiving the SDR.
+        \param activeRatio % active units.
+        \param alpha learning rate for weights (often 0 for this encoder).
+        \param beta learning rate for biases (often 0 for this encoder).
+        */
+        void encode(ComputeSystem &cs, const std::vector<float> &inputs, const cl::Image2D &outputs, float activeRatio, float alpha, float beta);
+
+        /*!
+        \brief Perform decoding, reads the result back (blocking)
+        \param cs is the ComputeSystem.
+        \param outputs CL_R CL_FLOAT image of the output size holding the SDR to decode, e.g. Hierarchy::getDevicePrediction.
+        */
+        void decode(ComputeSystem &cs, const cl::Image2D &outputs);
+
+        /*!
+        \brief Get resulting decoding
+        */
+        std::vector<float> &getDecoderOutputs() {
+            return _decoderOutputs;
+        }
+
+        /*!
+        \brief Get output size
+        */
+        cl_int2 getOutputSize() const {
+            return _outputSize;
+        }
+    };
+}
@@ -120,6 +120,24 @@ void FeatureHierarchy::clearMemory(ComputeSystem &cs) {
         _layers[l]._sf->clearMemory(cs);
 }
 
+FeatureHierarchy FeatureHierarchy::createSession(ComputeSystem &cs) const {
+    FeatureHierarchy session = *this;
+
+    for (int l = 0; l < session._layers.size(); l++) {
+        Layer &layer = session._layers[l];
+
+        layer._sf = _layers[l]._sf->createSession(cs);
+        layer._tpBuffer = cloneDoubleBuffer2D(cs, _layers[l]._tpBuffer);
+        layer._predErrors = cloneImage2D(cs, _layers[l]._predErrors);
+    }
+
+    // Own kernels, arguments are set per object
+    session._fhPoolKernel = cloneKernel(_fhPoolKernel);
+    session._fhPredErrorKernel = cloneKernel(_fhPredErrorKernel);
+
+    return session;
+}
+
 void FeatureHierarchy::LayerDesc::load(const schemas::FeatureHierarchyLayerDesc* fbFeatureHierarchyLayerDesc, ComputeSystem &cs) {
     _sfDesc->load(fbFeatureHierarchyLayerDesc->_sfDesc(), cs);
     _poolSteps = fbFeatureHierarchyLayerDesc->_poolSteps();
@@ -156,7 +174,7 @@ flatbuffers::Offset<schemas::FeatureHierarchyLayer> FeatureHierarchy::Layer::sav
         type, _sf->save(builder, cs).Union(),
         _clock,
         ogmaneo::save(_tpBuffer, builder, cs),
-        ogmaneo::save(_predErrors, builder, cs),
+        ogmaneo::saveScratch(_predErrors, builder, cs),
         _tpReset, _tpNextReset);
 }
 
@@ -175,11 +193,11 @@ void FeatureHierarchy::load(const schemas::FeatureHierarchy* fbFeatureHierarchy,
 
 flatbuffers::Offset<schemas::FeatureHierarchy> FeatureHierarchy::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
     std::vector<flatbuffers::Offset<schemas::FeatureHierarchyLayerDesc>> layerDescs;
-    for (LayerDesc layerDesc : _layerDescs)
+    for (LayerDesc &layerDesc : _layerDescs)
         layerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::FeatureHierarchyLayer>> layers;
-    for (Layer layer : _layers)
+    for (Layer &layer : _layers)
         layers.push_back(layer.save(builder, cs));
 
     return schemas::CreateFeatureHierarchy(builder,
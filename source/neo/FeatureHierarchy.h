@@ -167,6 +167,13 @@ namespace ogmaneo {
         */
         void clearMemory(ComputeSystem &cs);
 
+        /*!
+        \brief Create an inference session
+        Shares the encoder weights with this hierarchy, but owns copies of the working memory (encoder states, pooling buffers).
+        \param cs is the ComputeSystem.
+        */
+        FeatureHierarchy createSession(ComputeSystem &cs) const;
+
         //!@{
         /*!
         \brief Serialization
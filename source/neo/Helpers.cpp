@@ -8,8 +8,95 @@
 
 #include "Helpers.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
 using namespace ogmaneo;
 
+namespace {
+    // Convert weights between the image order (serialized) and the unit-major layout, channels values per element
+    template<class T>
+    void reorderWeights(const T* src, T* dst, cl_int3 size, int channels, bool toUnitMajor) {
+        for (int wi = 0; wi < size.z; wi++)
+            for (int y = 0; y < size.y; y++)
+                for (int x = 0; x < size.x; x++) {
+                    size_t imageIndex = x + static_cast<size_t>(size.x) * (y + static_cast<size_t>(size.y) * wi);
+                    size_t unitIndex = wi + static_cast<size_t>(size.z) * (x + static_cast<size_t>(size.x) * y);
+
+                    size_t srcIndex = (toUnitMajor ? imageIndex : unitIndex) * channels;
+                    size_t dstIndex = (toUnitMajor ? unitIndex : imageIndex) * channels;
+
+                    for (int c = 0; c < channels; c++)
+                        dst[dstIndex + c] = src[srcIndex + c];
+                }
+    }
+
+    // Contiguous view of serialized data. Flatbuffers stores little-endian, so on little-endian hosts this is the
+    // (memory mapped) file data itself, elsewhere it is converted into staging
+    template<class T>
+    const T* getVectorData(const flatbuffers::Vector<T>* vector, std::vector<T> &staging) {
+#if FLATBUFFERS_LITTLEENDIAN
+        return vector->data();
+#else
+        staging.assign(vector->begin(), vector->end());
+
+        return staging.data();
+#endif
+    }
+
+    // Convert data read from the device (host order) to the little-endian order Flatbuffers stores, in place
+    template<class T>
+    void toVectorOrder(T* data, size_t numElements) {
+#if !FLATBUFFERS_LITTLEENDIAN
+        for (size_t i = 0; i < numElements; i++)
+            data[i] = flatbuffers::EndianScalar(data[i]);
+#endif
+    }
+
+    // Read a whole image straight into builder storage, no host staging copy
+    template<class T>
+    flatbuffers::Offset<flatbuffers::Vector<T>> saveImageData(const cl::Image &img, const cl::array<cl::size_type, 3> &region, size_t numElements,
+        flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs)
+    {
+        T* data;
+
+        flatbuffers::Offset<flatbuffers::Vector<T>> vector = builder.CreateUninitializedVector(numElements, &data);
+
+        cs.getQueue().enqueueReadImage(img, CL_TRUE, { 0, 0, 0 }, region, 0, 0, data);
+
+        toVectorOrder(data, numElements);
+
+        return vector;
+    }
+
+    // Read a weight buffer straight into builder storage in image order, only unit-major weights need a staging copy
+    template<class T>
+    flatbuffers::Offset<flatbuffers::Vector<T>> saveBufferData(const cl::Buffer &buffer, size_t numElements, bool unitMajor, cl_int3 size, int channels,
+        flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs)
+    {
+        T* data;
+
+        flatbuffers::Offset<flatbuffers::Vector<T>> vector = builder.CreateUninitializedVector(numElements, &data);
+
+        if (unitMajor) {
+            std::vector<T> staging(numElements);
+
+            cs.getQueue().enqueueReadBuffer(buffer, CL_TRUE, 0, numElements * sizeof(T), staging.data());
+
+            reorderWeights(staging.data(), data, size, channels, false);
+        }
+        else
+            cs.getQueue().enqueueReadBuffer(buffer, CL_TRUE, 0, numElements * sizeof(T), data);
+
+        toVectorOrder(data, numElements);
+
+        return vector;
+    }
+}
+
 DoubleBuffer2D ogmaneo::createDoubleBuffer2D(ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType) {
     DoubleBuffer2D db;
 
@@ -28,6 +115,107 @@ DoubleBuffer3D ogmaneo::createDoubleBuffer3D(ComputeSystem &cs, cl_int3 size, cl
     return db;
 }
 
+cl::Image2D ogmaneo::cloneImage2D(ComputeSystem &cs, const cl::Image2D &img) {
+    size_t width = img.getImageInfo<CL_IMAGE_WIDTH>();
+    size_t height = img.getImageInfo<CL_IMAGE_HEIGHT>();
+
+    cl::Image2D copy(cs.getContext(), CL_MEM_READ_WRITE, img.getImageInfo<CL_IMAGE_FORMAT>(), width, height);
+
+    cs.getQueue().enqueueCopyImage(img, copy, { 0, 0, 0 }, { 0, 0, 0 }, { width, height, 1 });
+
+    return copy;
+}
+
+cl::Image3D ogmaneo::cloneImage3D(ComputeSystem &cs, const cl::Image3D &img) {
+    size_t width = img.getImageInfo<CL_IMAGE_WIDTH>();
+    size_t height = img.getImageInfo<CL_IMAGE_HEIGHT>();
+    size_t depth = img.getImageInfo<CL_IMAGE_DEPTH>();
+
+    cl::Image3D copy(cs.getContext(), CL_MEM_READ_WRITE, img.getImageInfo<CL_IMAGE_FORMAT>(), width, height, depth);
+
+    cs.getQueue().enqueueCopyImage(img, copy, { 0, 0, 0 }, { 0, 0, 0 }, { width, height, depth });
+
+    return copy;
+}
+
+DoubleBuffer2D ogmaneo::cloneDoubleBuffer2D(ComputeSystem &cs, const DoubleBuffer2D &db) {
+    DoubleBuffer2D copy;
+
+    copy[_front] = cloneImage2D(cs, db[_front]);
+    copy[_back] = cloneImage2D(cs, db[_back]);
+
+    return copy;
+}
+
+DoubleBuffer3D ogmaneo::cloneDoubleBuffer3D(ComputeSystem &cs, const DoubleBuffer3D &db) {
+    DoubleBuffer3D copy;
+
+    copy[_front] = cloneImage3D(cs, db[_front]);
+    copy[_back] = cloneImage3D(cs, db[_back]);
+
+    return copy;
+}
+
+cl::Kernel ogmaneo::cloneKernel(const cl::Kernel &kernel) {
+    if (kernel.get() == nullptr)
+        return cl::Kernel();
+
+    return cl::Kernel(kernel.getInfo<CL_KERNEL_PROGRAM>(), kernel.getInfo<CL_KERNEL_FUNCTION_NAME>().c_str());
+}
+
+WeightBuffer ogmaneo::createWeightBuffer(ComputeSystem &cs, cl_int3 size, int channels, bool halfPrecision) {
+    WeightBuffer wb;
+
+    wb._size = size;
+    wb._channels = channels;
+    wb._halfPrecision = halfPrecision;
+    wb._unitMajor = cs.getWeightLayout() == ComputeSystem::_unitMajor;
+    wb._buffer = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, static_cast<size_t>(size.x) * size.y * size.z * channels * wb.getValueSize());
+
+    return wb;
+}
+
+bool ogmaneo::isImageFormatSupported(ComputeSystem &cs, cl_mem_object_type imageType, const cl::ImageFormat &format) {
+    std::vector<cl::ImageFormat> formats;
+
+    if (cs.getContext().getSupportedImageFormats(CL_MEM_READ_WRITE, imageType, &formats) != CL_SUCCESS)
+        return false;
+
+    for (int i = 0; i < formats.size(); i++)
+        if (formats[i].image_channel_order == format.image_channel_order && formats[i].image_channel_data_type == format.image_channel_data_type)
+            return true;
+
+    return false;
+}
+
+PinnedHostBuffer ogmaneo::createPinnedHostBuffer(ComputeSystem &cs, size_t size) {
+    PinnedHostBuffer pb;
+
+    pb._size = size;
+    pb._buffer = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size);
+    pb._ptr = cs.getPrimaryQueue().enqueueMapBuffer(pb._buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size);
+
+    return pb;
+}
+
+bool ogmaneo::hasHostUnifiedMemory(ComputeSystem &cs) {
+    return cs.getDevice().getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() == CL_TRUE;
+}
+
+cl::Image2D ogmaneo::createHostImage2D(ComputeSystem &cs, cl_int2 size, float* hostPtr) {
+    return cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, cl::ImageFormat(CL_R, CL_FLOAT), size.x, size.y, 0, hostPtr);
+}
+
+void* ogmaneo::mapHostImage2D(ComputeSystem &cs, cl::Image2D &image2D, cl_int2 size, cl_map_flags flags, cl_bool blocking) {
+    cl::size_type rowPitch, slicePitch;
+
+    return cs.getPrimaryQueue().enqueueMapImage(image2D, blocking, flags, { 0, 0, 0 }, { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 }, &rowPitch, &slicePitch);
+}
+
+void ogmaneo::unmapHostImage2D(ComputeSystem &cs, cl::Image2D &image2D, void* ptr) {
+    cs.getPrimaryQueue().enqueueUnmapMemObject(image2D, ptr);
+}
+
 void ogmaneo::randomUniform(cl::Image2D &image2D, ComputeSystem &cs, cl::Kernel &randomUniform2DKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
     int argIndex = 0;
 
@@ -126,7 +314,126 @@ void ogmaneo::randomUniformXZ(cl::Image3D &image3D, ComputeSystem &cs, cl::Kerne
     cs.getQueue().enqueueNDRangeKernel(randomUniform3DXZKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
 }
 
+void ogmaneo::randomUniform(WeightBuffer &weights, ComputeSystem &cs, cl::Kernel &randomUniformWeightsKernel, cl_float2 range, std::mt19937 &rng) {
+    int argIndex = 0;
+
+    std::uniform_int_distribution<int> seedDist(0, 999);
+
+    cl_uint2 seed = { (cl_uint)seedDist(rng), (cl_uint)seedDist(rng) };
+
+    randomUniformWeightsKernel.setArg(argIndex++, weights._buffer);
+    randomUniformWeightsKernel.setArg(argIndex++, seed);
+    randomUniformWeightsKernel.setArg(argIndex++, range);
+    randomUniformWeightsKernel.setArg(argIndex++, weights._channels);
+    randomUniformWeightsKernel.setArg(argIndex++, static_cast<cl_uchar>(weights._halfPrecision));
+
+    cs.getQueue().enqueueNDRangeKernel(randomUniformWeightsKernel, cl::NullRange, cl::NDRange(weights._size.x, weights._size.y, weights._size.z));
+}
+
+QuantizedWeightBuffer ogmaneo::quantize(const WeightBuffer &weights, ComputeSystem &cs, cl::Kernel &quantizeWeightsKernel) {
+    QuantizedWeightBuffer qwb;
+
+    qwb._size = weights._size;
+    qwb._unitMajor = weights._unitMajor;
+    qwb._values = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, static_cast<size_t>(qwb._size.x) * qwb._size.y * qwb._size.z * sizeof(cl_char));
+    qwb._scales = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, static_cast<size_t>(qwb._size.x) * qwb._size.y * sizeof(cl_float));
+
+    int argIndex = 0;
+
+    quantizeWeightsKernel.setArg(argIndex++, weights._buffer);
+    quantizeWeightsKernel.setArg(argIndex++, qwb._values);
+    quantizeWeightsKernel.setArg(argIndex++, qwb._scales);
+    quantizeWeightsKernel.setArg(argIndex++, weights._size.z);
+    quantizeWeightsKernel.setArg(argIndex++, weights._channels);
+    quantizeWeightsKernel.setArg(argIndex++, static_cast<cl_uchar>(weights._halfPrecision));
+
+    cs.getQueue().enqueueNDRangeKernel(quantizeWeightsKernel, cl::NullRange, cl::NDRange(weights._size.x, weights._size.y));
+
+    return qwb;
+}
+
+LocalTile ogmaneo::getLocalTile(ComputeSystem &cs, cl::Kernel &tiledKernel, cl_float2 hiddenToVisible, int radius, int depth) {
+    LocalTile tile;
+
+    cl_int2 tileSize = cs.getTileSize();
+
+    if (tileSize.x <= 0 || tileSize.y <= 0)
+        return tile;
+
+    if (static_cast<size_t>(tileSize.x) * tileSize.y > tiledKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice()))
+        return tile;
+
+    // Conservative patch size, fields that still reach outside it read the image directly
+    tile._visibleTileSize = { static_cast<int>(std::ceil(tileSize.x * hiddenToVisible.x)) + radius * 2 + 2,
+        static_cast<int>(std::ceil(tileSize.y * hiddenToVisible.y)) + radius * 2 + 2 };
+    tile._depth = depth;
+
+    cl_ulong tileBytes = static_cast<cl_ulong>(tile._visibleTileSize.x) * tile._visibleTileSize.y * depth * sizeof(cl_float);
+
+    tile._enabled = tileBytes + tiledKernel.getWorkGroupInfo<CL_KERNEL_LOCAL_MEM_SIZE>(cs.getDevice()) <= cs.getLocalMemSize();
+
+    return tile;
+}
+
+void ogmaneo::enqueueTiled(ComputeSystem &cs, cl::Kernel &tiledKernel, int argIndex, const LocalTile &tile, cl_int2 hiddenSize) {
+    cl_int2 tileSize = cs.getTileSize();
+
+    tiledKernel.setArg(argIndex++, cl::Local(static_cast<size_t>(tile._visibleTileSize.x) * tile._visibleTileSize.y * tile._depth * sizeof(cl_float)));
+    tiledKernel.setArg(argIndex++, tile._visibleTileSize);
+
+    cl::NDRange globalRange((hiddenSize.x + tileSize.x - 1) / tileSize.x * tileSize.x, (hiddenSize.y + tileSize.y - 1) / tileSize.y * tileSize.y);
+
+    cs.getQueue().enqueueNDRangeKernel(tiledKernel, cl::NullRange, globalRange, cl::NDRange(tileSize.x, tileSize.y));
+}
+
+bool ogmaneo::useGroupReduction(ComputeSystem &cs, cl::Kernel &groupKernel, cl_int2 groupSize) {
+    // Below 4x4 the serial scan is short enough
+    const size_t minGroupArea = 16;
+
+    size_t groupArea = static_cast<size_t>(groupSize.x) * groupSize.y;
+
+    return groupArea >= minGroupArea && groupArea <= groupKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice());
+}
+
+void ogmaneo::enqueueGroupReduction(ComputeSystem &cs, cl::Kernel &groupKernel, int argIndex, cl_int2 groupSize, cl_int2 numGroups) {
+    size_t groupArea = static_cast<size_t>(groupSize.x) * groupSize.y;
+
+    groupKernel.setArg(argIndex++, cl::Local(groupArea * sizeof(cl_float)));
+    groupKernel.setArg(argIndex++, cl::Local(groupArea * sizeof(cl_int)));
+
+    cs.getQueue().enqueueNDRangeKernel(groupKernel, cl::NullRange, cl::NDRange(numGroups.x * groupSize.x, numGroups.y * groupSize.y), cl::NDRange(groupSize.x, groupSize.y));
+}
+
+float ogmaneo::getStateDisagreement(ComputeSystem &cs, const cl::Image2D &statesA, const cl::Image2D &statesB, cl_int2 size) {
+    cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+    cl::array<cl::size_type, 3> region = { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 };
+
+    size_t numUnits = static_cast<size_t>(size.x) * size.y;
+
+    std::vector<cl_float> valuesA(numUnits);
+    std::vector<cl_float> valuesB(numUnits);
+
+    cs.getQueue().enqueueReadImage(statesA, CL_TRUE, zeroOrigin, region, 0, 0, valuesA.data());
+    cs.getQueue().enqueueReadImage(statesB, CL_TRUE, zeroOrigin, region, 0, 0, valuesB.data());
+
+    size_t numDiffering = 0;
+
+    for (size_t i = 0; i < numUnits; i++)
+        if ((valuesA[i] > 0.5f) != (valuesB[i] > 0.5f))
+            numDiffering++;
+
+    return static_cast<float>(numDiffering) / static_cast<float>(numUnits);
+}
+
+int ogmaneo::clampInhibitionStride(int stride, int radius) {
+    return std::max(1, std::min(stride, radius));
+}
+
 void ogmaneo::load(cl::Image2D &img, const schemas::Image2D* fbImg, ComputeSystem &cs) {
+    // Omitted scratch
+    if (fbImg == nullptr)
+        return;
+
     uint32_t width = (uint32_t)img.getImageInfo<CL_IMAGE_WIDTH>();
     uint32_t height = (uint32_t)img.getImageInfo<CL_IMAGE_HEIGHT>();
     uint32_t elementSize = (uint32_t)img.getImageInfo<CL_IMAGE_ELEMENT_SIZE>();
@@ -143,13 +450,11 @@ void ogmaneo::load(cl::Image2D &img, const schemas::Image2D* fbImg, ComputeSyste
         const schemas::FloatArray* fbFloatArray =
             reinterpret_cast<const schemas::FloatArray*>(fbImg->pixels());
 
-        uint32_t numElements = width * height * (elementSize / sizeof(float));
-        std::vector<float> floatArray(numElements, 0.0f);
+        assert(fbFloatArray->data()->size() == width * height * (elementSize / sizeof(float)));
 
-        for (uint32_t i = 0; i < numElements; i++)
-            floatArray[i] = fbFloatArray->data()->Get(i);
+        std::vector<float> staging;
 
-        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, floatArray.data());
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, getVectorData(fbFloatArray->data(), staging));
         cs.getQueue().finish();
         break;
     }
@@ -158,13 +463,24 @@ void ogmaneo::load(cl::Image2D &img, const schemas::Image2D* fbImg, ComputeSyste
         const schemas::ByteArray* fbByteArray =
             reinterpret_cast<const schemas::ByteArray*>(fbImg->pixels());
 
-        uint32_t numElements = width * height * (elementSize / sizeof(unsigned char));
-        std::vector<unsigned char> byteArray(numElements, 0);
+        assert(fbByteArray->data()->size() == width * height * (elementSize / sizeof(unsigned char)));
+
+        std::vector<unsigned char> staging;
+
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, getVectorData(fbByteArray->data(), staging));
+        cs.getQueue().finish();
+        break;
+    }
+    case schemas::PixelData::PixelData_ShortArray:
+    {
+        const schemas::ShortArray* fbShortArray =
+            reinterpret_cast<const schemas::ShortArray*>(fbImg->pixels());
 
-        for (uint32_t i = 0; i < numElements; i++)
-            byteArray[i] = fbByteArray->data()->Get(i);
+        assert(fbShortArray->data()->size() == width * height * (elementSize / sizeof(unsigned short)));
 
-        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, byteArray.data());
+        std::vector<unsigned short> staging;
+
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, getVectorData(fbShortArray->data(), staging));
         cs.getQueue().finish();
         break;
     }
@@ -175,6 +491,10 @@ void ogmaneo::load(cl::Image2D &img, const schemas::Image2D* fbImg, ComputeSyste
 }
 
 void ogmaneo::load(cl::Image3D &img, const schemas::Image3D* fbImg, ComputeSystem &cs) {
+    // Omitted scratch
+    if (fbImg == nullptr)
+        return;
+
     uint32_t width = (uint32_t)img.getImageInfo<CL_IMAGE_WIDTH>();
     uint32_t height = (uint32_t)img.getImageInfo<CL_IMAGE_HEIGHT>();
     uint32_t depth = (uint32_t)img.getImageInfo<CL_IMAGE_DEPTH>();
@@ -193,13 +513,11 @@ void ogmaneo::load(cl::Image3D &img, const schemas::Image3D* fbImg, ComputeSyste
         const schemas::FloatArray* fbFloatArray =
             reinterpret_cast<const schemas::FloatArray*>(fbImg->pixels());
 
-        uint32_t numElements = width * height * depth * (elementSize / sizeof(float));
-        std::vector<float> floatArray(numElements, 0.0f);
+        assert(fbFloatArray->data()->size() == width * height * depth * (elementSize / sizeof(float)));
 
-        for (uint32_t i = 0; i < numElements; i++)
-            floatArray[i] = fbFloatArray->data()->Get(i);
+        std::vector<float> staging;
 
-        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, floatArray.data());
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, getVectorData(fbFloatArray->data(), staging));
         cs.getQueue().finish();
         break;
     }
@@ -208,13 +526,24 @@ void ogmaneo::load(cl::Image3D &img, const schemas::Image3D* fbImg, ComputeSyste
         const schemas::ByteArray* fbByteArray =
             reinterpret_cast<const schemas::ByteArray*>(fbImg->pixels());
 
-        uint32_t numElements = width * height * depth * (elementSize / sizeof(unsigned char));
-        std::vector<unsigned char> byteArray(numElements, 0);
+        assert(fbByteArray->data()->size() == width * height * depth * (elementSize / sizeof(unsigned char)));
 
-        for (uint32_t i = 0; i < numElements; i++)
-            byteArray[i] = fbByteArray->data()->Get(i);
+        std::vector<unsigned char> staging;
 
-        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, byteArray.data());
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, getVectorData(fbByteArray->data(), staging));
+        cs.getQueue().finish();
+        break;
+    }
+    case schemas::PixelData::PixelData_ShortArray:
+    {
+        const schemas::ShortArray* fbShortArray =
+            reinterpret_cast<const schemas::ShortArray*>(fbImg->pixels());
+
+        assert(fbShortArray->data()->size() == width * height * depth * (elementSize / sizeof(unsigned short)));
+
+        std::vector<unsigned short> staging;
+
+        cs.getQueue().enqueueWriteImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, getVectorData(fbShortArray->data(), staging));
         cs.getQueue().finish();
         break;
     }
@@ -224,6 +553,29 @@ void ogmaneo::load(cl::Image3D &img, const schemas::Image3D* fbImg, ComputeSyste
     }
 }
 
+uint8_t* CheckpointAllocator::allocate(size_t size) {
+    return static_cast<uint8_t*>(std::malloc(size));
+}
+
+void CheckpointAllocator::deallocate(uint8_t* p, size_t size) {
+    std::free(p);
+}
+
+uint8_t* CheckpointAllocator::reallocate_downward(uint8_t* oldP, size_t oldSize, size_t newSize, size_t inUseBack, size_t inUseFront) {
+    assert(newSize > oldSize);
+
+    uint8_t* newP = static_cast<uint8_t*>(std::realloc(oldP, newSize));
+
+    // The builder does not check for failure, so fail like the default allocator
+    if (newP == nullptr)
+        throw std::bad_alloc();
+
+    // Built data lives at the end of the block, scratch at the start stays where it is
+    std::memmove(newP + newSize - inUseBack, newP + oldSize - inUseBack, inUseBack);
+
+    return newP;
+}
+
 flatbuffers::Offset<schemas::Image2D> ogmaneo::save(cl::Image2D &img, flatbuffers::FlatBufferBuilder& builder, ComputeSystem &cs) {
     uint32_t width = (uint32_t)img.getImageInfo<CL_IMAGE_WIDTH>();
     uint32_t height = (uint32_t)img.getImageInfo<CL_IMAGE_HEIGHT>();
@@ -242,11 +594,7 @@ flatbuffers::Offset<schemas::Image2D> ogmaneo::save(cl::Image2D &img, flatbuffer
     switch (channelType) {
     case CL_FLOAT:
     {
-        std::vector<float> pixels(width * height * (elementSize / sizeof(float)), 0.0f);
-        cs.getQueue().enqueueReadImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, pixels.data());
-        cs.getQueue().finish();
-
-        flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = builder.CreateVector(pixels.data(), pixels.size());
+        flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = saveImageData<float>(img, { width, height, 1 }, width * height * (elementSize / sizeof(float)), builder, cs);
         flatbuffers::Offset<schemas::FloatArray> floatArray = schemas::CreateFloatArray(builder, floatVector);
         ret = schemas::CreateImage2D(builder,
             &format, width, height, elementSize, schemas::PixelData_FloatArray, floatArray.Union());
@@ -255,16 +603,22 @@ flatbuffers::Offset<schemas::Image2D> ogmaneo::save(cl::Image2D &img, flatbuffer
     case CL_UNSIGNED_INT8:
     case CL_SIGNED_INT8:
     {
-        std::vector<unsigned char> pixels(width * height * (elementSize / sizeof(unsigned char)), 0);
-        cs.getQueue().enqueueReadImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, 1 }, 0, 0, pixels.data());
-        cs.getQueue().finish();
-
-        flatbuffers::Offset<flatbuffers::Vector<unsigned char>> byteVector = builder.CreateVector(pixels.data(), pixels.size());
+        flatbuffers::Offset<flatbuffers::Vector<unsigned char>> byteVector = saveImageData<unsigned char>(img, { width, height, 1 }, width * height * (elementSize / sizeof(unsigned char)), builder, cs);
         flatbuffers::Offset<schemas::ByteArray> byteArray = schemas::CreateByteArray(builder, byteVector);
         ret = schemas::CreateImage2D(builder,
             &format, width, height, elementSize, schemas::PixelData_ByteArray, byteArray.Union());
         break;
     }
+    case CL_HALF_FLOAT:
+    case CL_UNSIGNED_INT16:
+    case CL_SIGNED_INT16:
+    {
+        flatbuffers::Offset<flatbuffers::Vector<unsigned short>> shortVector = saveImageData<unsigned short>(img, { width, height, 1 }, width * height * (elementSize / sizeof(unsigned short)), builder, cs);
+        flatbuffers::Offset<schemas::ShortArray> shortArray = schemas::CreateShortArray(builder, shortVector);
+        ret = schemas::CreateImage2D(builder,
+            &format, width, height, elementSize, schemas::PixelData_ShortArray, shortArray.Union());
+        break;
+    }
     default:
         assert(0);
         break;
@@ -292,11 +646,7 @@ flatbuffers::Offset<schemas::Image3D> ogmaneo::save(cl::Image3D &img, flatbuffer
     switch (channelType) {
     case CL_FLOAT:
     {
-        std::vector<float> pixels(width * height * depth * (elementSize / sizeof(float)), 0.0f);
-        cs.getQueue().enqueueReadImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, pixels.data());
-        cs.getQueue().finish();
-
-        flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = builder.CreateVector(pixels.data(), pixels.size());
+        flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = saveImageData<float>(img, { width, height, depth }, width * height * depth * (elementSize / sizeof(float)), builder, cs);
         flatbuffers::Offset<schemas::FloatArray> floatArray = schemas::CreateFloatArray(builder, floatVector);
         ret = schemas::CreateImage3D(builder,
             &format, width, height, depth, elementSize, schemas::PixelData_FloatArray, floatArray.Union());
@@ -305,16 +655,22 @@ flatbuffers::Offset<schemas::Image3D> ogmaneo::save(cl::Image3D &img, flatbuffer
     case CL_UNSIGNED_INT8:
     case CL_SIGNED_INT8:
     {
-        std::vector<unsigned char> pixels(width * height * depth * (elementSize / sizeof(unsigned char)), 0);
-        cs.getQueue().enqueueReadImage(img, CL_TRUE, { 0, 0, 0 }, { width, height, depth }, 0, 0, pixels.data());
-        cs.getQueue().finish();
-
-        flatbuffers::Offset<flatbuffers::Vector<unsigned char>> byteVector = builder.CreateVector(pixels.data(), pixels.size());
+        flatbuffers::Offset<flatbuffers::Vector<unsigned char>> byteVector = saveImageData<unsigned char>(img, { width, height, depth }, width * height * depth * (elementSize / sizeof(unsigned char)), builder, cs);
         flatbuffers::Offset<schemas::ByteArray> byteArray = schemas::CreateByteArray(builder, byteVector);
         ret = schemas::CreateImage3D(builder,
             &format, width, height, depth, elementSize, schemas::PixelData_ByteArray, byteArray.Union());
         break;
     }
+    case CL_HALF_FLOAT:
+    case CL_UNSIGNED_INT16:
+    case CL_SIGNED_INT16:
+    {
+        flatbuffers::Offset<flatbuffers::Vector<unsigned short>> shortVector = saveImageData<unsigned short>(img, { width, height, depth }, width * height * depth * (elementSize / sizeof(unsigned short)), builder, cs);
+        flatbuffers::Offset<schemas::ShortArray> shortArray = schemas::CreateShortArray(builder, shortVector);
+        ret = schemas::CreateImage3D(builder,
+            &format, width, height, depth, elementSize, schemas::PixelData_ShortArray, shortArray.Union());
+        break;
+    }
     default:
         assert(0);
         break;
@@ -324,18 +680,24 @@ flatbuffers::Offset<schemas::Image3D> ogmaneo::save(cl::Image3D &img, flatbuffer
 }
 
 void ogmaneo::load(DoubleBuffer2D &db, const schemas::DoubleBuffer2D* fbDB, ComputeSystem &cs) {
-    if (db[_front].get() == nullptr || db[_back].get() == nullptr)
+    if (fbDB == nullptr || db[_front].get() == nullptr || db[_back].get() == nullptr)
         return;
 
-    ogmaneo::load(db[_front], fbDB->_front(), cs);
+    // Compact checkpoints reference the back image from both, the front is rewritten before it is read
+    if (fbDB->_front() != fbDB->_back())
+        ogmaneo::load(db[_front], fbDB->_front(), cs);
+
     ogmaneo::load(db[_back], fbDB->_back(), cs);
 }
 
 void ogmaneo::load(DoubleBuffer3D &db, const schemas::DoubleBuffer3D* fbDB, ComputeSystem &cs) {
-    if (db[_front].get() == nullptr || db[_back].get() == nullptr)
+    if (fbDB == nullptr || db[_front].get() == nullptr || db[_back].get() == nullptr)
         return;
 
-    ogmaneo::load(db[_front], fbDB->_front(), cs);
+    // Compact checkpoints reference the back image from both, the front is rewritten before it is read
+    if (fbDB->_front() != fbDB->_back())
+        ogmaneo::load(db[_front], fbDB->_front(), cs);
+
     ogmaneo::load(db[_back], fbDB->_back(), cs);
 }
 
@@ -343,6 +705,13 @@ flatbuffers::Offset<schemas::DoubleBuffer2D> ogmaneo::save(DoubleBuffer2D &db, f
     if (db[_front].get() == nullptr || db[_back].get() == nullptr)
         return schemas::CreateDoubleBuffer2D(builder, 0, 0);
 
+    // Front halves only hold the previous step, which is overwritten before it is read
+    if (cs.getCheckpointProfile() == ComputeSystem::_compact) {
+        flatbuffers::Offset<schemas::Image2D> back = ogmaneo::save(db[_back], builder, cs);
+
+        return schemas::CreateDoubleBuffer2D(builder, back, back);
+    }
+
     return schemas::CreateDoubleBuffer2D(builder,
         ogmaneo::save(db[_front], builder, cs),
         ogmaneo::save(db[_back], builder, cs)
@@ -353,8 +722,225 @@ flatbuffers::Offset<schemas::DoubleBuffer3D> ogmaneo::save(DoubleBuffer3D &db, f
     if (db[_front].get() == nullptr || db[_back].get() == nullptr)
         return schemas::CreateDoubleBuffer3D(builder, 0, 0);
 
+    // Front halves only hold the previous step, which is overwritten before it is read
+    if (cs.getCheckpointProfile() == ComputeSystem::_compact) {
+        flatbuffers::Offset<schemas::Image3D> back = ogmaneo::save(db[_back], builder, cs);
+
+        return schemas::CreateDoubleBuffer3D(builder, back, back);
+    }
+
     return schemas::CreateDoubleBuffer3D(builder,
         ogmaneo::save(db[_front], builder, cs),
         ogmaneo::save(db[_back], builder, cs)
     );
 }
+
+flatbuffers::Offset<schemas::Image2D> ogmaneo::saveScratch(cl::Image2D &img, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    if (cs.getCheckpointProfile() == ComputeSystem::_compact)
+        return 0;
+
+    return ogmaneo::save(img, builder, cs);
+}
+
+flatbuffers::Offset<schemas::DoubleBuffer2D> ogmaneo::saveScratch(DoubleBuffer2D &db, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    if (cs.getCheckpointProfile() == ComputeSystem::_compact)
+        return 0;
+
+    return ogmaneo::save(db, builder, cs);
+}
+
+void ogmaneo::load(WeightBuffer &weights, const schemas::DoubleBuffer3D* fbDB, ComputeSystem &cs) {
+    if (weights._buffer.get() == nullptr)
+        return;
+
+    const schemas::Image3D* fbImg = fbDB->_back();
+
+    uint32_t width = static_cast<uint32_t>(weights._size.x);
+    uint32_t height = static_cast<uint32_t>(weights._size.y);
+    uint32_t depth = static_cast<uint32_t>(weights._size.z);
+    uint32_t elementSize = static_cast<uint32_t>(weights._channels * weights.getValueSize());
+
+    assert(width == fbImg->width());
+    assert(height == fbImg->height());
+    assert(depth == fbImg->depth());
+    assert(elementSize == fbImg->elementSize());
+
+    // Image readback is tightly packed in the same order as the buffer
+    uint32_t numElements = width * height * depth * weights._channels;
+
+    if (weights._halfPrecision) {
+        assert(fbImg->pixels_type() == schemas::PixelData::PixelData_ShortArray);
+
+        const schemas::ShortArray* fbShortArray =
+            reinterpret_cast<const schemas::ShortArray*>(fbImg->pixels());
+
+        assert(fbShortArray->data()->size() == numElements);
+
+        std::vector<unsigned short> staging;
+
+        const unsigned short* data = getVectorData(fbShortArray->data(), staging);
+
+        if (weights._unitMajor) {
+            std::vector<unsigned short> unitMajor(numElements);
+
+            reorderWeights(data, unitMajor.data(), weights._size, weights._channels, true);
+
+            cs.getQueue().enqueueWriteBuffer(weights._buffer, CL_TRUE, 0, numElements * sizeof(unsigned short), unitMajor.data());
+        }
+        else
+            cs.getQueue().enqueueWriteBuffer(weights._buffer, CL_TRUE, 0, numElements * sizeof(unsigned short), data);
+    }
+    else {
+        assert(fbImg->pixels_type() == schemas::PixelData::PixelData_FloatArray);
+
+        const schemas::FloatArray* fbFloatArray =
+            reinterpret_cast<const schemas::FloatArray*>(fbImg->pixels());
+
+        assert(fbFloatArray->data()->size() == numElements);
+
+        std::vector<float> staging;
+
+        const float* data = getVectorData(fbFloatArray->data(), staging);
+
+        if (weights._unitMajor) {
+            std::vector<float> unitMajor(numElements);
+
+            reorderWeights(data, unitMajor.data(), weights._size, weights._channels, true);
+
+            cs.getQueue().enqueueWriteBuffer(weights._buffer, CL_TRUE, 0, numElements * sizeof(float), unitMajor.data());
+        }
+        else
+            cs.getQueue().enqueueWriteBuffer(weights._buffer, CL_TRUE, 0, numElements * sizeof(float), data);
+    }
+
+    cs.getQueue().finish();
+}
+
+flatbuffers::Offset<schemas::DoubleBuffer3D> ogmaneo::save(WeightBuffer &weights, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    if (weights._buffer.get() == nullptr)
+        return schemas::CreateDoubleBuffer3D(builder, 0, 0);
+
+    uint32_t width = static_cast<uint32_t>(weights._size.x);
+    uint32_t height = static_cast<uint32_t>(weights._size.y);
+    uint32_t depth = static_cast<uint32_t>(weights._size.z);
+    uint32_t elementSize = static_cast<uint32_t>(weights._channels * weights.getValueSize());
+
+    cl_channel_order channelOrder;
+    switch (weights._channels) {
+    case 1: channelOrder = CL_R; break;
+    case 2: channelOrder = CL_RG; break;
+    case 4: channelOrder = CL_RGBA; break;
+    default:
+        assert(0);
+        channelOrder = CL_R;
+        break;
+    }
+
+    schemas::ImageFormat format(
+        static_cast<schemas::ChannelOrder>(channelOrder),
+        static_cast<schemas::ChannelDataType>(weights._halfPrecision ? CL_HALF_FLOAT : CL_FLOAT)
+    );
+
+    uint32_t numElements = width * height * depth * weights._channels;
+
+    flatbuffers::Offset<schemas::Image3D> img;
+
+    if (weights._halfPrecision) {
+        flatbuffers::Offset<flatbuffers::Vector<unsigned short>> shortVector = saveBufferData<unsigned short>(weights._buffer, numElements,
+            weights._unitMajor, weights._size, weights._channels, builder, cs);
+        flatbuffers::Offset<schemas::ShortArray> shortArray = schemas::CreateShortArray(builder, shortVector);
+        img = schemas::CreateImage3D(builder,
+            &format, width, height, depth, elementSize, schemas::PixelData_ShortArray, shortArray.Union());
+    }
+    else {
+        flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = saveBufferData<float>(weights._buffer, numElements,
+            weights._unitMajor, weights._size, weights._channels, builder, cs);
+        flatbuffers::Offset<schemas::FloatArray> floatArray = schemas::CreateFloatArray(builder, floatVector);
+        img = schemas::CreateImage3D(builder,
+            &format, width, height, depth, elementSize, schemas::PixelData_FloatArray, floatArray.Union());
+    }
+
+    // Same table for both, older double buffered loaders still find front and back
+    return schemas::CreateDoubleBuffer3D(builder, img, img);
+}
+
+void ogmaneo::load(QuantizedWeightBuffer &weights, const schemas::QuantizedWeights* fbWeights, ComputeSystem &cs) {
+    const schemas::Image3D* fbValues = fbWeights->_values();
+    const schemas::Image2D* fbScales = fbWeights->_scales();
+
+    assert(fbValues->pixels_type() == schemas::PixelData::PixelData_ByteArray);
+    assert(fbScales->pixels_type() == schemas::PixelData::PixelData_FloatArray);
+    assert(fbValues->width() == fbScales->width());
+    assert(fbValues->height() == fbScales->height());
+
+    weights._size = cl_int3{ static_cast<cl_int>(fbValues->width()), static_cast<cl_int>(fbValues->height()), static_cast<cl_int>(fbValues->depth()) };
+
+    uint32_t numValues = fbValues->width() * fbValues->height() * fbValues->depth();
+    uint32_t numScales = fbScales->width() * fbScales->height();
+
+    const schemas::ByteArray* fbByteArray =
+        reinterpret_cast<const schemas::ByteArray*>(fbValues->pixels());
+
+    const schemas::FloatArray* fbFloatArray =
+        reinterpret_cast<const schemas::FloatArray*>(fbScales->pixels());
+
+    assert(fbByteArray->data()->size() == numValues);
+    assert(fbFloatArray->data()->size() == numScales);
+
+    std::vector<unsigned char> valuesStaging;
+    std::vector<float> scalesStaging;
+
+    const unsigned char* values = getVectorData(fbByteArray->data(), valuesStaging);
+    const float* scales = getVectorData(fbFloatArray->data(), scalesStaging);
+
+    weights._unitMajor = cs.getWeightLayout() == ComputeSystem::_unitMajor;
+
+    weights._values = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, numValues * sizeof(cl_char));
+    weights._scales = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, numScales * sizeof(cl_float));
+
+    if (weights._unitMajor) {
+        std::vector<unsigned char> unitMajor(numValues);
+
+        reorderWeights(values, unitMajor.data(), weights._size, 1, true);
+
+        cs.getQueue().enqueueWriteBuffer(weights._values, CL_TRUE, 0, numValues * sizeof(cl_char), unitMajor.data());
+    }
+    else
+        cs.getQueue().enqueueWriteBuffer(weights._values, CL_TRUE, 0, numValues * sizeof(cl_char), values);
+
+    cs.getQueue().enqueueWriteBuffer(weights._scales, CL_TRUE, 0, numScales * sizeof(cl_float), scales);
+    cs.getQueue().finish();
+}
+
+flatbuffers::Offset<schemas::QuantizedWeights> ogmaneo::save(QuantizedWeightBuffer &weights, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    if (weights._values.get() == nullptr)
+        return schemas::CreateQuantizedWeights(builder, 0, 0);
+
+    uint32_t width = static_cast<uint32_t>(weights._size.x);
+    uint32_t height = static_cast<uint32_t>(weights._size.y);
+    uint32_t depth = static_cast<uint32_t>(weights._size.z);
+
+    schemas::ImageFormat valuesFormat(
+        static_cast<schemas::ChannelOrder>(CL_R),
+        static_cast<schemas::ChannelDataType>(CL_SIGNED_INT8)
+    );
+
+    schemas::ImageFormat scalesFormat(
+        static_cast<schemas::ChannelOrder>(CL_R),
+        static_cast<schemas::ChannelDataType>(CL_FLOAT)
+    );
+
+    flatbuffers::Offset<flatbuffers::Vector<unsigned char>> byteVector = saveBufferData<unsigned char>(weights._values, width * height * depth,
+        weights._unitMajor, weights._size, 1, builder, cs);
+    flatbuffers::Offset<schemas::ByteArray> byteArray = schemas::CreateByteArray(builder, byteVector);
+    flatbuffers::Offset<schemas::Image3D> valuesImg = schemas::CreateImage3D(builder,
+        &valuesFormat, width, height, depth, sizeof(cl_char), schemas::PixelData_ByteArray, byteArray.Union());
+
+    flatbuffers::Offset<flatbuffers::Vector<float>> floatVector = saveBufferData<float>(weights._scales, width * height,
+        false, weights._size, 1, builder, cs);
+    flatbuffers::Offset<schemas::FloatArray> floatArray = schemas::CreateFloatArray(builder, floatVector);
+    flatbuffers::Offset<schemas::Image2D> scalesImg = schemas::CreateImage2D(builder,
+        &scalesFormat, width, height, sizeof(cl_float), schemas::PixelData_FloatArray, floatArray.Union());
+
+    return schemas::CreateQuantizedWeights(builder, valuesImg, scalesImg);
+}
@@ -11,6 +11,7 @@
 #include "system/SharedLib.h"
 #include "system/ComputeSystem.h"
 #include "system/ComputeProgram.h"
+#include "system/MappedFile.h"
 #include "schemas/Helpers_generated.h"
 
 #include <random>
@@ -59,6 +60,108 @@ namespace ogmaneo {
     DoubleBuffer3D createDoubleBuffer3D(ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType);
     //!@}
 
+    //!@{
+    /*!
+    \brief Image and double buffer copy helpers
+    Create new images with the same format and size as the source and copy its contents over (enqueued, not blocking).
+    */
+    cl::Image2D cloneImage2D(ComputeSystem &cs, const cl::Image2D &img);
+    cl::Image3D cloneImage3D(ComputeSystem &cs, const cl::Image3D &img);
+    DoubleBuffer2D cloneDoubleBuffer2D(ComputeSystem &cs, const DoubleBuffer2D &db);
+    DoubleBuffer3D cloneDoubleBuffer3D(ComputeSystem &cs, const DoubleBuffer3D &db);
+    //!@}
+
+    /*!
+    \brief Create a new kernel object for the same program and function (empty if the source is)
+    Kernel arguments are per object state, so objects that set arguments independently need their own kernels.
+    */
+    cl::Kernel cloneKernel(const cl::Kernel &kernel);
+
+    /*!
+    \brief Weight buffer
+    Weights are updated in place by the learning kernels (each work-item owns its weight slice), so they are not double buffered.
+    Laid out like an image3d of _size (x fastest, then y, then weight index), _channels floats per element.
+    Half precision buffers store fp16 values instead (kernels access them through loadWeight/storeWeight).
+    With the unit-major layout (ComputeSystem::_unitMajor) the weights of a unit are contiguous instead ([y][x][weight index]),
+    serialization always uses the image order.
+    */
+    struct WeightBuffer {
+        cl::Buffer _buffer;
+        cl_int3 _size;
+        int _channels;
+        bool _halfPrecision;
+        bool _unitMajor;
+
+        WeightBuffer()
+            : _size({ 0, 0, 0 }), _channels(1), _halfPrecision(false), _unitMajor(false)
+        {}
+
+        /*!
+        \brief Size of one value in bytes
+        */
+        size_t getValueSize() const {
+            return _halfPrecision ? sizeof(cl_half) : sizeof(cl_float);
+        }
+    };
+
+    /*!
+    \brief Quantized weight buffer
+    Frozen int8 copy of a weight buffer (first channel only) with one float scale per unit, same layout as WeightBuffer.
+    Weight = value * scale, only used by the quantized stimulus kernels (inference).
+    */
+    struct QuantizedWeightBuffer {
+        cl::Buffer _values;
+        cl::Buffer _scales;
+        cl_int3 _size;
+        bool _unitMajor;
+
+        QuantizedWeightBuffer()
+            : _size({ 0, 0, 0 }), _unitMajor(false)
+        {}
+    };
+
+    /*!
+    \brief Weight buffer creation helper
+    */
+    WeightBuffer createWeightBuffer(ComputeSystem &cs, cl_int3 size, int channels = 1, bool halfPrecision = false);
+
+    /*!
+    \brief Whether the device supports an image format (read-write) for the given image type
+    */
+    bool isImageFormatSupported(ComputeSystem &cs, cl_mem_object_type imageType, const cl::ImageFormat &format);
+
+    /*!
+    \brief Page-locked host staging memory for non-blocking transfers
+    Allocated by OpenCL (CL_MEM_ALLOC_HOST_PTR) and mapped once, the buffer itself is never used by commands.
+    */
+    struct PinnedHostBuffer {
+        cl::Buffer _buffer;
+        void* _ptr;
+        size_t _size;
+
+        PinnedHostBuffer()
+            : _ptr(nullptr), _size(0)
+        {}
+    };
+
+    /*!
+    \brief Pinned host buffer creation helper
+    */
+    PinnedHostBuffer createPinnedHostBuffer(ComputeSystem &cs, size_t size);
+
+    //!@{
+    /*!
+    \brief Host memory backed (CL_MEM_USE_HOST_PTR) single channel float images, for zero-copy transfers
+    The host may only access the memory while the image is mapped, and the device may only use the image while it is unmapped.
+    mapHostImage2D maps the whole image on the primary queue and returns the mapped pointer (derived from the host memory),
+    unmapHostImage2D hands it back to the device. On host-unified devices neither copies.
+    */
+    bool hasHostUnifiedMemory(ComputeSystem &cs);
+    cl::Image2D createHostImage2D(ComputeSystem &cs, cl_int2 size, float* hostPtr);
+    void* mapHostImage2D(ComputeSystem &cs, cl::Image2D &image2D, cl_int2 size, cl_map_flags flags, cl_bool blocking);
+    void unmapHostImage2D(ComputeSystem &cs, cl::Image2D &image2D, void* ptr);
+    //!@}
+
     //!@{
     /*!
     \brief Double buffer initialization helpers
@@ -70,11 +173,83 @@ namespace ogmaneo {
     void randomUniformXY(cl::Image3D &image3D, ComputeSystem &cs, cl::Kernel &randomUniform3DXYKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
     void randomUniformXZ(cl::Image2D &image2D, ComputeSystem &cs, cl::Kernel &randomUniform2DXZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
     void randomUniformXZ(cl::Image3D &image3D, ComputeSystem &cs, cl::Kernel &randomUniform3DXZKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
+    void randomUniform(WeightBuffer &weights, ComputeSystem &cs, cl::Kernel &randomUniformWeightsKernel, cl_float2 range, std::mt19937 &rng);
     //!@}
 
+    /*!
+    \brief Quantize a weight buffer to int8 with a scale per unit
+    */
+    QuantizedWeightBuffer quantize(const WeightBuffer &weights, ComputeSystem &cs, cl::Kernel &quantizeWeightsKernel);
+
+    /*!
+    \brief Local memory tile of a stimulus kernel launch
+    A work-group covers a tile of hidden units (ComputeSystem::getTileSize) and loads the visible patch
+    their receptive fields overlap into local memory once. Tiled kernels take the patch as two trailing arguments (local float*, int2 size).
+    */
+    struct LocalTile {
+        cl_int2 _visibleTileSize;
+        int _depth;
+        bool _enabled;
+
+        LocalTile()
+            : _visibleTileSize({ 0, 0 }), _depth(1), _enabled(false)
+        {}
+    };
+
+    /*!
+    \brief Get the local memory tile of a tiled stimulus kernel
+    Disabled if the device has no tile size, or the kernel or local memory cannot hold it (use the untiled kernel then).
+    \param hiddenToVisible visible units per hidden unit.
+    \param radius receptive field radius.
+    \param depth number of visible slices loaded (e.g. samples).
+    */
+    LocalTile getLocalTile(ComputeSystem &cs, cl::Kernel &tiledKernel, cl_float2 hiddenToVisible, int radius, int depth = 1);
+
+    /*!
+    \brief Set the tile arguments (from argIndex) of a tiled kernel and enqueue it over the hidden size rounded up to whole tiles
+    */
+    void enqueueTiled(ComputeSystem &cs, cl::Kernel &tiledKernel, int argIndex, const LocalTile &tile, cl_int2 hiddenSize);
+
+    /*!
+    \brief Whether a group reduction kernel (one work-group per chunk, parallel argmax) should be used for chunks of groupSize
+    False for small chunks (a work-item per chunk is cheaper) and chunks larger than the kernel work-group limit.
+    */
+    bool useGroupReduction(ComputeSystem &cs, cl::Kernel &groupKernel, cl_int2 groupSize);
+
+    /*!
+    \brief Set the argmax scratch arguments (from argIndex) of a group reduction kernel and enqueue it over numGroups work-groups of groupSize
+    */
+    void enqueueGroupReduction(ComputeSystem &cs, cl::Kernel &groupKernel, int argIndex, cl_int2 groupSize, cl_int2 numGroups);
+
+    /*!
+    \brief Fraction of units whose binary state (> 0.5) differs between two CL_R CL_FLOAT state images (blocking)
+    Used to compare approximate inhibition against the exact rule.
+    */
+    float getStateDisagreement(ComputeSystem &cs, const cl::Image2D &statesA, const cl::Image2D &statesB, cl_int2 size);
+
+    /*!
+    \brief Clamp an inhibition sampling stride to [1, radius]
+    Larger strides leave at most one sample per axis, often none in bounds.
+    */
+    int clampInhibitionStride(int stride, int radius);
+
+    /*!
+    \brief Builder storage for checkpoints
+    Grows the builder with realloc, which can extend the block in place instead of always allocating a larger one and copying.
+    When realloc has to move the block, old and new storage coexist while it copies, so saving can still peak at about
+    twice the checkpoint size on the last growth. The save helpers avoid the extra per-image host copies on top of that.
+    */
+    class CheckpointAllocator : public flatbuffers::Allocator {
+    public:
+        uint8_t* allocate(size_t size) override;
+        void deallocate(uint8_t* p, size_t size) override;
+        uint8_t* reallocate_downward(uint8_t* oldP, size_t oldSize, size_t newSize, size_t inUseBack, size_t inUseFront) override;
+    };
+
     //!@{
     /*!
     \brief Image and Double buffer serialization helpers
+    Device data is read straight into builder storage, without host staging copies (except for unit-major weights).
     */
     void load(cl::Image2D &img, const schemas::Image2D* fbImg, ComputeSystem &cs);
     void load(cl::Image3D &img, const schemas::Image3D* fbImg, ComputeSystem &cs);
@@ -86,4 +261,33 @@ namespace ogmaneo {
     flatbuffers::Offset<schemas::DoubleBuffer2D> save(DoubleBuffer2D &db, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
     flatbuffers::Offset<schemas::DoubleBuffer3D> save(DoubleBuffer3D &db, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
     //!@}
+
+    //!@{
+    /*!
+    \brief Scratch serialization helpers
+    Save like the regular helpers, except with the compact checkpoint profile, where nothing is written (null offset)
+    and the loaders leave the image as created. Only for images that are fully rewritten before they are read each step.
+    */
+    flatbuffers::Offset<schemas::Image2D> saveScratch(cl::Image2D &img, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
+    flatbuffers::Offset<schemas::DoubleBuffer2D> saveScratch(DoubleBuffer2D &db, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
+    //!@}
+
+    //!@{
+    /*!
+    \brief Weight buffer serialization helpers
+    Weights are stored as a DoubleBuffer3D for compatibility with double buffered checkpoints. Loading reads the back image
+    (the current weights), saving writes one image referenced by both front and back.
+    */
+    void load(WeightBuffer &weights, const schemas::DoubleBuffer3D* fbDB, ComputeSystem &cs);
+    flatbuffers::Offset<schemas::DoubleBuffer3D> save(WeightBuffer &weights, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
+    //!@}
+
+    //!@{
+    /*!
+    \brief Quantized weight buffer serialization helpers
+    Values are stored as a CL_SIGNED_INT8 image (ByteArray), scales as a CL_FLOAT image. Loading (re)creates the buffers.
+    */
+    void load(QuantizedWeightBuffer &weights, const schemas::QuantizedWeights* fbWeights, ComputeSystem &cs);
+    flatbuffers::Offset<schemas::QuantizedWeights> save(QuantizedWeightBuffer &weights, flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs);
+    //!@}
 }
\ No newline at end of file
@@ -9,64 +9,284 @@
 #include "Hierarchy.h"
 
 #include <assert.h>
+#include <cstring>
 
 using namespace ogmaneo;
 
 void Hierarchy::simStep(std::vector<ValueField2D> &inputs, bool learn) {
-    // Write input
-    for (int i = 0; i < _inputImages.size(); i++)
-        _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, inputs[i].getData().data());
-
-    _p.simStep(*_resources->_cs, _inputImages, _inputImages, _rng, learn);
+    // Sessions share their weights, they never learn
+    learn = learn && !_session;
 
-    // Get predictions
-    for (int i = 0; i < _predictions.size(); i++) {
-        _readoutLayers[i].activate(*_resources->_cs, { _p.getHiddenPrediction()[_back] }, _rng);
+    simStepWait();
 
-        if (learn)
-            _readoutLayers[i].learn(*_resources->_cs, _inputImages[i]);
+    writeInputs(inputs);
 
-        _readoutLayers[i].stepEnd(*_resources->_cs);
+    _p.simStep(*_resources->_cs, _inputImages, _inputImages, _rng, learn);
 
-        _resources->_cs->getQueue().enqueueReadImage(_readoutLayers[i].getHiddenStates()[_back], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(_predictions[i].getSize().x), static_cast<cl::size_type>(_predictions[i].getSize().y), 1 }, 0, 0, _predictions[i].getData().data());
-    }
+    readPredictions(learn);
 }
 
 void Hierarchy::simStep(std::vector<ValueField2D> &inputs, std::vector<ValueField2D> &corruptedInputs, bool learn) {
-    // Write input
-    for (int i = 0; i < _inputImages.size(); i++)
-        _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, inputs[i].getData().data());
+    // Sessions share their weights, they never learn
+    learn = learn && !_session;
+
+    simStepWait();
+
+    writeInputs(inputs);
 
     for (int i = 0; i < _corruptedInputImages.size(); i++)
         _resources->_cs->getQueue().enqueueWriteImage(_corruptedInputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(corruptedInputs[i].getSize().x), static_cast<cl::size_type>(corruptedInputs[i].getSize().y), 1 }, 0, 0, corruptedInputs[i].getData().data());
 
     _p.simStep(*_resources->_cs, _inputImages, _corruptedInputImages, _rng, learn);
 
-    // Get predictions
+    readPredictions(learn);
+}
+
+void Hierarchy::simStepDevice(bool learn) {
+    // Device side writers need device owned input images
+    assert(!_zeroCopy);
+
+    if (_zeroCopy)
+        return;
+
+    // Sessions share their weights, they never learn
+    learn = learn && !_session;
+
+    simStepWait();
+
+    _p.simStep(*_resources->_cs, _inputImages, _inputImages, _rng, learn);
+
+    readPredictions(learn, false);
+}
+
+void Hierarchy::writeInputs(const std::vector<ValueField2D> &inputs) {
+    for (int i = 0; i < _inputImages.size(); i++) {
+        cl_int2 size = { inputs[i].getSize().x, inputs[i].getSize().y };
+
+        if (_zeroCopy) {
+            // Images alias the (host owned) input fields, only copy if given other fields
+            if (&inputs[i] != &_inputFields[i])
+                std::memcpy(_inputFields[i].getData().data(), inputs[i].getData().data(), inputs[i].getData().size() * sizeof(float));
+        }
+        else
+            _resources->_cs->getQueue().enqueueWriteImage(_inputImages[i], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 }, 0, 0, inputs[i].getData().data());
+    }
+
+    // Hand the input fields to the device for the step
+    if (_zeroCopy)
+        unmapInputImages();
+}
+
+void Hierarchy::readPredictions(bool learn, bool readBack, bool toStaging, cl_bool blocking) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    // The copies below write the prediction images, the device has to own them first
+    if (_zeroCopy && readBack)
+        unmapPredictionImages();
+
+    // Read out layers are independent of each other
+    cs.fork();
+
     for (int i = 0; i < _predictions.size(); i++) {
-        _readoutLayers[i].activate(*_resources->_cs, { _p.getHiddenPrediction()[_back] }, _rng);
+        cs.selectQueue(i);
+
+        _readoutLayers[i].activate(cs, { _p.getHiddenPrediction()[_back] }, _rng);
 
         if (learn)
-            _readoutLayers[i].learn(*_resources->_cs, _inputImages[i]);
+            _readoutLayers[i].learn(cs, _inputImages[i]);
+
+        _readoutLayers[i].stepEnd(cs);
+
+        if (!readBack)
+            continue;
+
+        cl::array<cl::size_type, 3> region = { static_cast<cl::size_type>(_predictions[i].getSize().x), static_cast<cl::size_type>(_predictions[i].getSize().y), 1 };
+
+        if (_zeroCopy)
+            cs.getQueue().enqueueCopyImage(_readoutLayers[i].getHiddenStates()[_back], _predictionImages[i], { 0, 0, 0 }, { 0, 0, 0 }, region);
+        else
+            cs.getQueue().enqueueReadImage(_readoutLayers[i].getHiddenStates()[_back], CL_FALSE, { 0, 0, 0 }, region, 0, 0,
+                toStaging ? _predictionStaging[i]._ptr : _predictions[i].getData().data());
+    }
+
+    cs.join();
+
+    // Back to the host once the step is done (mapped before any marker the caller adds)
+    if (_zeroCopy) {
+        mapHostImages(CL_MAP_WRITE_INVALIDATE_REGION, blocking);
+
+        return;
+    }
+
+    if (!readBack || !blocking)
+        return;
+
+    cs.getQueue().finish();
+}
+
+void Hierarchy::mapHostImages(cl_map_flags inputFlags, cl_bool blocking) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    for (int i = 0; i < _inputImages.size(); i++) {
+        if (_inputMaps[i] == nullptr)
+            _inputMaps[i] = mapHostImage2D(cs, _inputImages[i], { _inputFields[i].getSize().x, _inputFields[i].getSize().y }, inputFlags, blocking);
+    }
+
+    // Also writable, load overwrites the predictions on the host
+    for (int i = 0; i < _predictionImages.size(); i++) {
+        if (_predictionMaps[i] == nullptr)
+            _predictionMaps[i] = mapHostImage2D(cs, _predictionImages[i], { _predictions[i].getSize().x, _predictions[i].getSize().y }, CL_MAP_READ | CL_MAP_WRITE, blocking);
+    }
+}
+
+void Hierarchy::unmapInputImages() {
+    for (int i = 0; i < _inputImages.size(); i++) {
+        if (_inputMaps[i] != nullptr) {
+            unmapHostImage2D(*_resources->_cs, _inputImages[i], _inputMaps[i]);
+
+            _inputMaps[i] = nullptr;
+        }
+    }
+}
+
+void Hierarchy::unmapPredictionImages() {
+    for (int i = 0; i < _predictionImages.size(); i++) {
+        if (_predictionMaps[i] != nullptr) {
+            unmapHostImage2D(*_resources->_cs, _predictionImages[i], _predictionMaps[i]);
+
+            _predictionMaps[i] = nullptr;
+        }
+    }
+}
+
+bool Hierarchy::setZeroCopy(bool zeroCopy) {
+    ComputeSystem &cs = *_resources->_cs;
+
+    if (zeroCopy == _zeroCopy || (zeroCopy && !hasHostUnifiedMemory(cs)))
+        return _zeroCopy;
+
+    simStepWait();
+
+    if (zeroCopy) {
+        _inputFields.resize(_inputImages.size());
 
-        _readoutLayers[i].stepEnd(*_resources->_cs);
+        for (int i = 0; i < _inputImages.size(); i++) {
+            cl_int2 size = { static_cast<cl_int>(_inputImages[i].getImageInfo<CL_IMAGE_WIDTH>()), static_cast<cl_int>(_inputImages[i].getImageInfo<CL_IMAGE_HEIGHT>()) };
 
-        _resources->_cs->getQueue().enqueueReadImage(_readoutLayers[i].getHiddenStates()[_back], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(_predictions[i].getSize().x), static_cast<cl::size_type>(_predictions[i].getSize().y), 1 }, 0, 0, _predictions[i].getData().data());
+            _inputFields[i].create(Vec2i(size.x, size.y));
+
+            _inputImages[i] = createHostImage2D(cs, size, _inputFields[i].getData().data());
+        }
+
+        _predictionImages.resize(_predictions.size());
+
+        for (int i = 0; i < _predictions.size(); i++)
+            _predictionImages[i] = createHostImage2D(cs, { _predictions[i].getSize().x, _predictions[i].getSize().y }, _predictions[i].getData().data());
+
+        _inputMaps.assign(_inputImages.size(), nullptr);
+        _predictionMaps.assign(_predictionImages.size(), nullptr);
+
+        // The host owns them until the next step
+        mapHostImages(CL_MAP_WRITE_INVALIDATE_REGION, CL_TRUE);
+    }
+    else {
+        unmapInputImages();
+        unmapPredictionImages();
+
+        // The host memory is released below
+        cs.getPrimaryQueue().finish();
+
+        for (int i = 0; i < _inputImages.size(); i++)
+            _inputImages[i] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _inputFields[i].getSize().x, _inputFields[i].getSize().y);
+
+        _inputFields.clear();
+        _predictionImages.clear();
+        _inputMaps.clear();
+        _predictionMaps.clear();
+    }
+
+    _zeroCopy = zeroCopy;
+
+    return _zeroCopy;
+}
+
+cl::Event Hierarchy::simStepAsync(const std::vector<ValueField2D> &inputs, bool learn) {
+    // Sessions share their weights, they never learn
+    learn = learn && !_session;
+
+    // Only one step in flight, so staging can be reused
+    simStepWait();
+
+    ComputeSystem &cs = *_resources->_cs;
+
+    if (_inputStaging.empty() && !_zeroCopy) {
+        for (int i = 0; i < _inputImages.size(); i++)
+            _inputStaging.push_back(createPinnedHostBuffer(cs, inputs[i].getData().size() * sizeof(float)));
+
+        for (int i = 0; i < _predictions.size(); i++)
+            _predictionStaging.push_back(createPinnedHostBuffer(cs, _predictions[i].getData().size() * sizeof(float)));
+    }
+
+    // Write input
+    if (_zeroCopy)
+        writeInputs(inputs);
+    else {
+        for (int i = 0; i < _inputImages.size(); i++) {
+            std::memcpy(_inputStaging[i]._ptr, inputs[i].getData().data(), _inputStaging[i]._size);
+
+            cs.getQueue().enqueueWriteImage(_inputImages[i], CL_FALSE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputs[i].getSize().x), static_cast<cl::size_type>(inputs[i].getSize().y), 1 }, 0, 0, _inputStaging[i]._ptr);
+        }
+    }
+
+    _p.simStep(cs, _inputImages, _inputImages, _rng, learn);
+
+    // Zero-copy predictions are mapped back before the marker, so the host owns them again after simStepWait
+    readPredictions(learn, true, true, CL_FALSE);
+
+    cs.getQueue().enqueueMarkerWithWaitList(nullptr, &_stepEvent);
+    cs.getQueue().flush();
+
+    _stepPending = true;
+
+    return _stepEvent;
+}
+
+void Hierarchy::simStepWait() {
+    if (!_stepPending)
+        return;
+
+    _stepEvent.wait();
+
+    // Zero-copy predictions are already in place
+    if (!_zeroCopy) {
+        for (int i = 0; i < _predictions.size(); i++)
+            std::memcpy(_predictions[i].getData().data(), _predictionStaging[i]._ptr, _predictionStaging[i]._size);
     }
+
+    _stepPending = false;
 }
 
 void Hierarchy::load(const schemas::Hierarchy* fbHierarchy, ComputeSystem &cs) {
     assert(_inputImages.size() == fbHierarchy->_inputImages()->Length());
-    assert(_corruptedInputImages.size() == fbHierarchy->_corruptedInputImages()->Length());
+    // Compact checkpoints leave the corrupted inputs out
+    assert(fbHierarchy->_corruptedInputImages()->Length() == 0 || _corruptedInputImages.size() == fbHierarchy->_corruptedInputImages()->Length());
     assert(_predictions.size() == fbHierarchy->_predictions()->Length());
     assert(_readoutLayers.size() == fbHierarchy->_readoutLayers()->Length());
 
     _p.load(fbHierarchy->_p(), cs);
 
+    // Input images are written through the device
+    if (_zeroCopy)
+        unmapInputImages();
+
     for (flatbuffers::uoffset_t i = 0; i < fbHierarchy->_inputImages()->Length(); i++) {
         ogmaneo::load(_inputImages[i], fbHierarchy->_inputImages()->Get(i), cs);
     }
 
+    // Keeping the loaded contents
+    if (_zeroCopy)
+        mapHostImages(CL_MAP_WRITE, CL_TRUE);
+
     for (flatbuffers::uoffset_t i = 0; i < fbHierarchy->_corruptedInputImages()->Length(); i++) {
         ogmaneo::load(_corruptedInputImages[i], fbHierarchy->_corruptedInputImages()->Get(i), cs);
     }
@@ -81,20 +301,30 @@ void Hierarchy::load(const schemas::Hierarchy* fbHierarchy, ComputeSystem &cs) {
 }
 
 flatbuffers::Offset<schemas::Hierarchy> Hierarchy::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
+    // Input images are read through the device
+    if (_zeroCopy)
+        unmapInputImages();
+
     std::vector<flatbuffers::Offset<schemas::Image2D>> inputImages;
-    for (cl::Image2D image : _inputImages)
+    for (cl::Image2D &image : _inputImages)
         inputImages.push_back(ogmaneo::save(image, builder, cs));
 
+    if (_zeroCopy)
+        mapHostImages(CL_MAP_WRITE, CL_TRUE);
+
+    // Corrupted inputs are written every step they are used, compact checkpoints leave them out
     std::vector<flatbuffers::Offset<schemas::Image2D>> corruptedInputImages;
-    for (cl::Image2D image : _corruptedInputImages)
-        corruptedInputImages.push_back(ogmaneo::save(image, builder, cs));
+    if (cs.getCheckpointProfile() != ComputeSystem::_compact) {
+        for (cl::Image2D &image : _corruptedInputImages)
+            corruptedInputImages.push_back(ogmaneo::save(image, builder, cs));
+    }
 
     std::vector<flatbuffers::Offset<schemas::ValueField2D>> predictions;
-    for (ValueField2D values : _predictions)
+    for (ValueField2D &values : _predictions)
         predictions.push_back(values.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::PredictorLayer>> readoutLayers;
-    for (PredictorLayer layer : _readoutLayers)
+    for (PredictorLayer &layer : _readoutLayers)
         readoutLayers.push_back(layer.save(builder, cs));
 
     return schemas::CreateHierarchy(builder,
@@ -106,22 +336,20 @@ flatbuffers::Offset<schemas::Hierarchy> Hierarchy::save(flatbuffers::FlatBufferB
 }
 
 void Hierarchy::load(ComputeSystem &cs, const std::string &fileName) {
-    FILE* file = fopen(fileName.c_str(), "rb");
-    fseek(file, 0L, SEEK_END);
-    size_t length = ftell(file);
-    fseek(file, 0L, SEEK_SET);
-    std::vector<uint8_t> data(length);
-    fread(data.data(), sizeof(uint8_t), length, file);
-    fclose(file);
+    // Device uploads read straight from the mapping
+    MappedFile file;
+
+    if (!file.open(fileName))
+        return;
 
-    flatbuffers::Verifier verifier = flatbuffers::Verifier(data.data(), length);
+    flatbuffers::Verifier verifier = flatbuffers::Verifier(file.getData(), file.getSize());
 
     bool verified =
         schemas::VerifyHierarchyBuffer(verifier) |
-        schemas::HierarchyBufferHasIdentifier(data.data());
+        schemas::HierarchyBufferHasIdentifier(file.getData());
 
     if (verified) {
-        const schemas::Hierarchy* h = schemas::GetHierarchy(data.data());
+        const schemas::Hierarchy* h = schemas::GetHierarchy(file.getData());
 
         load(h, cs);
     }
@@ -130,7 +358,9 @@ void Hierarchy::load(ComputeSystem &cs, const std::string &fileName) {
 }
 
 void Hierarchy::save(ComputeSystem &cs, const std::string &fileName) {
-    flatbuffers::FlatBufferBuilder builder;
+    CheckpointAllocator allocator;
+
+    flatbuffers::FlatBufferBuilder builder(1024, &allocator);
 
     flatbuffers::Offset<schemas::Hierarchy> h = save(builder, cs);
 
@@ -156,6 +386,54 @@ void Hierarchy::save(ComputeSystem &cs, const std::string &fileName) {
     return; //verified;
 }
 
+std::shared_ptr<Hierarchy> Hierarchy::createSession() {
+    simStepWait();
+
+    ComputeSystem &cs = *_resources->_cs;
+
+    std::shared_ptr<Hierarchy> session = std::make_shared<Hierarchy>();
+
+    session->_p = _p.createSession(cs);
+    session->_rng = _rng;
+    session->_predictions = _predictions;
+    session->_resources = _resources;
+    session->_session = true;
+
+    // Fresh device images, also when this hierarchy is in zero-copy mode
+    session->_inputImages.resize(_inputImages.size());
+
+    for (int i = 0; i < _inputImages.size(); i++)
+        session->_inputImages[i] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _inputImages[i].getImageInfo<CL_IMAGE_WIDTH>(), _inputImages[i].getImageInfo<CL_IMAGE_HEIGHT>());
+
+    session->_corruptedInputImages.resize(_corruptedInputImages.size());
+
+    for (int i = 0; i < _corruptedInputImages.size(); i++)
+        session->_corruptedInputImages[i] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _corruptedInputImages[i].getImageInfo<CL_IMAGE_WIDTH>(), _corruptedInputImages[i].getImageInfo<CL_IMAGE_HEIGHT>());
+
+    session->_readoutLayers.resize(_readoutLayers.size());
+
+    for (int i = 0; i < _readoutLayers.size(); i++)
+        session->_readoutLayers[i] = _readoutLayers[i].createSession(cs, nullptr);
+
+    // Working memory copies are enqueued
+    cs.getQueue().finish();
+
+    return session;
+}
+
+void Hierarchy::quantize() {
+    simStepWait();
+
+    ComputeSystem &cs = *_resources->_cs;
+
+    _p.quantize(cs);
+
+    for (int i = 0; i < _readoutLayers.size(); i++)
+        _readoutLayers[i].quantize(cs);
+
+    cs.getQueue().finish();
+}
+
 void Hierarchy::readChunkStates(int li, ValueField2D &valueField) {
     assert(getPredictor().getHierarchy().getLayer(li)._sf->_type == _chunk);
 
@@ -40,6 +40,54 @@ namespace ogmaneo {
 
         std::vector<PredictorLayer> _readoutLayers;
 
+        //!@{
+        /*!
+        \brief Asynchronous step state, staging is created on first use
+        */
+        std::vector<PinnedHostBuffer> _inputStaging;
+        std::vector<PinnedHostBuffer> _predictionStaging;
+        cl::Event _stepEvent;
+        bool _stepPending;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Zero-copy state, input and prediction images alias host memory
+        The host owns (has mapped) the input fields and predictions between steps, the device owns them during a step.
+        Map pointers are nullptr while the device owns an image.
+        */
+        bool _zeroCopy;
+        std::vector<ValueField2D> _inputFields;
+        std::vector<cl::Image2D> _predictionImages;
+        std::vector<void*> _inputMaps;
+        std::vector<void*> _predictionMaps;
+        //!@}
+
+        /*!
+        \brief Whether this is an inference session (created by createSession), sessions never learn
+        */
+        bool _session;
+
+        //!@{
+        /*!
+        \brief Step helpers
+        readPredictions steps the read out layers and reads the predictions into _predictions or the pinned staging buffers.
+        Non-blocking reads are complete once a marker enqueued afterwards is.
+        */
+        void writeInputs(const std::vector<ValueField2D> &inputs);
+        void readPredictions(bool learn, bool readBack = true, bool toStaging = false, cl_bool blocking = CL_TRUE);
+        //!@}
+
+        //!@{
+        /*!
+        \brief Zero-copy ownership transfers
+        mapHostImages maps all device owned input (with inputFlags) and prediction images back to the host.
+        */
+        void mapHostImages(cl_map_flags inputFlags, cl_bool blocking);
+        void unmapInputImages();
+        void unmapPredictionImages();
+        //!@}
+
         //!@{
         /*!
         \brief Serialization
@@ -49,12 +97,51 @@ namespace ogmaneo {
         //!@}
 
     public:
+        Hierarchy()
+            : _stepPending(false), _zeroCopy(false), _session(false)
+        {}
+
         /*!
         \brief Run a single simulation tick
         */
         void simStep(std::vector<ValueField2D> &inputs, bool learn = true);
         void simStep(std::vector<ValueField2D> &inputs, std::vector<ValueField2D> &corruptedInputs, bool learn = true);
 
+        /*!
+        \brief Run a single simulation tick on the input images as they are on the device
+        For inputs written by device side encoders (see DeviceScalarEncoder). Predictions are not read back,
+        use getDevicePrediction instead of getPredictions. Not available in zero-copy mode (the host owns the inputs).
+        */
+        void simStepDevice(bool learn = true);
+
+        /*!
+        \brief Start a simulation tick without waiting for it
+        Inputs are copied to pinned staging memory, so they may be modified as soon as this returns.
+        Predictions are only updated by simStepWait. The returned event completes when the step (including readback) is done.
+        In zero-copy mode the inputs are copied to the input fields instead, which (like the predictions) belong to the device until simStepWait.
+        */
+        cl::Event simStepAsync(const std::vector<ValueField2D> &inputs, bool learn = true);
+
+        /*!
+        \brief Wait for the step started by simStepAsync and update the predictions, no-op if none is pending
+        */
+        void simStepWait();
+
+        /*!
+        \brief Back the input images and predictions with host memory (CL_MEM_USE_HOST_PTR)
+        Only enabled on devices with host-unified memory, returns whether zero-copy is active.
+        Pass getInputFields() to simStep so inputs are not copied at all. Their previous contents are not kept
+        across steps (the host maps them with CL_MAP_WRITE_INVALIDATE_REGION), so every value has to be written before each step.
+        */
+        bool setZeroCopy(bool zeroCopy);
+
+        /*!
+        \brief Get the host input fields used in zero-copy mode
+        */
+        std::vector<ValueField2D> &getInputFields() {
+            return _inputFields;
+        }
+
         /*!
         \brief Get the input images
         */
@@ -76,6 +163,13 @@ namespace ogmaneo {
             return _predictions;
         }
 
+        /*!
+        \brief Get the device image holding prediction i (CL_R CL_FLOAT), valid until the next step
+        */
+        const cl::Image2D &getDevicePrediction(int i) const {
+            return _readoutLayers[i].getHiddenStates()[_back];
+        }
+
         /*!
         \brief Access underlying Predictor
         */
@@ -90,6 +184,22 @@ namespace ogmaneo {
             return _readoutLayers;
         }
 
+        /*!
+        \brief Create an inference session
+        The session shares all weights with this hierarchy and only owns the working memory (states, traces,
+        pooling buffers, sample histories), scratch buffers, kernels and its input and prediction buffers.
+        Weights are read-only to sessions, the learn argument of the step functions is ignored for them.
+        Queue selection lives in the ComputeSystem, so hierarchies sharing one must be stepped from one thread at a time.
+        */
+        std::shared_ptr<Hierarchy> createSession();
+
+        /*!
+        \brief Quantize the hierarchy for inference (int8 weights with a scale per unit)
+        Replaces the full precision weights of the predictor layers, chunk encoders and read out layers, reducing weight
+        memory and bandwidth by 4x. The hierarchy is then frozen, step it with learn = false. Saved files keep the quantized form.
+        */
+        void quantize();
+
         /*!
         \brief Specifically for accessing chunk states from bindings
         */
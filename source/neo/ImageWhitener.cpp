@@ -16,19 +16,68 @@ void ImageWhitener::create(ComputeSystem &cs, ComputeProgram &program, cl_int2 i
 
     _result = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(imageFormat, imageType), imageSize.x, imageSize.y);
 
+    size_t prefixSize = static_cast<size_t>(imageSize.x) * imageSize.y * sizeof(cl_float4);
+
+    _rowPrefix = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, prefixSize);
+    _boxPrefix = cl::Buffer(cs.getContext(), CL_MEM_READ_WRITE, prefixSize);
+
     _whitenKernel = cl::Kernel(program.getProgram(), "whiten");
+    _whitenRowPrefixKernel = cl::Kernel(program.getProgram(), "whitenRowPrefix");
+    _whitenColumnPrefixKernel = cl::Kernel(program.getProgram(), "whitenColumnPrefix");
+    _whitenSummedAreaKernel = cl::Kernel(program.getProgram(), "whitenSummedArea");
 }
 
 void ImageWhitener::filter(ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity) {
-    int argIndex = 0;
+    if (!_summedArea) {
+        int argIndex = 0;
+
+        _whitenKernel.setArg(argIndex++, input);
+        _whitenKernel.setArg(argIndex++, _result);
+        _whitenKernel.setArg(argIndex++, _imageSize);
+        _whitenKernel.setArg(argIndex++, kernelRadius);
+        _whitenKernel.setArg(argIndex++, intensity);
 
-    _whitenKernel.setArg(argIndex++, input);
-    _whitenKernel.setArg(argIndex++, _result);
-    _whitenKernel.setArg(argIndex++, _imageSize);
-    _whitenKernel.setArg(argIndex++, kernelRadius);
-    _whitenKernel.setArg(argIndex++, intensity);
+        cs.getQueue().enqueueNDRangeKernel(_whitenKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+
+        return;
+    }
+
+    // Row prefix sums
+    {
+        int argIndex = 0;
+
+        _whitenRowPrefixKernel.setArg(argIndex++, input);
+        _whitenRowPrefixKernel.setArg(argIndex++, _rowPrefix);
+        _whitenRowPrefixKernel.setArg(argIndex++, _imageSize);
+
+        cs.getQueue().enqueueNDRangeKernel(_whitenRowPrefixKernel, cl::NullRange, cl::NDRange(_imageSize.y));
+    }
 
-    cs.getQueue().enqueueNDRangeKernel(_whitenKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+    // Column prefix sums of horizontal box sums
+    {
+        int argIndex = 0;
+
+        _whitenColumnPrefixKernel.setArg(argIndex++, _rowPrefix);
+        _whitenColumnPrefixKernel.setArg(argIndex++, _boxPrefix);
+        _whitenColumnPrefixKernel.setArg(argIndex++, _imageSize);
+        _whitenColumnPrefixKernel.setArg(argIndex++, kernelRadius);
+
+        cs.getQueue().enqueueNDRangeKernel(_whitenColumnPrefixKernel, cl::NullRange, cl::NDRange(_imageSize.x));
+    }
+
+    // Whiten
+    {
+        int argIndex = 0;
+
+        _whitenSummedAreaKernel.setArg(argIndex++, input);
+        _whitenSummedAreaKernel.setArg(argIndex++, _boxPrefix);
+        _whitenSummedAreaKernel.setArg(argIndex++, _result);
+        _whitenSummedAreaKernel.setArg(argIndex++, _imageSize);
+        _whitenSummedAreaKernel.setArg(argIndex++, kernelRadius);
+        _whitenSummedAreaKernel.setArg(argIndex++, intensity);
+
+        cs.getQueue().enqueueNDRangeKernel(_whitenSummedAreaKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+    }
 }
 
 void ImageWhitener::load(const schemas::ImageWhitener* fbImageWhitener, ComputeSystem &cs, ComputeProgram& prog) {
@@ -50,10 +99,12 @@ void ImageWhitener::load(const schemas::ImageWhitener* fbImageWhitener, ComputeS
     }
 
     ogmaneo::load(_result, fbImage, cs);
+
+    _summedArea = fbImageWhitener->_summedArea();
 }
 
 flatbuffers::Offset<schemas::ImageWhitener> ImageWhitener::save(flatbuffers::FlatBufferBuilder& builder, ComputeSystem &cs) {
     schemas::int2 imageSize(_imageSize.x, _imageSize.y);
 
-    return schemas::CreateImageWhitener(builder, &imageSize, ogmaneo::save(_result, builder, cs));
+    return schemas::CreateImageWhitener(builder, &imageSize, ogmaneo::save(_result, builder, cs), _summedArea);
 }
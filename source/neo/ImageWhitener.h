@@ -21,10 +21,24 @@ namespace ogmaneo {
     */
     class OGMA_API ImageWhitener {
     private:
+        //!@{
         /*!
         \brief Kernels
         */
         cl::Kernel _whitenKernel;
+        cl::Kernel _whitenRowPrefixKernel;
+        cl::Kernel _whitenColumnPrefixKernel;
+        cl::Kernel _whitenSummedAreaKernel;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Summed area path, per pixel cost independent of the kernel radius, and its prefix sum buffers (float4 per pixel)
+        */
+        bool _summedArea;
+        cl::Buffer _rowPrefix;
+        cl::Buffer _boxPrefix;
+        //!@}
 
         /*!
         \brief Resulting whitened image
@@ -37,6 +51,10 @@ namespace ogmaneo {
         cl_int2 _imageSize;
 
     public:
+        ImageWhitener()
+            : _summedArea(false)
+        {}
+
         /*!
         \brief Create the image whitener.
         Requires the image size and format, and ComputeProgram loaded with the extra kernel code (see ComputeProgram::loadExtraKernel).
@@ -57,6 +75,21 @@ namespace ogmaneo {
         */
         void filter(ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity = 1024.0f);
 
+        /*!
+        \brief Select the summed area table path for filter
+        Gives the same result as the direct path up to float rounding, worth it from a kernel radius of ~3 on.
+        */
+        void setSummedArea(bool summedArea) {
+            _summedArea = summedArea;
+        }
+
+        /*!
+        \brief Whether filter uses the summed area table path
+        */
+        bool getSummedArea() const {
+            return _summedArea;
+        }
+
         /*!
         \brief Return filtered image result
         */
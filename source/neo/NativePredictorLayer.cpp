@@ -0,0 +1,210 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "NativePredictorLayer.h"
+
+#include <algorithm>
+
+using namespace ogmaneo;
+
+namespace {
+    // Rows of hidden units per pool task
+    const int minRowsPerTask = 4;
+
+    // Same as project in neoKernelsCommon.cl
+    int project(int position, float toScalar) {
+        return static_cast<int>((position + 0.5f) * toScalar);
+    }
+}
+
+void NativePredictorLayer::createRandom(ComputeSystem &cs, cl_int2 hiddenSize, const std::vector<VisibleLayerDesc> &visibleLayerDescs,
+    cl_float2 initWeightRange, std::mt19937 &rng)
+{
+    _visibleLayerDescs = visibleLayerDescs;
+
+    _hiddenSize = hiddenSize;
+
+    int numHidden = _hiddenSize.x * _hiddenSize.y;
+
+    _visibleLayers.resize(_visibleLayerDescs.size());
+
+    std::uniform_real_distribution<float> weightDist(initWeightRange.x, initWeightRange.y);
+
+    // Create layers
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+        VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+        vl._hiddenToVisible = cl_float2{ static_cast<float>(vld._size.x) / static_cast<float>(_hiddenSize.x),
+            static_cast<float>(vld._size.y) / static_cast<float>(_hiddenSize.y)
+        };
+
+        int weightDiam = vld._radius * 2 + 1;
+
+        vl._weights.resize(numHidden * weightDiam * weightDiam);
+
+        for (int i = 0; i < vl._weights.size(); i++)
+            vl._weights[i] = weightDist(rng);
+
+        int numVisible = vld._size.x * vld._size.y;
+
+        vl._derivedInput[_front].assign(numVisible * 2, 0.0f);
+        vl._derivedInput[_back].assign(numVisible * 2, 0.0f);
+    }
+
+    // Hidden state data
+    _hiddenSummation.assign(numHidden, 0.0f);
+
+    _hiddenStates[_front].assign(numHidden, 0.0f);
+    _hiddenStates[_back].assign(numHidden, 0.0f);
+}
+
+void NativePredictorLayer::activate(ComputeSystem &cs, const std::vector<std::vector<float>> &visibleStates) {
+    std::fill(_hiddenSummation.begin(), _hiddenSummation.end(), 0.0f);
+
+    // Find up stimulus
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+        VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+        int numVisible = vld._size.x * vld._size.y;
+
+        // Derive inputs
+        {
+            const float* inputs = visibleStates[vli].data();
+            const float* inputsPrev = vl._derivedInput[_back].data();
+            float* derived = vl._derivedInput[_front].data();
+
+            for (int i = 0; i < numVisible; i++) {
+                derived[i] = inputs[i];
+                derived[numVisible + i] = std::max(0.0f, inputs[i] - inputsPrev[i]);
+            }
+        }
+
+        const float* states = vl._derivedInput[_front].data();
+        const float* weights = vl._weights.data();
+        float* summation = _hiddenSummation.data();
+
+        int radius = vld._radius;
+        int weightDiam = radius * 2 + 1;
+        int numWeights = weightDiam * weightDiam;
+
+        cl_int2 visibleSize = vld._size;
+        cl_int2 hiddenSize = _hiddenSize;
+        cl_float2 hiddenToVisible = vl._hiddenToVisible;
+
+        cs.getPool().parallelFor(0, _hiddenSize.y, [&](int first, int last) {
+            for (int hy = first; hy < last; hy++) {
+                int cy = project(hy, hiddenToVisible.y);
+
+                int dyLow = std::max(-radius, -cy);
+                int dyHigh = std::min(radius, visibleSize.y - 1 - cy);
+
+                for (int hx = 0; hx < hiddenSize.x; hx++) {
+                    int cx = project(hx, hiddenToVisible.x);
+
+                    int dxLow = std::max(-radius, -cx);
+                    int dxHigh = std::min(radius, visibleSize.x - 1 - cx);
+
+                    int hiddenIndex = hx + hy * hiddenSize.x;
+
+                    const float* unitWeights = weights + hiddenIndex * numWeights;
+
+                    float subSum = 0.0f;
+                    float stateSum = 0.0f;
+
+                    for (int dy = dyLow; dy <= dyHigh; dy++) {
+                        const float* stateRow = states + cx + (cy + dy) * visibleSize.x;
+                        const float* weightRow = unitWeights + radius + (dy + radius) * weightDiam;
+
+                        for (int dx = dxLow; dx <= dxHigh; dx++) {
+                            subSum += stateRow[dx] * weightRow[dx];
+                            stateSum += stateRow[dx];
+                        }
+                    }
+
+                    summation[hiddenIndex] += subSum / std::max(0.0001f, stateSum);
+                }
+            }
+        }, minRowsPerTask);
+    }
+
+    // No inhibiting encoder, the summation is the prediction
+    _hiddenStates[_front] = _hiddenSummation;
+}
+
+void NativePredictorLayer::stepEnd(ComputeSystem &cs) {
+    std::swap(_hiddenStates[_front], _hiddenStates[_back]);
+
+    // Swap buffers
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+
+        std::swap(vl._derivedInput[_front], vl._derivedInput[_back]);
+    }
+}
+
+void NativePredictorLayer::learn(ComputeSystem &cs, const std::vector<float> &targets) {
+    // Learn weights
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+        VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+        int numVisible = vld._size.x * vld._size.y;
+
+        const float* statesPrev = vl._derivedInput[_back].data();
+        const float* hiddenStatesPrev = _hiddenStates[_back].data();
+        float* weights = vl._weights.data();
+
+        int radius = vld._radius;
+        int weightDiam = radius * 2 + 1;
+        int numWeights = weightDiam * weightDiam;
+
+        float alpha = vld._alpha;
+
+        cl_int2 visibleSize = vld._size;
+        cl_int2 hiddenSize = _hiddenSize;
+        cl_float2 hiddenToVisible = vl._hiddenToVisible;
+
+        cs.getPool().parallelFor(0, _hiddenSize.y, [&](int first, int last) {
+            for (int hy = first; hy < last; hy++) {
+                int cy = project(hy, hiddenToVisible.y);
+
+                int dyLow = std::max(-radius, -cy);
+                int dyHigh = std::min(radius, visibleSize.y - 1 - cy);
+
+                for (int hx = 0; hx < hiddenSize.x; hx++) {
+                    int cx = project(hx, hiddenToVisible.x);
+
+                    int dxLow = std::max(-radius, -cx);
+                    int dxHigh = std::min(radius, visibleSize.x - 1 - cx);
+
+                    int hiddenIndex = hx + hy * hiddenSize.x;
+
+                    float alphaError = alpha * (targets[hiddenIndex] - hiddenStatesPrev[hiddenIndex]);
+
+                    float* unitWeights = weights + hiddenIndex * numWeights;
+
+                    for (int dy = dyLow; dy <= dyHigh; dy++) {
+                        const float* stateRow = statesPrev + cx + (cy + dy) * visibleSize.x;
+                        const float* deltaRow = stateRow + numVisible;
+                        float* weightRow = unitWeights + radius + (dy + radius) * weightDiam;
+
+                        for (int dx = dxLow; dx <= dxHigh; dx++)
+                            weightRow[dx] += alphaError * stateRow[dx] * deltaRow[dx];
+                    }
+                }
+            }
+        }, minRowsPerTask);
+    }
+}
+
+void NativePredictorLayer::clearMemory(ComputeSystem &cs) {
+    // Clear buffers
+    std::fill(_hiddenStates[_back].begin(), _hiddenStates[_back].end(), 0.0f);
+}
\ No newline at end of file
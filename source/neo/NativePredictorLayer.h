@@ -0,0 +1,152 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "system/SharedLib.h"
+#include "PredictorLayer.h"
+
+#include <array>
+#include <vector>
+
+namespace ogmaneo {
+    /*!
+    \brief Native predictor layer.
+    Host implementation of PredictorLayer (without an inhibiting encoder) for ComputeSystems created with the _native device type.
+    Runs the plDeriveInputs, plStimulus and plLearnPredWeights kernels as loops split over the thread pool.
+    All values are row-major float arrays (x fastest). The weights of a hidden unit are contiguous and row-major over its field,
+    so the inner loops run over contiguous memory and vectorize.
+    This is the only native layer so far, the encoders, FeatureHierarchy and AgentSwarm kernels still require an OpenCL device.
+    */
+    class OGMA_API NativePredictorLayer {
+    public:
+        /*!
+        \brief Layer descriptor, same as the OpenCL layer's
+        */
+        typedef PredictorLayer::VisibleLayerDesc VisibleLayerDesc;
+
+        /*!
+        \brief Layer
+        */
+        struct VisibleLayer {
+            //!@{
+            /*!
+            \brief Layer parameters
+            Derived inputs hold two planes, the input and its positive change since the previous step.
+            */
+            std::array<std::vector<float>, 2> _derivedInput;
+
+            std::vector<float> _weights;
+
+            cl_float2 _hiddenToVisible;
+            //!@}
+        };
+
+    private:
+        /*!
+        \brief Size of the prediction
+        */
+        cl_int2 _hiddenSize;
+
+        /*!
+        \brief Hidden stimulus summation
+        */
+        std::vector<float> _hiddenSummation;
+
+        /*!
+        \brief Predictions
+        */
+        std::array<std::vector<float>, 2> _hiddenStates;
+
+        //!@{
+        /*!
+        \brief Layers and descs
+        */
+        std::vector<VisibleLayer> _visibleLayers;
+        std::vector<VisibleLayerDesc> _visibleLayerDescs;
+        //!@}
+
+    public:
+        /*!
+        \brief Initialize defaults
+        */
+        NativePredictorLayer()
+            : _hiddenSize({ 0, 0 })
+        {}
+
+        /*!
+        \brief Create a predictor layer with random initialization.
+        \param cs is the ComputeSystem, only its thread pool is used.
+        \param hiddenSize size of the predictions (output).
+        \param visibleLayerDescs are descriptors for visible layers.
+        \param initWeightRange are the minimum and maximum range values for weight initialization.
+        \param rng a random number generator.
+        */
+        void createRandom(ComputeSystem &cs, cl_int2 hiddenSize, const std::vector<VisibleLayerDesc> &visibleLayerDescs,
+            cl_float2 initWeightRange, std::mt19937 &rng);
+
+        /*!
+        \brief Activate predictor (predict values)
+        \param cs is the ComputeSystem.
+        \param visibleStates the input layer states, one row-major array per visible layer.
+        */
+        void activate(ComputeSystem &cs, const std::vector<std::vector<float>> &visibleStates);
+
+        /*!
+        \brief Learn predictor
+        \param cs is the ComputeSystem.
+        \param targets target values to update towards (row-major, hidden size).
+        */
+        void learn(ComputeSystem &cs, const std::vector<float> &targets);
+
+        /*!
+        \brief Step end (buffer swap)
+        */
+        void stepEnd(ComputeSystem &cs);
+
+        /*!
+        \brief Clear memory (recurrent data)
+        */
+        void clearMemory(ComputeSystem &cs);
+
+        /*!
+        \brief Get number of layers
+        */
+        size_t getNumLayers() const {
+            return _visibleLayers.size();
+        }
+
+        /*!
+        \brief Get access to a layer
+        */
+        const VisibleLayer &getLayer(int index) const {
+            return _visibleLayers[index];
+        }
+
+        /*!
+        \brief Get access to a layer descriptor
+        */
+        const VisibleLayerDesc &getLayerDesc(int index) const {
+            return _visibleLayerDescs[index];
+        }
+
+        /*!
+        \brief Get the predictions
+        */
+        const std::array<std::vector<float>, 2> &getHiddenStates() const {
+            return _hiddenStates;
+        }
+
+        /*!
+        \brief Get the hidden size
+        */
+        cl_int2 getHiddenSize() const {
+            return _hiddenSize;
+        }
+    };
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------------------
 
 #include "Predictor.h"
+#include "SparseFeaturesChunk.h"
 
 #include <iostream>
 
@@ -55,14 +56,26 @@ void Predictor::simStep(ComputeSystem &cs, const std::vector<cl::Image2D> &input
         if (_h.getLayer(l)._tpReset || _h.getLayer(l)._tpNextReset) {
             cl::Image2D target = _h.getLayer(l)._sf->getHiddenStates()[_back];
 
+            // Encoder states are one-hot per chunk, the feed-forward stimulus only needs the chunk winners
+            std::vector<PredictorLayer::ChunkSparseInput> chunkSparseInputs;
+
+            if (_chunkSparseStimulus && _h.getLayer(l)._sf->_type == SparseFeaturesType::_chunk) {
+                SparseFeaturesChunk* pSparseFeaturesChunk = static_cast<SparseFeaturesChunk*>(_h.getLayer(l)._sf.get());
+
+                chunkSparseInputs.resize(1);
+
+                chunkSparseInputs[0]._chunkWinners = pSparseFeaturesChunk->getChunkWinners()[_back];
+                chunkSparseInputs[0]._chunkSize = pSparseFeaturesChunk->getChunkSize();
+            }
+
             if (l != _pLayers.size() - 1) {
-                _pLayers[l].activate(cs, std::vector<cl::Image2D>{ _h.getLayer(l)._sf->getHiddenStates()[_back], _pLayers[l + 1].getHiddenStates()[_back] }, rng);
+                _pLayers[l].activate(cs, std::vector<cl::Image2D>{ _h.getLayer(l)._sf->getHiddenStates()[_back], _pLayers[l + 1].getHiddenStates()[_back] }, rng, chunkSparseInputs);
 
                 if (learn)
                     _pLayers[l].learn(cs, target);
             }
             else {
-                _pLayers[l].activate(cs, std::vector<cl::Image2D>{ _h.getLayer(l)._sf->getHiddenStates()[_back] }, rng);
+                _pLayers[l].activate(cs, std::vector<cl::Image2D>{ _h.getLayer(l)._sf->getHiddenStates()[_back] }, rng, chunkSparseInputs);
 
                 if (learn)
                     _pLayers[l].learn(cs, target);
@@ -73,6 +86,31 @@ void Predictor::simStep(ComputeSystem &cs, const std::vector<cl::Image2D> &input
     }
 }
 
+Predictor Predictor::createSession(ComputeSystem &cs) const {
+    Predictor session;
+
+    session._h = _h.createSession(cs);
+    session._pLayerDescs = _pLayerDescs;
+    session._chunkSparseStimulus = _chunkSparseStimulus;
+    session._pLayers.resize(_pLayers.size());
+
+    // Re-point inhibition to the session's encoders
+    for (int l = 0; l < _pLayers.size(); l++)
+        session._pLayers[l] = _pLayers[l].createSession(cs, session._h.getLayer(l)._sf);
+
+    return session;
+}
+
+void Predictor::quantize(ComputeSystem &cs) {
+    for (int l = 0; l < _pLayers.size(); l++) {
+        // Only chunk encoders have quantized kernels, other encoders stay full precision
+        if (_h.getLayer(l)._sf->_type == SparseFeaturesType::_chunk)
+            static_cast<SparseFeaturesChunk*>(_h.getLayer(l)._sf.get())->quantize(cs);
+
+        _pLayers[l].quantize(cs);
+    }
+}
+
 void Predictor::PredLayerDesc::load(const schemas::PredLayerDesc* fbPredLayerDesc, ComputeSystem &cs) {
     _radius = fbPredLayerDesc->_radius();
     _alpha = fbPredLayerDesc->_alpha();
@@ -100,11 +138,11 @@ void Predictor::load(const schemas::Predictor* fbPredictor, ComputeSystem &cs) {
 
 flatbuffers::Offset<schemas::Predictor> Predictor::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
     std::vector<schemas::PredLayerDesc> predLayerDescs;
-    for (PredLayerDesc layerDesc : _pLayerDescs)
+    for (PredLayerDesc &layerDesc : _pLayerDescs)
         predLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::PredictorLayer>> predLayers;
-    for (PredictorLayer layer : _pLayers)
+    for (PredictorLayer &layer : _pLayers)
         predLayers.push_back(layer.save(builder, cs));
 
     return schemas::CreatePredictor(builder,
@@ -66,7 +66,19 @@ namespace ogmaneo {
         */
         std::vector<PredictorLayer> _pLayers; // 2D since each layer can predict multiple inputs
 
+        /*!
+        \brief Whether predictor layers use the chunk sparse stimulus for chunk encoder inputs
+        */
+        bool _chunkSparseStimulus;
+
     public:
+        /*!
+        \brief Initialize defaults
+        */
+        Predictor()
+            : _chunkSparseStimulus(true)
+        {}
+
         /*!
         \brief Create a sparse predictive hierarchy with random initialization.
         Requires the ComputeSystem, ComputeProgram with the OgmaNeo kernels, and initialization information.
@@ -93,6 +105,21 @@ namespace ogmaneo {
         */
         void simStep(ComputeSystem &cs, const std::vector<cl::Image2D> &inputs, const std::vector<cl::Image2D> &inputsCorrupted, std::mt19937 &rng, bool learn = true);
 
+        //!@{
+        /*!
+        \brief Set/get chunk sparse stimulus
+        When enabled (default), the feed-forward input of a predictor layer whose encoder is a chunk encoder is read through
+        the encoder's chunk winners, visiting one input per chunk instead of the full receptive field. Results are the same.
+        */
+        void setChunkSparseStimulus(bool chunkSparseStimulus) {
+            _chunkSparseStimulus = chunkSparseStimulus;
+        }
+
+        bool getChunkSparseStimulus() const {
+            return _chunkSparseStimulus;
+        }
+        //!@}
+
         /*!
         \brief Get number of predictor layers
         Matches the number of layers in the feature hierarchy.
@@ -129,6 +156,20 @@ namespace ogmaneo {
             return _h;
         }
 
+        /*!
+        \brief Create an inference session
+        Shares all weights with this predictor, but owns copies of the working memory of every layer.
+        \param cs is the ComputeSystem.
+        */
+        Predictor createSession(ComputeSystem &cs) const;
+
+        /*!
+        \brief Quantize the weights of the predictor layers and chunk encoders to int8 (inference only)
+        Quantized layers no longer learn, other encoder types are left in full precision.
+        \param cs is the ComputeSystem.
+        */
+        void quantize(ComputeSystem &cs);
+
         //!@{
         /*!
         \brief Serialization
@@ -33,7 +33,7 @@ void PredictorLayer::createRandom(ComputeSystem &cs, ComputeProgram &plProgram,
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(plProgram.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(plProgram.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(plProgram.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -59,9 +59,9 @@ void PredictorLayer::createRandom(ComputeSystem &cs, ComputeProgram &plProgram,
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weights = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weights = createWeightBuffer(cs, weightsSize);
 
-            randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
@@ -81,10 +81,17 @@ void PredictorLayer::createRandom(ComputeSystem &cs, ComputeProgram &plProgram,
     // Create kernels
     _deriveInputsKernel = cl::Kernel(plProgram.getProgram(), "plDeriveInputs");
     _stimulusKernel = cl::Kernel(plProgram.getProgram(), "plStimulus");
+    _stimulusTiledKernel = cl::Kernel(plProgram.getProgram(), "plStimulusTiled");
+    _stimulusChunkKernel = cl::Kernel(plProgram.getProgram(), "plStimulusChunk");
+    _stimulusQuantizedKernel = cl::Kernel(plProgram.getProgram(), "plStimulusQuantized");
+    _stimulusChunkQuantizedKernel = cl::Kernel(plProgram.getProgram(), "plStimulusChunkQuantized");
     _learnPredWeightsKernel = cl::Kernel(plProgram.getProgram(), "plLearnPredWeights");
+    _quantizeWeightsKernel = cl::Kernel(plProgram.getProgram(), "quantizeWeights");
 }
 
-void PredictorLayer::activate(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, std::mt19937 &rng) {
+void PredictorLayer::activate(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, std::mt19937 &rng,
+    const std::vector<ChunkSparseInput> &chunkSparseInputs)
+{
     cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
     cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
 
@@ -107,18 +114,58 @@ void PredictorLayer::activate(ComputeSystem &cs, const std::vector<cl::Image2D>
             cs.getQueue().enqueueNDRangeKernel(_deriveInputsKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
         }
 
-        {
+        if (vli < chunkSparseInputs.size() && chunkSparseInputs[vli]._chunkWinners.get() != nullptr) {
+            cl::Kernel &stimulusChunkKernel = _quantized ? _stimulusChunkQuantizedKernel : _stimulusChunkKernel;
+
             int argIndex = 0;
 
-            _stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weights[_back]);
-            _stimulusKernel.setArg(argIndex++, vld._size);
-            _stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
-            _stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusChunkKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            stimulusChunkKernel.setArg(argIndex++, chunkSparseInputs[vli]._chunkWinners);
+            stimulusChunkKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusChunkKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+
+            if (_quantized) {
+                stimulusChunkKernel.setArg(argIndex++, vl._quantizedWeights._values);
+                stimulusChunkKernel.setArg(argIndex++, vl._quantizedWeights._scales);
+            }
+            else
+                stimulusChunkKernel.setArg(argIndex++, vl._weights._buffer);
+
+            stimulusChunkKernel.setArg(argIndex++, _hiddenSize);
+            stimulusChunkKernel.setArg(argIndex++, vld._size);
+            stimulusChunkKernel.setArg(argIndex++, chunkSparseInputs[vli]._chunkSize);
+            stimulusChunkKernel.setArg(argIndex++, vl._hiddenToVisible);
+            stimulusChunkKernel.setArg(argIndex++, vld._radius);
 
-            cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            cs.getQueue().enqueueNDRangeKernel(stimulusChunkKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+        }
+        else {
+            LocalTile tile = _quantized ? LocalTile() : getLocalTile(cs, _stimulusTiledKernel, vl._hiddenToVisible, vld._radius);
+
+            cl::Kernel &stimulusKernel = _quantized ? _stimulusQuantizedKernel : (tile._enabled ? _stimulusTiledKernel : _stimulusKernel);
+
+            int argIndex = 0;
+
+            stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+
+            if (_quantized) {
+                stimulusKernel.setArg(argIndex++, vl._quantizedWeights._values);
+                stimulusKernel.setArg(argIndex++, vl._quantizedWeights._scales);
+            }
+            else
+                stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -152,6 +199,10 @@ void PredictorLayer::stepEnd(ComputeSystem &cs) {
 }
 
 void PredictorLayer::learn(ComputeSystem &cs, const cl::Image2D &targets) {
+    // Quantized weights are frozen
+    if (_quantized)
+        return;
+
     // Learn weights
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
         VisibleLayer &vl = _visibleLayers[vli];
@@ -162,16 +213,14 @@ void PredictorLayer::learn(ComputeSystem &cs, const cl::Image2D &targets) {
         _learnPredWeightsKernel.setArg(argIndex++, vl._derivedInput[_back]);
         _learnPredWeightsKernel.setArg(argIndex++, targets);
         _learnPredWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
-        _learnPredWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-        _learnPredWeightsKernel.setArg(argIndex++, vl._weights[_front]);
+        _learnPredWeightsKernel.setArg(argIndex++, vl._weights._buffer);
+        _learnPredWeightsKernel.setArg(argIndex++, _hiddenSize);
         _learnPredWeightsKernel.setArg(argIndex++, vld._size);
         _learnPredWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
         _learnPredWeightsKernel.setArg(argIndex++, vld._radius);
         _learnPredWeightsKernel.setArg(argIndex++, vld._alpha);
 
         cs.getQueue().enqueueNDRangeKernel(_learnPredWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-        std::swap(vl._weights[_front], vl._weights[_back]);
     }
 }
 
@@ -186,6 +235,52 @@ void PredictorLayer::clearMemory(ComputeSystem &cs) {
     cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
 }
 
+PredictorLayer PredictorLayer::createSession(ComputeSystem &cs, const std::shared_ptr<SparseFeatures> &inhibitSparseFeatures) const {
+    PredictorLayer session = *this;
+
+    session._hiddenStates = cloneDoubleBuffer2D(cs, _hiddenStates);
+    session._hiddenActivations = cloneDoubleBuffer2D(cs, _hiddenActivations);
+    if (_inhibitSparseFeatures != nullptr)
+        session._inhibitSparseFeatures = inhibitSparseFeatures;
+
+    for (int vli = 0; vli < session._visibleLayers.size(); vli++) {
+        VisibleLayer &vl = session._visibleLayers[vli];
+
+        vl._derivedInput = cloneDoubleBuffer2D(cs, vl._derivedInput);
+    }
+
+    session._hiddenSummationTemp = cloneDoubleBuffer2D(cs, _hiddenSummationTemp);
+
+    // Own kernels, arguments are set per object
+    session._deriveInputsKernel = cloneKernel(_deriveInputsKernel);
+    session._stimulusKernel = cloneKernel(_stimulusKernel);
+    session._stimulusTiledKernel = cloneKernel(_stimulusTiledKernel);
+    session._stimulusChunkKernel = cloneKernel(_stimulusChunkKernel);
+    session._stimulusQuantizedKernel = cloneKernel(_stimulusQuantizedKernel);
+    session._stimulusChunkQuantizedKernel = cloneKernel(_stimulusChunkQuantizedKernel);
+    session._learnPredWeightsKernel = cloneKernel(_learnPredWeightsKernel);
+    session._thresholdKernel = cloneKernel(_thresholdKernel);
+    session._quantizeWeightsKernel = cloneKernel(_quantizeWeightsKernel);
+
+    return session;
+}
+
+void PredictorLayer::quantize(ComputeSystem &cs) {
+    if (_quantized)
+        return;
+
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+
+        vl._quantizedWeights = ogmaneo::quantize(vl._weights, cs, _quantizeWeightsKernel);
+
+        // Sessions sharing the full precision weights keep them alive
+        vl._weights._buffer = cl::Buffer();
+    }
+
+    _quantized = true;
+}
+
 void PredictorLayer::VisibleLayerDesc::load(const schemas::VisiblePredictorLayerDesc* fbVisiblePredictorLayerDesc, ComputeSystem &cs) {
     _size = cl_int2{ fbVisiblePredictorLayerDesc->_size().x(), fbVisiblePredictorLayerDesc->_size().y() };
     _radius = fbVisiblePredictorLayerDesc->_radius();
@@ -202,7 +297,14 @@ void PredictorLayer::VisibleLayer::load(const schemas::VisiblePredictorLayer* fb
     _visibleToHidden = cl_float2{ fbVisiblePredictorLayer->_visibleToHidden()->x(), fbVisiblePredictorLayer->_visibleToHidden()->y() };
     _reverseRadii = cl_int2{ fbVisiblePredictorLayer->_reverseRadii()->x(), fbVisiblePredictorLayer->_reverseRadii()->y() };
     ogmaneo::load(_derivedInput, fbVisiblePredictorLayer->_derivedInput(), cs);
-    ogmaneo::load(_weights, fbVisiblePredictorLayer->_weights(), cs);
+
+    if (fbVisiblePredictorLayer->_quantizedWeights() != nullptr) {
+        ogmaneo::load(_quantizedWeights, fbVisiblePredictorLayer->_quantizedWeights(), cs);
+
+        _weights._buffer = cl::Buffer();
+    }
+    else
+        ogmaneo::load(_weights, fbVisiblePredictorLayer->_weights(), cs);
 }
 
 flatbuffers::Offset<schemas::VisiblePredictorLayer> PredictorLayer::VisibleLayer::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
@@ -213,7 +315,8 @@ flatbuffers::Offset<schemas::VisiblePredictorLayer> PredictorLayer::VisibleLayer
     return schemas::CreateVisiblePredictorLayer(builder,
         ogmaneo::save(_derivedInput, builder, cs),
         ogmaneo::save(_weights, builder, cs),
-        &hiddenToVisible, &visibleToHidden, &reverseRadii);
+        &hiddenToVisible, &visibleToHidden, &reverseRadii,
+        (_quantizedWeights._values.get() != nullptr ? ogmaneo::save(_quantizedWeights, builder, cs) : 0));
 }
 
 void PredictorLayer::load(const schemas::PredictorLayer* fbPredictorLayer, ComputeSystem &cs) {
@@ -263,22 +366,24 @@ void PredictorLayer::load(const schemas::PredictorLayer* fbPredictorLayer, Compu
     for (flatbuffers::uoffset_t i = 0; i < fbPredictorLayer->_visibleLayers()->Length(); i++) {
         _visibleLayers[i].load(fbPredictorLayer->_visibleLayers()->Get(i), cs);
     }
+
+    _quantized = !_visibleLayers.empty() && _visibleLayers.front()._quantizedWeights._values.get() != nullptr;
 }
 
 flatbuffers::Offset<schemas::PredictorLayer> PredictorLayer::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
     schemas::int2 hiddenSize(_hiddenSize.x, _hiddenSize.y);
 
     std::vector<schemas::VisiblePredictorLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::VisiblePredictorLayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     return schemas::CreatePredictorLayer(builder,
         &hiddenSize,
-        ogmaneo::save(_hiddenSummationTemp, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTemp, builder, cs),
         ogmaneo::save(_hiddenStates, builder, cs),
         ogmaneo::save(_hiddenActivations, builder, cs),
         ((_inhibitSparseFeatures != nullptr) ? _inhibitSparseFeatures->save(builder, cs) : 0),
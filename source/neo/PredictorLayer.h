@@ -64,7 +64,9 @@ namespace ogmaneo {
             */
             DoubleBuffer2D _derivedInput;
 
-            DoubleBuffer3D _weights;
+            WeightBuffer _weights;
+
+            QuantizedWeightBuffer _quantizedWeights;
 
             cl_float2 _hiddenToVisible;
             cl_float2 _visibleToHidden;
@@ -81,6 +83,29 @@ namespace ogmaneo {
             //!@}
         };
 
+        /*!
+        \brief Chunk sparse input
+        Describes a visible layer whose states are one-hot per chunk (chunk encoder states), so the stimulus
+        only has to visit the winner of each chunk instead of the whole receptive field.
+        */
+        struct ChunkSparseInput {
+            //!@{
+            /*!
+            \brief Chunk winners (in-chunk coordinates, one texel per chunk) and chunk size of the input
+            */
+            cl::Image2D _chunkWinners;
+
+            cl_int2 _chunkSize;
+            //!@}
+
+            /*!
+            \brief Initialize defaults (dense input)
+            */
+            ChunkSparseInput()
+                : _chunkSize({ 0, 0 })
+            {}
+        };
+
     private:
         /*!
         \brief Size of the prediction
@@ -114,17 +139,34 @@ namespace ogmaneo {
         std::vector<VisibleLayerDesc> _visibleLayerDescs;
         //!@}
 
+        /*!
+        \brief Whether the weights are quantized (int8, inference only)
+        */
+        bool _quantized;
+
         //!@{
         /*!
         \brief Additional kernels
         */
         cl::Kernel _deriveInputsKernel;
         cl::Kernel _stimulusKernel;
+        cl::Kernel _stimulusTiledKernel;
+        cl::Kernel _stimulusChunkKernel;
+        cl::Kernel _stimulusQuantizedKernel;
+        cl::Kernel _stimulusChunkQuantizedKernel;
         cl::Kernel _learnPredWeightsKernel;
         cl::Kernel _thresholdKernel;
+        cl::Kernel _quantizeWeightsKernel;
         //!@}
 
     public:
+        /*!
+        \brief Initialize defaults
+        */
+        PredictorLayer()
+            : _quantized(false)
+        {}
+
         /*!
         \brief Create a predictor layer with random initialization.
         Requires the ComputeSystem, ComputeProgram with the OgmaNeo kernels, and initialization information.
@@ -145,8 +187,10 @@ namespace ogmaneo {
         \param cs is the ComputeSystem.
         \param visibleStates the input layer states.
         \param threshold whether or not the output should be thresholded (binary).
+        \param chunkSparseInputs optional, per visible layer. Layers with chunk winners use the sparse stimulus.
         */
-        void activate(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, std::mt19937 &rng);
+        void activate(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, std::mt19937 &rng,
+            const std::vector<ChunkSparseInput> &chunkSparseInputs = std::vector<ChunkSparseInput>());
 
         /*!
         \brief Learn predictor
@@ -168,6 +212,28 @@ namespace ogmaneo {
         */
         void clearMemory(ComputeSystem &cs);
 
+        /*!
+        \brief Create an inference session
+        Shares the weights with this layer, but owns copies of the predictions and derived inputs, its scratch buffers and its kernels.
+        \param cs is the ComputeSystem.
+        \param inhibitSparseFeatures the session's encoder corresponding to this decoder, replaces the current one if this layer has one.
+        */
+        PredictorLayer createSession(ComputeSystem &cs, const std::shared_ptr<SparseFeatures> &inhibitSparseFeatures) const;
+
+        /*!
+        \brief Quantize the weights to int8 with a scale per hidden unit and release the full precision weights
+        Afterwards the layer is inference only, learn does nothing.
+        \param cs is the ComputeSystem.
+        */
+        void quantize(ComputeSystem &cs);
+
+        /*!
+        \brief Whether the weights are quantized
+        */
+        bool isQuantized() const {
+            return _quantized;
+        }
+
         /*!
         \brief Get number of layers
         */
@@ -8,12 +8,23 @@
 
 #include "ScalarEncoder.h"
 
+#include "system/ThreadPool.h"
+
 #include <algorithm>
 #include <random>
+#include <cmath>
 #include <assert.h>
 
 using namespace ogmaneo;
 
+namespace {
+    // Independent partial sums per row, lets the compiler keep a full SIMD register of accumulators
+    const int simdWidth = 8;
+
+    // Smallest amount of work (in weights touched) worth handing to a worker
+    const int minWeightsPerTask = 16384;
+}
+
 void ScalarEncoder::createRandom(int numInputs, int numOutputs, float initMinWeight, float initMaxWeight, int seed) {
     std::uniform_real_distribution<float> weightDist(initMinWeight, initMaxWeight);
 
@@ -38,76 +49,229 @@ void ScalarEncoder::createRandom(int numInputs, int numOutputs, float initMinWei
         _weightsEncode[i] = weightDist(rng);
         _weightsDecode[i] = weightDist(rng);
     }
+
+    _activations.resize(numOutputs);
+    _sortedActivations.reserve(numOutputs);
+    _reconInputs.resize(numInputs);
+    _activeIndices.reserve(numOutputs);
 }
 
-void ScalarEncoder::encode(const std::vector<float> &inputs, float activeRatio, float alpha, float beta) {
-    assert(inputs.size() == _weightsEncode.size() / _encoderOutputs.size());
+void ScalarEncoder::activate(const float* inputs, float* activations, int first, int last) const {
+    int numInputs = _decoderOutputs.size();
 
-    // Compute activations
-    std::vector<float> activations(_encoderOutputs.size());
+    for (int i = first; i < last; i++) {
+        const float* weights = &_weightsEncode[i * numInputs];
+
+        float sums[simdWidth] = { 0.0f };
+
+        int j = 0;
+
+        for (; j + simdWidth <= numInputs; j += simdWidth)
+            for (int l = 0; l < simdWidth; l++) {
+                float delta = inputs[j + l] - weights[j + l];
+
+                sums[l] += -delta * delta;
+            }
 
-    for (int i = 0; i < _encoderOutputs.size(); i++) {
         float sum = _biases[i];
 
-        for (int j = 0; j < inputs.size(); j++) {
-            float delta = inputs[j] - _weightsEncode[i * inputs.size() + j];
+        for (; j < numInputs; j++) {
+            float delta = inputs[j] - weights[j];
 
             sum += -delta * delta;
         }
 
+        for (int l = 0; l < simdWidth; l++)
+            sum += sums[l];
+
         activations[i] = sum;
     }
+}
 
-    // Inhibit
-    for (int i = 0; i < _encoderOutputs.size(); i++) {
-        float numHigher = 0.0f;
+void ScalarEncoder::inhibit(const float* activations, float* outputs, float activeRatio, std::vector<float> &sortedActivations, std::vector<int> &activeIndices) const {
+    int numOutputs = _encoderOutputs.size();
 
-        for (int j = 0; j < _encoderOutputs.size(); j++) {
-            if (i == j)
-                continue;
+    // A unit is active when fewer than maxHigher others have an activation >= its own
+    float maxHigher = activeRatio * numOutputs;
 
-            if (activations[j] >= activations[i])
-                numHigher++;
-        }
+    int numActive = std::min(numOutputs, static_cast<int>(std::ceil(maxHigher)));
+
+    activeIndices.clear();
+
+    if (numActive <= 0) {
+        std::fill(outputs, outputs + numOutputs, 0.0f);
+
+        return;
+    }
+
+    // Activation of the numActive-th highest unit
+    sortedActivations.assign(activations, activations + numOutputs);
+
+    std::nth_element(sortedActivations.begin(), sortedActivations.begin() + (numActive - 1), sortedActivations.end(), std::greater<float>());
+
+    float threshold = sortedActivations[numActive - 1];
+
+    int numAbove = 0;
+    int numEqual = 0;
 
-        _encoderOutputs[i] = numHigher < activeRatio * _encoderOutputs.size() ? 1.0f : 0.0f;
+    for (int i = 0; i < numOutputs; i++) {
+        if (activations[i] > threshold)
+            numAbove++;
+        else if (activations[i] == threshold)
+            numEqual++;
     }
 
-    std::vector<float> reconInputs(inputs.size());
+    // Units tied with the threshold count each other as higher
+    bool tiesActive = numAbove + numEqual - 1 < maxHigher;
 
-    // Reconstruct
-    for (int i = 0; i < inputs.size(); i++) {
-        float sum = 0.0f;
+    for (int i = 0; i < numOutputs; i++) {
+        bool active = activations[i] > threshold || (tiesActive && activations[i] == threshold);
 
-        for (int j = 0; j < _encoderOutputs.size(); j++)
-            sum += _weightsDecode[j * inputs.size() + i] * _encoderOutputs[j];
+        outputs[i] = active ? 1.0f : 0.0f;
 
-        reconInputs[i] = sum * activeRatio;
+        if (active)
+            activeIndices.push_back(i);
     }
+}
+
+void ScalarEncoder::learn(const float* inputs, const float* outputs, const std::vector<int> &activeIndices, float activeRatio, float alpha, float beta, std::vector<float> &reconInputs) {
+    int numInputs = _decoderOutputs.size();
+
+    if (alpha != 0.0f) {
+        // Reconstruct, outputs are binary so only active rows contribute
+        std::fill(reconInputs.begin(), reconInputs.end(), 0.0f);
 
-    // Learn
-    for (int i = 0; i < inputs.size(); i++) {
-        for (int j = 0; j < _encoderOutputs.size(); j++)
-            _weightsDecode[j * inputs.size() + i] += alpha * (inputs[i] - reconInputs[i]) * _encoderOutputs[j];
+        for (int ai = 0; ai < activeIndices.size(); ai++) {
+            const float* weights = &_weightsDecode[activeIndices[ai] * numInputs];
+
+            for (int i = 0; i < numInputs; i++)
+                reconInputs[i] += weights[i];
+        }
+
+        for (int i = 0; i < numInputs; i++)
+            reconInputs[i] = alpha * (inputs[i] - reconInputs[i] * activeRatio);
+
+        // Learn
+        for (int ai = 0; ai < activeIndices.size(); ai++) {
+            float* weights = &_weightsDecode[activeIndices[ai] * numInputs];
+
+            for (int i = 0; i < numInputs; i++)
+                weights[i] += reconInputs[i];
+        }
     }
 
     // Bias update
-    for (int i = 0; i < _biases.size(); i++)
-        _biases[i] += beta * (activeRatio - _encoderOutputs[i]);
+    if (beta != 0.0f) {
+        for (int i = 0; i < _biases.size(); i++)
+            _biases[i] += beta * (activeRatio - outputs[i]);
+    }
+}
+
+void ScalarEncoder::decodeSample(const float* outputs, float* decoderOutputs) const {
+    int numInputs = _decoderOutputs.size();
+    int numOutputs = _encoderOutputs.size();
+
+    std::fill(decoderOutputs, decoderOutputs + numInputs, 0.0f);
+
+    float count = 0.0f;
+
+    for (int j = 0; j < numOutputs; j++) {
+        if (outputs[j] == 0.0f)
+            continue;
+
+        const float* weights = &_weightsEncode[j * numInputs];
+
+        for (int i = 0; i < numInputs; i++)
+            decoderOutputs[i] += weights[i] * outputs[j];
+
+        count += outputs[j];
+    }
+
+    float scale = 1.0f / std::max(1.0f, count);
+
+    for (int i = 0; i < numInputs; i++)
+        decoderOutputs[i] *= scale;
+}
+
+void ScalarEncoder::parallelFor(int begin, int end, const std::function<void(int, int)> &func, int minChunkSize) const {
+    if (_pool == nullptr)
+        func(begin, end);
+    else
+        _pool->parallelFor(begin, end, func, minChunkSize);
+}
+
+void ScalarEncoder::encode(const std::vector<float> &inputs, float activeRatio, float alpha, float beta) {
+    assert(inputs.size() == _weightsEncode.size() / _encoderOutputs.size());
+
+    // Compute activations
+    parallelFor(0, _encoderOutputs.size(), [&](int first, int last) {
+        activate(inputs.data(), _activations.data(), first, last);
+    }, std::max(1, minWeightsPerTask / std::max(1, static_cast<int>(inputs.size()))));
+
+    // Inhibit
+    inhibit(_activations.data(), _encoderOutputs.data(), activeRatio, _sortedActivations, _activeIndices);
+
+    learn(inputs.data(), _encoderOutputs.data(), _activeIndices, activeRatio, alpha, beta, _reconInputs);
 }
 
 void ScalarEncoder::decode(const std::vector<float> &outputs) {
     assert(outputs.size() == _encoderOutputs.size());
 
-    for (int i = 0; i < _decoderOutputs.size(); i++) {
-        float sum = 0.0f;
-        float count = 0.0f;
+    decodeSample(outputs.data(), _decoderOutputs.data());
+}
+
+void ScalarEncoder::encodeBatch(const std::vector<float> &inputs, int batchSize, float activeRatio, float alpha, float beta) {
+    int numInputs = _decoderOutputs.size();
+    int numOutputs = _encoderOutputs.size();
+
+    assert(inputs.size() == static_cast<size_t>(batchSize) * numInputs);
+
+    _batchEncoderOutputs.resize(static_cast<size_t>(batchSize) * numOutputs);
+
+    // Learning makes each sample depend on the previous one
+    if (alpha != 0.0f || beta != 0.0f) {
+        for (int b = 0; b < batchSize; b++) {
+            const float* sampleInputs = &inputs[b * numInputs];
+            float* sampleOutputs = &_batchEncoderOutputs[b * numOutputs];
 
-        for (int j = 0; j < outputs.size(); j++) {
-            sum += _weightsEncode[j * _decoderOutputs.size() + i] * outputs[j];
-            count += outputs[j];
+            parallelFor(0, numOutputs, [&](int first, int last) {
+                activate(sampleInputs, _activations.data(), first, last);
+            }, std::max(1, minWeightsPerTask / std::max(1, numInputs)));
+
+            inhibit(_activations.data(), sampleOutputs, activeRatio, _sortedActivations, _activeIndices);
+
+            learn(sampleInputs, sampleOutputs, _activeIndices, activeRatio, alpha, beta, _reconInputs);
         }
 
-        _decoderOutputs[i] = sum / fmax(1.0f, count);
+        return;
     }
-}
\ No newline at end of file
+
+    parallelFor(0, batchSize, [&](int first, int last) {
+        std::vector<float> activations(numOutputs);
+        std::vector<float> sortedActivations;
+        std::vector<int> activeIndices;
+
+        sortedActivations.reserve(numOutputs);
+        activeIndices.reserve(numOutputs);
+
+        for (int b = first; b < last; b++) {
+            activate(&inputs[b * numInputs], activations.data(), 0, numOutputs);
+
+            inhibit(activations.data(), &_batchEncoderOutputs[b * numOutputs], activeRatio, sortedActivations, activeIndices);
+        }
+    }, std::max(1, minWeightsPerTask / std::max(1, numInputs * numOutputs)));
+}
+
+void ScalarEncoder::decodeBatch(const std::vector<float> &outputs, int batchSize) {
+    int numInputs = _decoderOutputs.size();
+    int numOutputs = _encoderOutputs.size();
+
+    assert(outputs.size() == static_cast<size_t>(batchSize) * numOutputs);
+
+    _batchDecoderOutputs.resize(static_cast<size_t>(batchSize) * numInputs);
+
+    parallelFor(0, batchSize, [&](int first, int last) {
+        for (int b = first; b < last; b++)
+            decodeSample(&outputs[b * numOutputs], &_batchDecoderOutputs[b * numInputs]);
+    }, std::max(1, minWeightsPerTask / std::max(1, numInputs * numOutputs)));
+}
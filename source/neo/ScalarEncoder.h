@@ -10,11 +10,16 @@
 
 #include "system/SharedLib.h"
 #include <vector>
+#include <functional>
 
 namespace ogmaneo {
+    class ThreadPool;
+
     /*!
     \brief Simple RBF-based scalar encoder
     Encodes a set of scalars into an SDR. Optional learning included. CPU-only.
+    Weights are stored output-major, so every loop runs over contiguous inputs, and only active outputs are visited
+    when reconstructing, learning and decoding.
     */
     class OGMA_API ScalarEncoder {
     private:
@@ -34,12 +39,64 @@ namespace ogmaneo {
         std::vector<float> _decoderOutputs;
         //!@}
 
+        //!@{
+        /*!
+        \brief Batch encoder and decoder results, one sample after the other
+        */
+        std::vector<float> _batchEncoderOutputs;
+        std::vector<float> _batchDecoderOutputs;
+        //!@}
+
         /*!
         \brief Bias values
         */
         std::vector<float> _biases;
 
+        //!@{
+        /*!
+        \brief Scratch space reused by encode
+        */
+        std::vector<float> _activations;
+        std::vector<float> _sortedActivations;
+        std::vector<float> _reconInputs;
+        std::vector<int> _activeIndices;
+        //!@}
+
+        /*!
+        \brief Optional thread pool, nullptr runs everything on the calling thread
+        */
+        ThreadPool* _pool;
+
+        /*!
+        \brief Compute activations of outputs [first, last)
+        */
+        void activate(const float* inputs, float* activations, int first, int last) const;
+
+        /*!
+        \brief Select the active outputs with a partial selection, same result as counting higher activations pairwise
+        */
+        void inhibit(const float* activations, float* outputs, float activeRatio, std::vector<float> &sortedActivations, std::vector<int> &activeIndices) const;
+
+        /*!
+        \brief Learn decoder weights and biases from one encoded sample
+        */
+        void learn(const float* inputs, const float* outputs, const std::vector<int> &activeIndices, float activeRatio, float alpha, float beta, std::vector<float> &reconInputs);
+
+        /*!
+        \brief Decode one sample
+        */
+        void decodeSample(const float* outputs, float* decoderOutputs) const;
+
+        /*!
+        \brief Run func over [begin, end) on the pool if there is one
+        */
+        void parallelFor(int begin, int end, const std::function<void(int, int)> &func, int minChunkSize) const;
+
     public:
+        ScalarEncoder()
+            : _pool(nullptr)
+        {}
+
         /*!
         \brief Randomly initialize the scalar encoder
         \param numInputs to the encoder.
@@ -65,6 +122,33 @@ namespace ogmaneo {
         */
         void decode(const std::vector<float> &outputs);
 
+        /*!
+        \brief Encode a batch of input vectors
+        Without learning (alpha and beta 0) the samples are independent and spread over the thread pool,
+        with learning they are processed in order, same as calling encode once per sample.
+        \param inputs batchSize input vectors, one after the other.
+        \param batchSize number of input vectors.
+        \param activeRatio % active units.
+        \param alpha learning rate for weights (often 0 for this encoder).
+        \param beta learning rate for biases (often 0 for this encoder).
+        */
+        void encodeBatch(const std::vector<float> &inputs, int batchSize, float activeRatio, float alpha, float beta);
+
+        /*!
+        \brief Decode a batch of SDRs
+        \param outputs batchSize SDRs, one after the other.
+        \param batchSize number of SDRs.
+        */
+        void decodeBatch(const std::vector<float> &outputs, int batchSize);
+
+        /*!
+        \brief Set the thread pool used to split work (e.g. &cs.getPool()), nullptr to run single threaded (default)
+        The encoder must then not be called from one of the pool's own workers.
+        */
+        void setThreadPool(ThreadPool* pool) {
+            _pool = pool;
+        }
+
         /*!
         \brief Get resulting encoding
         */
@@ -78,5 +162,19 @@ namespace ogmaneo {
         std::vector<float> &getDecoderOutputs() {
             return _decoderOutputs;
         }
+
+        /*!
+        \brief Get resulting batch encoding, one SDR per sample
+        */
+        std::vector<float> &getBatchEncoderOutputs() {
+            return _batchEncoderOutputs;
+        }
+
+        /*!
+        \brief Get resulting batch decoding, one input vector per sample
+        */
+        std::vector<float> &getBatchDecoderOutputs() {
+            return _batchDecoderOutputs;
+        }
     };
 }
\ No newline at end of file
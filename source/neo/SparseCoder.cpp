@@ -30,7 +30,7 @@ void SparseCoder::createRandom(ComputeSystem &cs, ComputeProgram &program,
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(program.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -56,9 +56,9 @@ void SparseCoder::createRandom(ComputeSystem &cs, ComputeProgram &program,
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weights = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weights = createWeightBuffer(cs, weightsSize);
 
-            randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
@@ -81,6 +81,7 @@ void SparseCoder::createRandom(ComputeSystem &cs, ComputeProgram &program,
 
     // Create kernels
     _stimulusKernel = cl::Kernel(program.getProgram(), "scStimulus");
+    _stimulusTiledKernel = cl::Kernel(program.getProgram(), "scStimulusTiled");
     _reverseKernel = cl::Kernel(program.getProgram(), "scReverse");
     _reconstructKernel = cl::Kernel(program.getProgram(), "scReconstruct");
     _solveHiddenKernel = cl::Kernel(program.getProgram(), "scSolveHidden");
@@ -120,18 +121,26 @@ void SparseCoder::activate(ComputeSystem &cs, const std::vector<cl::Image2D> &vi
         VisibleLayerDesc &vld = _visibleLayerDescs[vli];
 
         {
-            int argIndex = 0;
+            LocalTile tile = getLocalTile(cs, _stimulusTiledKernel, vl._hiddenToVisible, vld._radius);
+
+            cl::Kernel &stimulusKernel = tile._enabled ? _stimulusTiledKernel : _stimulusKernel;
 
-            _stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _stimulusKernel.setArg(argIndex++, _hiddenStimulusSummationTemp[_back]);
-            _stimulusKernel.setArg(argIndex++, _hiddenStimulusSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weights[_back]);
-            _stimulusKernel.setArg(argIndex++, vld._size);
-            _stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
-            _stimulusKernel.setArg(argIndex++, vld._radius);
-            _stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            int argIndex = 0;
 
-            cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            stimulusKernel.setArg(argIndex++, _hiddenStimulusSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenStimulusSummationTemp[_front]);
+            stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -139,17 +148,30 @@ void SparseCoder::activate(ComputeSystem &cs, const std::vector<cl::Image2D> &vi
     }
 
     // Solve hidden
-    {
-        int argIndex = 0;
+    solveHidden(cs, _hiddenStimulusSummationTemp[_back], _hiddenStates[_front], activeRatio, _inhibitionStride);
+}
 
-        _solveHiddenKernel.setArg(argIndex++, _hiddenStimulusSummationTemp[_back]);
-        _solveHiddenKernel.setArg(argIndex++, _hiddenStates[_front]);
-        _solveHiddenKernel.setArg(argIndex++, _hiddenSize);
-        _solveHiddenKernel.setArg(argIndex++, _inhibitionRadius);
-        _solveHiddenKernel.setArg(argIndex++, activeRatio);
+void SparseCoder::solveHidden(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, float activeRatio, int stride) {
+    int argIndex = 0;
 
-        cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-    }
+    _solveHiddenKernel.setArg(argIndex++, activations);
+    _solveHiddenKernel.setArg(argIndex++, states);
+    _solveHiddenKernel.setArg(argIndex++, _hiddenSize);
+    _solveHiddenKernel.setArg(argIndex++, _inhibitionRadius);
+    _solveHiddenKernel.setArg(argIndex++, clampInhibitionStride(stride, _inhibitionRadius));
+    _solveHiddenKernel.setArg(argIndex++, activeRatio);
+
+    cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+}
+
+float SparseCoder::getInhibitionError(ComputeSystem &cs, float activeRatio) {
+    cl::Image2D exactStates = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _hiddenSize.x, _hiddenSize.y);
+    cl::Image2D stridedStates = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _hiddenSize.x, _hiddenSize.y);
+
+    solveHidden(cs, _hiddenStimulusSummationTemp[_back], exactStates, activeRatio, 1);
+    solveHidden(cs, _hiddenStimulusSummationTemp[_back], stridedStates, activeRatio, _inhibitionStride);
+
+    return getStateDisagreement(cs, exactStates, stridedStates, _hiddenSize);
 }
 
 void SparseCoder::stepEnd(ComputeSystem &cs) {
@@ -181,7 +203,7 @@ void SparseCoder::learn(ComputeSystem &cs,
             _reverseKernel.setArg(argIndex++, _hiddenStates[_front]);
             _reverseKernel.setArg(argIndex++, vl._derivedInput[_front]);
             _reverseKernel.setArg(argIndex++, vl._reconError);
-            _reverseKernel.setArg(argIndex++, vl._weights[_back]);
+            _reverseKernel.setArg(argIndex++, vl._weights._buffer);
             _reverseKernel.setArg(argIndex++, vld._size);
             _reverseKernel.setArg(argIndex++, _hiddenSize);
             _reverseKernel.setArg(argIndex++, vl._visibleToHidden);
@@ -203,8 +225,8 @@ void SparseCoder::learn(ComputeSystem &cs,
         _learnWeightsKernel.setArg(argIndex++, _hiddenStates[_front]);
         _learnWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
         _learnWeightsKernel.setArg(argIndex++, vl._reconError);
-        _learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-        _learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
+        _learnWeightsKernel.setArg(argIndex++, vl._weights._buffer);
+        _learnWeightsKernel.setArg(argIndex++, _hiddenSize);
         _learnWeightsKernel.setArg(argIndex++, vld._size);
         _learnWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
         _learnWeightsKernel.setArg(argIndex++, vld._radius);
@@ -212,8 +234,6 @@ void SparseCoder::learn(ComputeSystem &cs,
         _learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
 
         cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-        std::swap(vl._weights[_front], vl._weights[_back]);
     }
 
     // Bias update
@@ -259,7 +279,7 @@ void SparseCoder::reconstruct(ComputeSystem &cs, const cl::Image2D &hiddenStates
 
             _reconstructKernel.setArg(argIndex++, hiddenStates);
             _reconstructKernel.setArg(argIndex++, reconstructions[vli]);
-            _reconstructKernel.setArg(argIndex++, vl._weights[_back]);
+            _reconstructKernel.setArg(argIndex++, vl._weights._buffer);
             _reconstructKernel.setArg(argIndex++, vld._size);
             _reconstructKernel.setArg(argIndex++, _hiddenSize);
             _reconstructKernel.setArg(argIndex++, vl._visibleToHidden);
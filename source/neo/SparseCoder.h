@@ -13,6 +13,8 @@
 #include "system/ComputeProgram.h"
 #include "Helpers.h"
 
+#include <algorithm>
+
 namespace ogmaneo {
     /*!
     \brief Sparse coder
@@ -71,7 +73,7 @@ namespace ogmaneo {
             /*!
             \brief Weights
             */
-            DoubleBuffer3D _weights; // Encoding weights (creates spatio-temporal sparse code)
+            WeightBuffer _weights; // Encoding weights (creates spatio-temporal sparse code)
             //!@}
 
             //!@{
@@ -104,6 +106,11 @@ namespace ogmaneo {
         */
         int _inhibitionRadius;
 
+        /*!
+        \brief Inhibition neighbourhood sampling stride, 1 is exact
+        */
+        int _inhibitionStride;
+
         /*!
         \brief Hidden stimulus summation temporary buffer
         */
@@ -122,6 +129,7 @@ namespace ogmaneo {
         \brief Kernels
         */
         cl::Kernel _stimulusKernel;
+        cl::Kernel _stimulusTiledKernel;
         cl::Kernel _reverseKernel;
         cl::Kernel _reconstructKernel;
         cl::Kernel _solveHiddenKernel;
@@ -130,7 +138,16 @@ namespace ogmaneo {
         cl::Kernel _deriveInputsKernel;
         //!@}
 
+        /*!
+        \brief Solve hidden states with a given neighbourhood stride
+        */
+        void solveHidden(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, float activeRatio, int stride);
+
     public:
+        SparseCoder()
+            : _inhibitionStride(1)
+        {}
+
         /*!
         \brief Create a comparison sparse coder with random initialization.
         Requires the ComputeSystem, ComputeProgram with the OgmaNeo kernels, and initialization information.
@@ -178,6 +195,28 @@ namespace ogmaneo {
         */
         void reconstruct(ComputeSystem &cs, const cl::Image2D &hiddenStates, std::vector<cl::Image2D> &reconstructions);
 
+        /*!
+        \brief Set the inhibition stride
+        Inhibition compares against every stride-th neighbour per axis, 1 (default) is exact, cost falls with stride^2.
+        Strides above the inhibition radius are clamped to it.
+        */
+        void setInhibitionStride(int inhibitionStride) {
+            _inhibitionStride = std::max(1, inhibitionStride);
+        }
+
+        /*!
+        \brief Get the inhibition stride
+        */
+        int getInhibitionStride() const {
+            return _inhibitionStride;
+        }
+
+        /*!
+        \brief Error rate of the strided inhibition
+        Fraction of units whose state differs from the exact rule (stride 1) on the current stimulus. Blocking.
+        */
+        float getInhibitionError(ComputeSystem &cs, float activeRatio);
+
         /*!
         \brief Get number of visible layers
         */
@@ -129,6 +129,13 @@ namespace ogmaneo {
         */
         virtual void clearMemory(ComputeSystem &cs) = 0;
 
+        /*!
+        \brief Create an inference session
+        The session shares the weights and biases of this encoder (read-only), but owns a copy of the working memory
+        (states, traces, sample histories), its scratch buffers and its kernels. Sessions must only be stepped without learning.
+        */
+        virtual std::shared_ptr<SparseFeatures> createSession(ComputeSystem &cs) const = 0;
+
         //!@{
         /*!
         \brief Serialization
@@ -15,6 +15,7 @@ SparseFeaturesChunk::SparseFeaturesChunk(ComputeSystem &cs, ComputeProgram &sfcP
     cl_int2 chunkSize,
     int numSamples,
     cl_float2 initWeightRange,
+    bool halfPrecision,
     std::mt19937 &rng)
 {
     cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -29,17 +30,35 @@ SparseFeaturesChunk::SparseFeaturesChunk(ComputeSystem &cs, ComputeProgram &sfcP
 
     _numSamples = numSamples;
 
+    _sampleHead = 0;
+
+    _halfPrecision = halfPrecision;
+
+    _quantized = false;
+
     cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
     cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
 
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(sfcProgram.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(sfcProgram.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(sfcProgram.getProgram(), "randomUniformWeights");
 
     int chunksInX = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.x) / static_cast<float>(_chunkSize.x)));
     int chunksInY = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.y) / static_cast<float>(_chunkSize.y)));
 
+    // Half precision samples and traces if the device can read and write them, weights are buffers so always can
+    cl_channel_type sampleType = CL_FLOAT;
+    cl_channel_type traceType = CL_FLOAT;
+
+    if (_halfPrecision) {
+        if (isImageFormatSupported(cs, CL_MEM_OBJECT_IMAGE3D, cl::ImageFormat(CL_R, CL_HALF_FLOAT)))
+            sampleType = CL_HALF_FLOAT;
+
+        if (isImageFormatSupported(cs, CL_MEM_OBJECT_IMAGE2D, cl::ImageFormat(CL_RG, CL_HALF_FLOAT)))
+            traceType = CL_HALF_FLOAT;
+    }
+
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
         VisibleLayer &vl = _visibleLayers[vli];
@@ -68,16 +87,16 @@ SparseFeaturesChunk::SparseFeaturesChunk(ComputeSystem &cs, ComputeProgram &sfcP
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weights = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weights = createWeightBuffer(cs, weightsSize, 1, _halfPrecision);
 
-            randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
-        vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
+        vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, traceType);
         cs.getQueue().enqueueFillImage(vl._derivedInput[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
 
-        vl._samples = createDoubleBuffer3D(cs, { vld._size.x, vld._size.y, numSamples }, CL_R, CL_FLOAT);
-        cs.getQueue().enqueueFillImage(vl._samples[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(numSamples) });
+        vl._samples = cl::Image3D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, sampleType), vld._size.x, vld._size.y, numSamples);
+        cs.getQueue().enqueueFillImage(vl._samples, zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(numSamples) });
     }
 
     // Hidden state data
@@ -94,14 +113,138 @@ SparseFeaturesChunk::SparseFeaturesChunk(ComputeSystem &cs, ComputeProgram &sfcP
     // Create kernels
     _addSampleKernel = cl::Kernel(sfcProgram.getProgram(), "sfcAddSample");
     _stimulusKernel = cl::Kernel(sfcProgram.getProgram(), "sfcStimulus");
+    _stimulusTiledKernel = cl::Kernel(sfcProgram.getProgram(), "sfcStimulusTiled");
     _activateKernel = cl::Kernel(sfcProgram.getProgram(), "sfcActivate");
     _inhibitKernel = cl::Kernel(sfcProgram.getProgram(), "sfcInhibit");
     _inhibitOtherKernel = cl::Kernel(sfcProgram.getProgram(), "sfcInhibitOther");
+    _inhibitGroupKernel = cl::Kernel(sfcProgram.getProgram(), "sfcInhibitGroup");
+    _inhibitOtherGroupKernel = cl::Kernel(sfcProgram.getProgram(), "sfcInhibitOtherGroup");
     _learnWeightsKernel = cl::Kernel(sfcProgram.getProgram(), "sfcLearnWeights");
     _deriveInputsKernel = cl::Kernel(sfcProgram.getProgram(), "sfcDeriveInputs");
+    _deriveInputsAddSampleKernel = cl::Kernel(sfcProgram.getProgram(), "sfcDeriveInputsAddSample");
+    _stimulusInhibitKernel = cl::Kernel(sfcProgram.getProgram(), "sfcStimulusInhibit");
+    _stimulusQuantizedKernel = cl::Kernel(sfcProgram.getProgram(), "sfcStimulusQuantized");
+    _quantizeWeightsKernel = cl::Kernel(sfcProgram.getProgram(), "quantizeWeights");
+
+    // Fused path needs a whole chunk in one work-group
+    {
+        std::vector<cl::size_type> maxWorkItemSizes = cs.getDevice().getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+
+        cl::size_type maxWorkGroupSize = _stimulusInhibitKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice());
+
+        _fusedActivationSupported = maxWorkItemSizes.size() >= 2
+            && static_cast<cl::size_type>(_chunkSize.x) <= maxWorkItemSizes[0]
+            && static_cast<cl::size_type>(_chunkSize.y) <= maxWorkItemSizes[1]
+            && static_cast<cl::size_type>(_chunkSize.x * _chunkSize.y) <= maxWorkGroupSize;
+
+        _fusedActivation = _fusedActivationSupported;
+    }
 }
 
 void SparseFeaturesChunk::activate(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, const cl::Image2D &predictionsPrev, std::mt19937 &rng) {
+    // Oldest sample slice becomes the newest
+    _sampleHead = (_sampleHead + _numSamples - 1) % _numSamples;
+
+    if (_fusedActivation)
+        activateFused(cs, visibleStates);
+    else
+        activateMultiKernel(cs, visibleStates);
+}
+
+void SparseFeaturesChunk::activateFused(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates) {
+    cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+    cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
+
+    int chunksInX = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.x) / static_cast<float>(_chunkSize.x)));
+    int chunksInY = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.y) / static_cast<float>(_chunkSize.y)));
+
+    // Summation buffer is only needed to carry stimulus between visible layers
+    if (_visibleLayers.size() > 1)
+        cs.getQueue().enqueueFillImage(_hiddenSummationTemp[_back], cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, zeroOrigin, hiddenRegion);
+
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+        VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+        // Derive inputs and add sample
+        {
+            int argIndex = 0;
+
+            _deriveInputsAddSampleKernel.setArg(argIndex++, visibleStates[vli]);
+            _deriveInputsAddSampleKernel.setArg(argIndex++, vl._derivedInput[_back]);
+            _deriveInputsAddSampleKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            _deriveInputsAddSampleKernel.setArg(argIndex++, vl._samples);
+            _deriveInputsAddSampleKernel.setArg(argIndex++, vld._lambda);
+            _deriveInputsAddSampleKernel.setArg(argIndex++, _sampleHead);
+
+            cs.getQueue().enqueueNDRangeKernel(_deriveInputsAddSampleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
+        }
+
+        if (vli < _visibleLayers.size() - 1) {
+            // Tiles are sized from the hidden units per chunk
+            cl_float2 hiddenToVisible = { vl._chunkToVisible.x / _chunkSize.x, vl._chunkToVisible.y / _chunkSize.y };
+
+            LocalTile tile = getLocalTile(cs, _stimulusTiledKernel, hiddenToVisible, vld._radius, _numSamples);
+
+            cl::Kernel &stimulusKernel = tile._enabled ? _stimulusTiledKernel : _stimulusKernel;
+
+            int argIndex = 0;
+
+            stimulusKernel.setArg(argIndex++, vl._samples);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+            stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._chunkToVisible);
+            stimulusKernel.setArg(argIndex++, _chunkSize);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusKernel.setArg(argIndex++, _numSamples);
+            stimulusKernel.setArg(argIndex++, _sampleHead);
+            stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            stimulusKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+            // Swap buffers
+            std::swap(_hiddenSummationTemp[_front], _hiddenSummationTemp[_back]);
+        }
+        else {
+            // Last layer: stimulus, activation and inhibition in one pass
+            int chunkArea = _chunkSize.x * _chunkSize.y;
+
+            int argIndex = 0;
+
+            _stimulusInhibitKernel.setArg(argIndex++, vl._samples);
+            _stimulusInhibitKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            _stimulusInhibitKernel.setArg(argIndex++, vl._weights._buffer);
+            _stimulusInhibitKernel.setArg(argIndex++, _hiddenActivations[_front]);
+            _stimulusInhibitKernel.setArg(argIndex++, _hiddenStates[_front]);
+            _stimulusInhibitKernel.setArg(argIndex++, _chunkWinners[_front]);
+            _stimulusInhibitKernel.setArg(argIndex++, _hiddenSize);
+            _stimulusInhibitKernel.setArg(argIndex++, vld._size);
+            _stimulusInhibitKernel.setArg(argIndex++, vl._chunkToVisible);
+            _stimulusInhibitKernel.setArg(argIndex++, _chunkSize);
+            _stimulusInhibitKernel.setArg(argIndex++, vld._radius);
+            _stimulusInhibitKernel.setArg(argIndex++, _numSamples);
+            _stimulusInhibitKernel.setArg(argIndex++, _sampleHead);
+            _stimulusInhibitKernel.setArg(argIndex++, vld._ignoreMiddle);
+            _stimulusInhibitKernel.setArg(argIndex++, static_cast<cl_uchar>(_visibleLayers.size() > 1));
+            _stimulusInhibitKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
+            _stimulusInhibitKernel.setArg(argIndex++, cl::Local(chunkArea * sizeof(cl_float)));
+            _stimulusInhibitKernel.setArg(argIndex++, cl::Local(chunkArea * sizeof(cl_int)));
+
+            // Global size is rounded up to whole chunks, the kernel bounds checks
+            cs.getQueue().enqueueNDRangeKernel(_stimulusInhibitKernel, cl::NullRange,
+                cl::NDRange(chunksInX * _chunkSize.x, chunksInY * _chunkSize.y), cl::NDRange(_chunkSize.x, _chunkSize.y));
+        }
+    }
+}
+
+void SparseFeaturesChunk::activateMultiKernel(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates) {
     cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
     cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
 
@@ -130,28 +273,59 @@ void SparseFeaturesChunk::activate(ComputeSystem &cs, const std::vector<cl::Imag
             int argIndex = 0;
 
             _addSampleKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _addSampleKernel.setArg(argIndex++, vl._samples[_back]);
-            _addSampleKernel.setArg(argIndex++, vl._samples[_front]);
-            _addSampleKernel.setArg(argIndex++, _numSamples);
+            _addSampleKernel.setArg(argIndex++, vl._samples);
+            _addSampleKernel.setArg(argIndex++, _sampleHead);
 
             cs.getQueue().enqueueNDRangeKernel(_addSampleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
         }
 
-        {
+        if (_quantized) {
             int argIndex = 0;
 
-            _stimulusKernel.setArg(argIndex++, vl._samples[_front]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weights[_back]);
-            _stimulusKernel.setArg(argIndex++, vld._size);
-            _stimulusKernel.setArg(argIndex++, vl._chunkToVisible);
-            _stimulusKernel.setArg(argIndex++, _chunkSize);
-            _stimulusKernel.setArg(argIndex++, vld._radius);
-            _stimulusKernel.setArg(argIndex++, _numSamples);
-            _stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
-
-            cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            _stimulusQuantizedKernel.setArg(argIndex++, vl._samples);
+            _stimulusQuantizedKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            _stimulusQuantizedKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+            _stimulusQuantizedKernel.setArg(argIndex++, vl._quantizedWeights._values);
+            _stimulusQuantizedKernel.setArg(argIndex++, vl._quantizedWeights._scales);
+            _stimulusQuantizedKernel.setArg(argIndex++, _hiddenSize);
+            _stimulusQuantizedKernel.setArg(argIndex++, vld._size);
+            _stimulusQuantizedKernel.setArg(argIndex++, vl._chunkToVisible);
+            _stimulusQuantizedKernel.setArg(argIndex++, _chunkSize);
+            _stimulusQuantizedKernel.setArg(argIndex++, vld._radius);
+            _stimulusQuantizedKernel.setArg(argIndex++, _numSamples);
+            _stimulusQuantizedKernel.setArg(argIndex++, _sampleHead);
+            _stimulusQuantizedKernel.setArg(argIndex++, vld._ignoreMiddle);
+
+            cs.getQueue().enqueueNDRangeKernel(_stimulusQuantizedKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+        }
+        else {
+            // Tiles are sized from the hidden units per chunk
+            cl_float2 hiddenToVisible = { vl._chunkToVisible.x / _chunkSize.x, vl._chunkToVisible.y / _chunkSize.y };
+
+            LocalTile tile = getLocalTile(cs, _stimulusTiledKernel, hiddenToVisible, vld._radius, _numSamples);
+
+            cl::Kernel &stimulusKernel = tile._enabled ? _stimulusTiledKernel : _stimulusKernel;
+
+            int argIndex = 0;
+
+            stimulusKernel.setArg(argIndex++, vl._samples);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+            stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._chunkToVisible);
+            stimulusKernel.setArg(argIndex++, _chunkSize);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusKernel.setArg(argIndex++, _numSamples);
+            stimulusKernel.setArg(argIndex++, _sampleHead);
+            stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            stimulusKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -174,15 +348,22 @@ void SparseFeaturesChunk::activate(ComputeSystem &cs, const std::vector<cl::Imag
         int chunksInX = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.x) / static_cast<float>(_chunkSize.x)));
         int chunksInY = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.y) / static_cast<float>(_chunkSize.y)));
 
+        bool group = useGroupReduction(cs, _inhibitGroupKernel, _chunkSize);
+
+        cl::Kernel &inhibitKernel = group ? _inhibitGroupKernel : _inhibitKernel;
+
         int argIndex = 0;
 
-        _inhibitKernel.setArg(argIndex++, _hiddenActivations[_front]);
-        _inhibitKernel.setArg(argIndex++, _hiddenStates[_front]);
-        _inhibitKernel.setArg(argIndex++, _chunkWinners[_front]);
-        _inhibitKernel.setArg(argIndex++, _hiddenSize);
-        _inhibitKernel.setArg(argIndex++, _chunkSize);
+        inhibitKernel.setArg(argIndex++, _hiddenActivations[_front]);
+        inhibitKernel.setArg(argIndex++, _hiddenStates[_front]);
+        inhibitKernel.setArg(argIndex++, _chunkWinners[_front]);
+        inhibitKernel.setArg(argIndex++, _hiddenSize);
+        inhibitKernel.setArg(argIndex++, _chunkSize);
 
-        cs.getQueue().enqueueNDRangeKernel(_inhibitKernel, cl::NullRange, cl::NDRange(chunksInX, chunksInY));
+        if (group)
+            enqueueGroupReduction(cs, inhibitKernel, argIndex, _chunkSize, { chunksInX, chunksInY });
+        else
+            cs.getQueue().enqueueNDRangeKernel(inhibitKernel, cl::NullRange, cl::NDRange(chunksInX, chunksInY));
     }
 }
 
@@ -200,11 +381,17 @@ void SparseFeaturesChunk::stepEnd(ComputeSystem &cs) {
         VisibleLayerDesc &vld = _visibleLayerDescs[vli];
 
         std::swap(vl._derivedInput[_front], vl._derivedInput[_back]);
-        std::swap(vl._samples[_front], vl._samples[_back]);
     }
 }
 
 void SparseFeaturesChunk::learn(ComputeSystem &cs, const cl::Image2D &predictionsPrev, std::mt19937 &rng) {
+    // Quantized weights are frozen
+    if (_quantized)
+        return;
+
+    int chunksInX = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.x) / static_cast<float>(_chunkSize.x)));
+    int chunksInY = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.y) / static_cast<float>(_chunkSize.y)));
+
     // Learn weights
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
         VisibleLayer &vl = _visibleLayers[vli];
@@ -216,9 +403,8 @@ void SparseFeaturesChunk::learn(ComputeSystem &cs, const cl::Image2D &prediction
 
             _learnWeightsKernel.setArg(argIndex++, _chunkWinners[_front]);
             _learnWeightsKernel.setArg(argIndex++, _chunkWinners[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._samples[_front]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
+            _learnWeightsKernel.setArg(argIndex++, vl._samples);
+            _learnWeightsKernel.setArg(argIndex++, vl._weights._buffer);
             _learnWeightsKernel.setArg(argIndex++, _hiddenSize);
             _learnWeightsKernel.setArg(argIndex++, vld._size);
             _learnWeightsKernel.setArg(argIndex++, vl._chunkToVisible);
@@ -226,11 +412,12 @@ void SparseFeaturesChunk::learn(ComputeSystem &cs, const cl::Image2D &prediction
             _learnWeightsKernel.setArg(argIndex++, vld._radius);
             _learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
             _learnWeightsKernel.setArg(argIndex++, _numSamples);
+            _learnWeightsKernel.setArg(argIndex++, _sampleHead);
+            _learnWeightsKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
-            cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            // Only the chunk winners and their neighbors learn
+            cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(chunksInX * 3, chunksInY * 3));
         }
-
-        std::swap(vl._weights[_front], vl._weights[_back]);
     }
 }
 
@@ -240,14 +427,21 @@ void SparseFeaturesChunk::inhibit(ComputeSystem &cs, const cl::Image2D &activati
         int chunksInX = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.x) / static_cast<float>(_chunkSize.x)));
         int chunksInY = static_cast<int>(std::ceil(static_cast<float>(_hiddenSize.y) / static_cast<float>(_chunkSize.y)));
 
+        bool group = useGroupReduction(cs, _inhibitOtherGroupKernel, _chunkSize);
+
+        cl::Kernel &inhibitOtherKernel = group ? _inhibitOtherGroupKernel : _inhibitOtherKernel;
+
         int argIndex = 0;
 
-        _inhibitOtherKernel.setArg(argIndex++, activations);
-        _inhibitOtherKernel.setArg(argIndex++, states);
-        _inhibitOtherKernel.setArg(argIndex++, _hiddenSize);
-        _inhibitOtherKernel.setArg(argIndex++, _chunkSize);
+        inhibitOtherKernel.setArg(argIndex++, activations);
+        inhibitOtherKernel.setArg(argIndex++, states);
+        inhibitOtherKernel.setArg(argIndex++, _hiddenSize);
+        inhibitOtherKernel.setArg(argIndex++, _chunkSize);
 
-        cs.getQueue().enqueueNDRangeKernel(_inhibitOtherKernel, cl::NullRange, cl::NDRange(chunksInX, chunksInY));
+        if (group)
+            enqueueGroupReduction(cs, inhibitOtherKernel, argIndex, _chunkSize, { chunksInX, chunksInY });
+        else
+            cs.getQueue().enqueueNDRangeKernel(inhibitOtherKernel, cl::NullRange, cl::NDRange(chunksInX, chunksInY));
     }
 }
 
@@ -261,13 +455,70 @@ void SparseFeaturesChunk::clearMemory(ComputeSystem &cs) {
     cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
     cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
 
+    _sampleHead = 0;
+
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
         VisibleLayer &vl = _visibleLayers[vli];
         VisibleLayerDesc &vld = _visibleLayerDescs[vli];
 
         cs.getQueue().enqueueFillImage(vl._derivedInput[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
-        cs.getQueue().enqueueFillImage(vl._samples[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(_numSamples) });
+        cs.getQueue().enqueueFillImage(vl._samples, zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(_numSamples) });
+    }
+}
+
+std::shared_ptr<SparseFeatures> SparseFeaturesChunk::createSession(ComputeSystem &cs) const {
+    // Copy shares all image handles, then replace the working memory with private copies
+    std::shared_ptr<SparseFeaturesChunk> session = std::make_shared<SparseFeaturesChunk>(*this);
+
+    session->_hiddenStates = cloneDoubleBuffer2D(cs, _hiddenStates);
+    session->_hiddenActivations = cloneDoubleBuffer2D(cs, _hiddenActivations);
+    session->_chunkWinners = cloneDoubleBuffer2D(cs, _chunkWinners);
+
+    for (int vli = 0; vli < session->_visibleLayers.size(); vli++) {
+        VisibleLayer &vl = session->_visibleLayers[vli];
+
+        vl._derivedInput = cloneDoubleBuffer2D(cs, vl._derivedInput);
+        vl._samples = cloneImage3D(cs, vl._samples);
+    }
+
+    session->_hiddenSummationTemp = cloneDoubleBuffer2D(cs, _hiddenSummationTemp);
+
+    // Own kernels, arguments are set per object
+    session->_addSampleKernel = cloneKernel(_addSampleKernel);
+    session->_stimulusKernel = cloneKernel(_stimulusKernel);
+    session->_stimulusTiledKernel = cloneKernel(_stimulusTiledKernel);
+    session->_activateKernel = cloneKernel(_activateKernel);
+    session->_inhibitKernel = cloneKernel(_inhibitKernel);
+    session->_inhibitOtherKernel = cloneKernel(_inhibitOtherKernel);
+    session->_inhibitGroupKernel = cloneKernel(_inhibitGroupKernel);
+    session->_inhibitOtherGroupKernel = cloneKernel(_inhibitOtherGroupKernel);
+    session->_learnWeightsKernel = cloneKernel(_learnWeightsKernel);
+    session->_deriveInputsKernel = cloneKernel(_deriveInputsKernel);
+    session->_deriveInputsAddSampleKernel = cloneKernel(_deriveInputsAddSampleKernel);
+    session->_stimulusInhibitKernel = cloneKernel(_stimulusInhibitKernel);
+    session->_stimulusQuantizedKernel = cloneKernel(_stimulusQuantizedKernel);
+    session->_quantizeWeightsKernel = cloneKernel(_quantizeWeightsKernel);
+
+    return session;
+}
+
+void SparseFeaturesChunk::quantize(ComputeSystem &cs) {
+    if (_quantized)
+        return;
+
+    for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+        VisibleLayer &vl = _visibleLayers[vli];
+
+        vl._quantizedWeights = ogmaneo::quantize(vl._weights, cs, _quantizeWeightsKernel);
+
+        // Sessions sharing the full precision weights keep them alive
+        vl._weights._buffer = cl::Buffer();
     }
+
+    _quantized = true;
+
+    // Fused kernel only reads full precision weights
+    _fusedActivation = false;
 }
 
 void SparseFeaturesChunk::VisibleLayerDesc::load(const schemas::VisibleChunkLayerDesc* fbVisibleChunkLayerDesc, ComputeSystem &cs) {
@@ -285,8 +536,17 @@ schemas::VisibleChunkLayerDesc SparseFeaturesChunk::VisibleLayerDesc::save(flatb
 
 void SparseFeaturesChunk::VisibleLayer::load(const schemas::VisibleChunkLayer* fbVisibleChunkLayer, ComputeSystem &cs) {
     ogmaneo::load(_derivedInput, fbVisibleChunkLayer->_derivedInput(), cs);
-    ogmaneo::load(_samples, fbVisibleChunkLayer->_samples(), cs);
-    ogmaneo::load(_weights, fbVisibleChunkLayer->_weights(), cs);
+    // Ring buffer is stored as the back buffer, older files hold the shifted history there (head 0)
+    ogmaneo::load(_samples, fbVisibleChunkLayer->_samples()->_back(), cs);
+
+    if (fbVisibleChunkLayer->_quantizedWeights() != nullptr) {
+        ogmaneo::load(_quantizedWeights, fbVisibleChunkLayer->_quantizedWeights(), cs);
+
+        _weights._buffer = cl::Buffer();
+    }
+    else
+        ogmaneo::load(_weights, fbVisibleChunkLayer->_weights(), cs);
+
     _hiddenToVisible = cl_float2{ fbVisibleChunkLayer->_hiddenToVisible()->x(), fbVisibleChunkLayer->_hiddenToVisible()->y() };
     _visibleToHidden = cl_float2{ fbVisibleChunkLayer->_visibleToHidden()->x(), fbVisibleChunkLayer->_visibleToHidden()->y() };
     _reverseRadii = cl_int2{ fbVisibleChunkLayer->_reverseRadii()->x(), fbVisibleChunkLayer->_reverseRadii()->y() };
@@ -297,11 +557,15 @@ flatbuffers::Offset<schemas::VisibleChunkLayer> SparseFeaturesChunk::VisibleLaye
     schemas::float2 visibleToHidden(_visibleToHidden.x, _visibleToHidden.y);
     schemas::int2 reverseRadii(_reverseRadii.x, _reverseRadii.y);
 
+    // Single ring buffer image, stored as both halves of the double buffer (loaded from _back)
+    flatbuffers::Offset<schemas::Image3D> samples = ogmaneo::save(_samples, builder, cs);
+
     return schemas::CreateVisibleChunkLayer(builder,
         ogmaneo::save(_derivedInput, builder, cs),
-        ogmaneo::save(_samples, builder, cs),
+        schemas::CreateDoubleBuffer3D(builder, samples, samples),
         ogmaneo::save(_weights, builder, cs),
-        &hiddenToVisible, &visibleToHidden, &reverseRadii);
+        &hiddenToVisible, &visibleToHidden, &reverseRadii,
+        (_quantizedWeights._values.get() != nullptr ? ogmaneo::save(_quantizedWeights, builder, cs) : 0));
 }
 
 void SparseFeaturesChunk::SparseFeaturesChunkDesc::load(const schemas::SparseFeaturesChunkDesc* fbSparseFeaturesChunkDesc, ComputeSystem &cs) {
@@ -312,6 +576,7 @@ void SparseFeaturesChunk::SparseFeaturesChunkDesc::load(const schemas::SparseFea
     _hiddenSize = cl_int2{ fbSparseFeaturesChunkDesc->_hiddenSize()->x(), fbSparseFeaturesChunkDesc->_hiddenSize()->y() };
     _chunkSize = cl_int2{ fbSparseFeaturesChunkDesc->_chunkSize()->x(), fbSparseFeaturesChunkDesc->_chunkSize()->y() };
     _initWeightRange = cl_float2{ fbSparseFeaturesChunkDesc->_initWeightRange()->x(), fbSparseFeaturesChunkDesc->_initWeightRange()->y() };
+    _halfPrecision = fbSparseFeaturesChunkDesc->_halfPrecision();
 
     for (flatbuffers::uoffset_t i = 0; i < fbSparseFeaturesChunkDesc->_visibleLayerDescs()->Length(); i++) {
         _visibleLayerDescs[i].load(fbSparseFeaturesChunkDesc->_visibleLayerDescs()->Get(i), cs);
@@ -324,12 +589,13 @@ flatbuffers::Offset<schemas::SparseFeaturesChunkDesc> SparseFeaturesChunk::Spars
     schemas::float2 initWeightRange(_initWeightRange.x, _initWeightRange.y);
 
     std::vector<schemas::VisibleChunkLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     return schemas::CreateSparseFeaturesChunkDesc(builder,
         &hiddenSize, &chunkSize, _numSamples,
-        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs));
+        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs),
+        _halfPrecision);
 }
 
 void SparseFeaturesChunk::load(const schemas::SparseFeatures* fbSparseFeatures, ComputeSystem &cs) {
@@ -346,6 +612,10 @@ void SparseFeaturesChunk::load(const schemas::SparseFeatures* fbSparseFeatures,
     _chunkSize = cl_int2{ fbSparseFeaturesChunk->_chunkSize()->x(), fbSparseFeaturesChunk->_chunkSize()->y() };
 
     _numSamples = fbSparseFeaturesChunk->_numSamples();
+    _sampleHead = fbSparseFeaturesChunk->_sampleHead();
+
+    // Storage precision is fixed at construction (from the desc), buffers must match
+    assert(_halfPrecision == fbSparseFeaturesChunk->_halfPrecision());
 
     ogmaneo::load(_hiddenStates, fbSparseFeaturesChunk->_hiddenStates(), cs);
     ogmaneo::load(_hiddenActivations, fbSparseFeaturesChunk->_hiddenActivations(), cs);
@@ -359,6 +629,11 @@ void SparseFeaturesChunk::load(const schemas::SparseFeatures* fbSparseFeatures,
     for (flatbuffers::uoffset_t i = 0; i < fbSparseFeaturesChunk->_visibleLayers()->Length(); i++) {
         _visibleLayers[i].load(fbSparseFeaturesChunk->_visibleLayers()->Get(i), cs);
     }
+
+    _quantized = !_visibleLayers.empty() && _visibleLayers.front()._quantizedWeights._values.get() != nullptr;
+
+    if (_quantized)
+        _fusedActivation = false;
 }
 
 flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesChunk::save(flatbuffers::FlatBufferBuilder &builder, ComputeSystem &cs) {
@@ -366,11 +641,11 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesChunk::save(flatbuffe
     schemas::int2 chunkSize(_chunkSize.x, _chunkSize.y);
 
     std::vector<schemas::VisibleChunkLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::VisibleChunkLayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     flatbuffers::Offset<schemas::SparseFeaturesChunk> sf = schemas::CreateSparseFeaturesChunk(builder,
@@ -378,9 +653,10 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesChunk::save(flatbuffe
         ogmaneo::save(_hiddenActivations, builder, cs),
         ogmaneo::save(_chunkWinners, builder, cs),
         &hiddenSize, &chunkSize, _numSamples,
-        ogmaneo::save(_hiddenSummationTemp, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTemp, builder, cs),
         builder.CreateVectorOfStructs(visibleLayerDescs),
-        builder.CreateVector(visibleLayers));
+        builder.CreateVector(visibleLayers),
+        _sampleHead, _halfPrecision);
 
     return schemas::CreateSparseFeatures(builder,
         schemas::SparseFeaturesType::SparseFeaturesType_SparseFeaturesChunk, sf.Union());
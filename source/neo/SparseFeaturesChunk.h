@@ -76,13 +76,19 @@ namespace ogmaneo {
 
             /*!
             \brief Samples (time sliced derived inputs)
+            Ring buffer, sample s (0 is newest) is in slice (_sampleHead + s) % _numSamples.
             */
-            DoubleBuffer3D _samples;
+            cl::Image3D _samples;
 
             /*!
             \brief Weights
             */
-            DoubleBuffer3D _weights;
+            WeightBuffer _weights;
+
+            /*!
+            \brief Quantized weights (int8, inference only)
+            */
+            QuantizedWeightBuffer _quantizedWeights;
 
             //!@{
             /*!
@@ -121,6 +127,7 @@ namespace ogmaneo {
             cl_int2 _chunkSize;
             int _numSamples;
             cl_float2 _initWeightRange;
+            bool _halfPrecision;
             std::mt19937 _rng;
             //!@}
 
@@ -132,6 +139,7 @@ namespace ogmaneo {
                 _chunkSize({ 6, 6 }),
                 _numSamples(2),
                 _initWeightRange({ -0.01f, 0.01f }),
+                _halfPrecision(false),
                 _rng()
             {
                 _name = "chunk";
@@ -153,7 +161,7 @@ namespace ogmaneo {
             \brief Factory
             */
             std::shared_ptr<SparseFeatures> sparseFeaturesFactory() override {
-                return std::make_shared<SparseFeaturesChunk>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _chunkSize, _numSamples, _initWeightRange, _rng);
+                return std::make_shared<SparseFeaturesChunk>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _chunkSize, _numSamples, _initWeightRange, _halfPrecision, _rng);
             }
 
             //!@{
@@ -204,11 +212,51 @@ namespace ogmaneo {
         */
         cl::Kernel _addSampleKernel;
         cl::Kernel _stimulusKernel;
+        cl::Kernel _stimulusTiledKernel;
         cl::Kernel _activateKernel;
         cl::Kernel _inhibitKernel;
         cl::Kernel _inhibitOtherKernel;
+        cl::Kernel _inhibitGroupKernel;
+        cl::Kernel _inhibitOtherGroupKernel;
         cl::Kernel _learnWeightsKernel;
         cl::Kernel _deriveInputsKernel;
+        cl::Kernel _deriveInputsAddSampleKernel;
+        cl::Kernel _stimulusInhibitKernel;
+        cl::Kernel _stimulusQuantizedKernel;
+        cl::Kernel _quantizeWeightsKernel;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Fused activation path
+        One kernel per visible layer, the last one also activates and inhibits with a work-group per chunk.
+        Only supported if a chunk fits in a work-group.
+        */
+        bool _fusedActivation;
+        bool _fusedActivationSupported;
+        //!@}
+
+        /*!
+        \brief Slice of the newest sample in the sample ring buffers
+        */
+        int _sampleHead;
+
+        /*!
+        \brief Whether weights, samples and traces are stored in half precision (accumulation is still fp32)
+        */
+        bool _halfPrecision;
+
+        /*!
+        \brief Whether the weights are quantized (int8, inference only)
+        */
+        bool _quantized;
+
+        //!@{
+        /*!
+        \brief Activation paths
+        */
+        void activateFused(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates);
+        void activateMultiKernel(ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates);
         //!@}
 
     public:
@@ -222,13 +270,16 @@ namespace ogmaneo {
         /*!
         \brief Default constructor
         */
-        SparseFeaturesChunk() {};
+        SparseFeaturesChunk()
+            : _fusedActivation(false), _fusedActivationSupported(false), _sampleHead(0), _halfPrecision(false), _quantized(false)
+        {}
 
         /*!
         \brief Create a comparison sparse coder with random initialization
         Requires the compute system, program with the NeoRL kernels, and initialization information.
         \param visibleLayerDescs descriptors for each input layer.
         \param hiddenSize hidden layer (SDR) size (2D).
+        \param halfPrecision store weights, samples and traces as fp16.
         \param rng a random number generator.
         */
         SparseFeaturesChunk(ComputeSystem &cs, ComputeProgram &sfcProgram,
@@ -237,6 +288,7 @@ namespace ogmaneo {
             cl_int2 chunkSize,
             int numSamples,
             cl_float2 initWeightRange,
+            bool halfPrecision,
             std::mt19937 &rng);
 
         /*!
@@ -266,6 +318,44 @@ namespace ogmaneo {
         */
         void inhibit(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, std::mt19937 &rng) override;
 
+        /*!
+        \brief Enable or disable the fused activation path (enabled by default when supported)
+        Disabling falls back to the multi-kernel path. Returns whether the fused path is active.
+        Quantized encoders always use the multi-kernel path.
+        */
+        bool setFusedActivation(bool fused) {
+            _fusedActivation = fused && _fusedActivationSupported && !_quantized;
+
+            return _fusedActivation;
+        }
+
+        /*!
+        \brief Whether the fused activation path is active
+        */
+        bool getFusedActivation() const {
+            return _fusedActivation;
+        }
+
+        /*!
+        \brief Quantize the weights to int8 with a scale per hidden unit and release the full precision weights
+        Afterwards the encoder is inference only, learn does nothing.
+        */
+        void quantize(ComputeSystem &cs);
+
+        /*!
+        \brief Whether the weights are quantized
+        */
+        bool isQuantized() const {
+            return _quantized;
+        }
+
+        /*!
+        \brief Whether weights, samples and traces are stored in half precision
+        */
+        bool getHalfPrecision() const {
+            return _halfPrecision;
+        }
+
         /*!
         \brief Get number of visible layers
         */
@@ -322,11 +412,23 @@ namespace ogmaneo {
             return _chunkWinners;
         }
 
+        /*!
+        \brief Get chunk size
+        */
+        cl_int2 getChunkSize() const {
+            return _chunkSize;
+        }
+
         /*!
         \brief Clear the working memory
         */
         void clearMemory(ComputeSystem &cs) override;
 
+        /*!
+        \brief Create an inference session sharing this encoder's weights and biases
+        */
+        std::shared_ptr<SparseFeatures> createSession(ComputeSystem &cs) const override;
+
         //!@{
         /*!
         \brief Serialization
@@ -14,8 +14,9 @@ SparseFeaturesDelay::SparseFeaturesDelay(ComputeSystem &cs, ComputeProgram &sfdP
     const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize,
     cl_int inhibitionRadius, cl_float biasAlpha,
     cl_float activeRatio, cl_float2 initWeightRange,
+    bool halfPrecision,
     std::mt19937 &rng)
-    : _hiddenSize(hiddenSize), _inhibitionRadius(inhibitionRadius), _activeRatio(activeRatio), _biasAlpha(biasAlpha)
+    : _hiddenSize(hiddenSize), _inhibitionRadius(inhibitionRadius), _halfPrecision(halfPrecision), _activeRatio(activeRatio), _biasAlpha(biasAlpha)
 {
     cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
 
@@ -29,7 +30,7 @@ SparseFeaturesDelay::SparseFeaturesDelay(ComputeSystem &cs, ComputeProgram &sfdP
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(sfdProgram.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(sfdProgram.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(sfdProgram.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -55,9 +56,9 @@ SparseFeaturesDelay::SparseFeaturesDelay(ComputeSystem &cs, ComputeProgram &sfdP
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weights = createDoubleBuffer3D(cs, weightsSize, CL_RGBA, CL_FLOAT);
+            vl._weights = createWeightBuffer(cs, weightsSize, 4, _halfPrecision);
 
-            randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_R, CL_FLOAT);
@@ -81,6 +82,7 @@ SparseFeaturesDelay::SparseFeaturesDelay(ComputeSystem &cs, ComputeProgram &sfdP
 
     // Create kernels
     _stimulusKernel = cl::Kernel(sfdProgram.getProgram(), "sfdStimulus");
+    _stimulusTiledKernel = cl::Kernel(sfdProgram.getProgram(), "sfdStimulusTiled");
     _activateKernel = cl::Kernel(sfdProgram.getProgram(), "sfdActivate");
     _inhibitKernel = cl::Kernel(sfdProgram.getProgram(), "sfdInhibit");
     _learnWeightsKernel = cl::Kernel(sfdProgram.getProgram(), "sfdLearnWeights");
@@ -110,18 +112,27 @@ void SparseFeaturesDelay::activate(ComputeSystem &cs, const std::vector<cl::Imag
         }
 
         {
-            int argIndex = 0;
+            LocalTile tile = getLocalTile(cs, _stimulusTiledKernel, vl._hiddenToVisible, vld._radius);
+
+            cl::Kernel &stimulusKernel = tile._enabled ? _stimulusTiledKernel : _stimulusKernel;
 
-            _stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weights[_back]);
-            _stimulusKernel.setArg(argIndex++, vld._size);
-            _stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
-            _stimulusKernel.setArg(argIndex++, vld._radius);
-            _stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            int argIndex = 0;
 
-            cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+            stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            stimulusKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -185,8 +196,8 @@ void SparseFeaturesDelay::learn(ComputeSystem &cs, const cl::Image2D &prediction
             _learnWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
             _learnWeightsKernel.setArg(argIndex++, vl._derivedInput[_front]);
             _learnWeightsKernel.setArg(argIndex++, vl._derivedInput[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
+            _learnWeightsKernel.setArg(argIndex++, vl._weights._buffer);
+            _learnWeightsKernel.setArg(argIndex++, _hiddenSize);
             _learnWeightsKernel.setArg(argIndex++, vld._size);
             _learnWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
             _learnWeightsKernel.setArg(argIndex++, vld._radius);
@@ -194,11 +205,10 @@ void SparseFeaturesDelay::learn(ComputeSystem &cs, const cl::Image2D &prediction
             _learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
             _learnWeightsKernel.setArg(argIndex++, vld._lambda);
             _learnWeightsKernel.setArg(argIndex++, vld._gamma);
+            _learnWeightsKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
             cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
-
-        std::swap(vl._weights[_front], vl._weights[_back]);
     }
 
     // Bias update
@@ -251,6 +261,33 @@ void SparseFeaturesDelay::clearMemory(ComputeSystem &cs) {
     }
 }
 
+std::shared_ptr<SparseFeatures> SparseFeaturesDelay::createSession(ComputeSystem &cs) const {
+    // Copy shares all image handles, then replace the working memory with private copies
+    std::shared_ptr<SparseFeaturesDelay> session = std::make_shared<SparseFeaturesDelay>(*this);
+
+    session->_hiddenActivations = cloneDoubleBuffer2D(cs, _hiddenActivations);
+    session->_hiddenStates = cloneDoubleBuffer2D(cs, _hiddenStates);
+
+    for (int vli = 0; vli < session->_visibleLayers.size(); vli++) {
+        VisibleLayer &vl = session->_visibleLayers[vli];
+
+        vl._derivedInput = cloneDoubleBuffer2D(cs, vl._derivedInput);
+    }
+
+    session->_hiddenSummationTemp = cloneDoubleBuffer2D(cs, _hiddenSummationTemp);
+
+    // Own kernels, arguments are set per object
+    session->_stimulusKernel = cloneKernel(_stimulusKernel);
+    session->_stimulusTiledKernel = cloneKernel(_stimulusTiledKernel);
+    session->_activateKernel = cloneKernel(_activateKernel);
+    session->_inhibitKernel = cloneKernel(_inhibitKernel);
+    session->_learnWeightsKernel = cloneKernel(_learnWeightsKernel);
+    session->_learnBiasesKernel = cloneKernel(_learnBiasesKernel);
+    session->_deriveInputsKernel = cloneKernel(_deriveInputsKernel);
+
+    return session;
+}
+
 void SparseFeaturesDelay::VisibleLayerDesc::load(const schemas::VisibleDelayLayerDesc* fbVisibleDelayLayerDesc, ComputeSystem &cs) {
     _size = cl_int2{ fbVisibleDelayLayerDesc->_size().x(), fbVisibleDelayLayerDesc->_size().y() };
     _radius = fbVisibleDelayLayerDesc->_radius();
@@ -294,6 +331,7 @@ void SparseFeaturesDelay::SparseFeaturesDelayDesc::load(const schemas::SparseFea
     _biasAlpha = fbSparseFeaturesDelayDesc->_biasAlpha();
     _activeRatio = fbSparseFeaturesDelayDesc->_activeRatio();
     _initWeightRange = cl_float2{ fbSparseFeaturesDelayDesc->_initWeightRange()->x(), fbSparseFeaturesDelayDesc->_initWeightRange()->y() };
+    _halfPrecision = fbSparseFeaturesDelayDesc->_halfPrecision();
 
     for (flatbuffers::uoffset_t i = 0; i < fbSparseFeaturesDelayDesc->_visibleLayerDescs()->Length(); i++) {
         _visibleLayerDescs[i].load(fbSparseFeaturesDelayDesc->_visibleLayerDescs()->Get(i), cs);
@@ -305,12 +343,13 @@ flatbuffers::Offset<schemas::SparseFeaturesDelayDesc> SparseFeaturesDelay::Spars
     schemas::float2 initWeightRange(_initWeightRange.x, _initWeightRange.y);
 
     std::vector<schemas::VisibleDelayLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     return schemas::CreateSparseFeaturesDelayDesc(builder,
         &hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio,
-        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs));
+        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs),
+        _halfPrecision);
 }
 
 void SparseFeaturesDelay::load(const schemas::SparseFeatures* fbSparseFeatures, ComputeSystem &cs) {
@@ -327,6 +366,9 @@ void SparseFeaturesDelay::load(const schemas::SparseFeatures* fbSparseFeatures,
 
     _inhibitionRadius = fbSparseFeaturesDelay->_inhibitionRadius();
 
+    // Storage precision is fixed at construction (from the desc), buffers must match
+    assert(_halfPrecision == fbSparseFeaturesDelay->_halfPrecision());
+
     ogmaneo::load(_hiddenActivations, fbSparseFeaturesDelay->_hiddenActivations(), cs);
     ogmaneo::load(_hiddenStates, fbSparseFeaturesDelay->_hiddenStates(), cs);
     ogmaneo::load(_hiddenBiases, fbSparseFeaturesDelay->_hiddenBiases(), cs);
@@ -345,11 +387,11 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesDelay::save(flatbuffe
     schemas::int2 hiddenSize(_hiddenSize.x, _hiddenSize.y);
 
     std::vector<schemas::VisibleDelayLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::VisibleDelayLayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     flatbuffers::Offset<schemas::SparseFeaturesDelay> sf = schemas::CreateSparseFeaturesDelay(builder,
@@ -357,10 +399,11 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesDelay::save(flatbuffe
         ogmaneo::save(_hiddenStates, builder, cs),
         ogmaneo::save(_hiddenBiases, builder, cs),
         &hiddenSize, _inhibitionRadius,
-        ogmaneo::save(_hiddenSummationTemp, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTemp, builder, cs),
         _biasAlpha, _activeRatio,
         builder.CreateVectorOfStructs(visibleLayerDescs),
-        builder.CreateVector(visibleLayers));
+        builder.CreateVector(visibleLayers),
+        _halfPrecision);
 
     return schemas::CreateSparseFeatures(builder,
         schemas::SparseFeaturesType::SparseFeaturesType_SparseFeaturesDelay, sf.Union());
@@ -82,7 +82,7 @@ namespace ogmaneo {
             /*!
             \brief Weights
             */
-            DoubleBuffer3D _weights; // Encoding weights (creates spatio-temporal sparse code)
+            WeightBuffer _weights; // Encoding weights (creates spatio-temporal sparse code)
 
             //!@{
             /*!
@@ -120,6 +120,7 @@ namespace ogmaneo {
             cl_float _biasAlpha;
             cl_float _activeRatio;
             cl_float2 _initWeightRange;
+            bool _halfPrecision;
             std::mt19937 _rng;
             //!@}
 
@@ -131,6 +132,7 @@ namespace ogmaneo {
                 _inhibitionRadius(6),
                 _biasAlpha(0.01f), _activeRatio(0.01f),
                 _initWeightRange({ -0.01f, 0.01f }),
+                _halfPrecision(false),
                 _rng()
             {
                 _name = "delay";
@@ -152,7 +154,7 @@ namespace ogmaneo {
             \brief Factory
             */
             std::shared_ptr<SparseFeatures> sparseFeaturesFactory() override {
-                return std::make_shared<SparseFeaturesDelay>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio, _initWeightRange, _rng);
+                return std::make_shared<SparseFeaturesDelay>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio, _initWeightRange, _halfPrecision, _rng);
             }
 
             //!@{
@@ -189,6 +191,11 @@ namespace ogmaneo {
         */
         DoubleBuffer2D _hiddenSummationTemp;
 
+        /*!
+        \brief Whether the weights (and their traces) are stored in half precision (accumulation is still fp32)
+        */
+        bool _halfPrecision;
+
         //!@{
         /*!
         \brief Layers and descs
@@ -202,6 +209,7 @@ namespace ogmaneo {
         \brief Kernels
         */
         cl::Kernel _stimulusKernel;
+        cl::Kernel _stimulusTiledKernel;
         cl::Kernel _activateKernel;
         cl::Kernel _inhibitKernel;
         cl::Kernel _learnWeightsKernel;
@@ -221,13 +229,16 @@ namespace ogmaneo {
         /*!
         \brief Default constructor
         */
-        SparseFeaturesDelay() {};
+        SparseFeaturesDelay()
+            : _halfPrecision(false)
+        {}
 
         /*!
         \brief Create a comparison sparse coder with random initialization
         Requires the compute system, program with the NeoRL kernels, and initialization information.
         \param visibleLayerDescs descriptors for each input layer.
         \param hiddenSize hidden layer (SDR) size (2D).
+        \param halfPrecision store weights and their traces as fp16.
         \param rng a random number generator.
         */
         SparseFeaturesDelay(ComputeSystem &cs, ComputeProgram &sfdProgram,
@@ -236,6 +247,7 @@ namespace ogmaneo {
             cl_float biasAlpha,
             cl_float activeRatio,
             cl_float2 initWeightRange,
+            bool halfPrecision,
             std::mt19937 &rng);
 
         /*!
@@ -265,6 +277,13 @@ namespace ogmaneo {
         */
         void inhibit(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, std::mt19937 &rng) override;
 
+        /*!
+        \brief Whether the weights (and their traces) are stored in half precision
+        */
+        bool getHalfPrecision() const {
+            return _halfPrecision;
+        }
+
         /*!
         \brief Get number of visible layers
         */
@@ -319,6 +338,11 @@ namespace ogmaneo {
         */
         void clearMemory(ComputeSystem &cs) override;
 
+        /*!
+        \brief Create an inference session sharing this encoder's weights and biases
+        */
+        std::shared_ptr<SparseFeatures> createSession(ComputeSystem &cs) const override;
+
         //!@{
         /*!
         \brief Serialization
@@ -12,8 +12,9 @@ SparseFeaturesReLU::SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrPro
     int numSamples, int lateralRadius,
     cl_float gamma, cl_float activeRatio, cl_float biasAlpha,
     cl_float2 initWeightRange,
+    bool halfPrecision,
     std::mt19937 &rng)
-    : _lateralRadius(lateralRadius), _gamma(gamma), _activeRatio(activeRatio), _biasAlpha(biasAlpha)
+    : _halfPrecision(halfPrecision), _lateralRadius(lateralRadius), _gamma(gamma), _activeRatio(activeRatio), _biasAlpha(biasAlpha)
 {
     cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
 
@@ -25,13 +26,15 @@ SparseFeaturesReLU::SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrPro
 
     _numSamples = numSamples;
 
+    _sampleHead = 0;
+
     cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
     cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
 
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(sfrProgram.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(sfrProgram.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(sfrProgram.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -61,9 +64,9 @@ SparseFeaturesReLU::SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrPro
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weightsHidden = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weightsHidden = createWeightBuffer(cs, weightsSize, 1, _halfPrecision);
 
-            randomUniform(vl._weightsHidden[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weightsHidden, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         if (vld._predict) {
@@ -73,9 +76,9 @@ SparseFeaturesReLU::SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrPro
 
             cl_int3 weightsSize = { vld._size.x, vld._size.y, numWeights };
 
-            vl._weightsVisible = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weightsVisible = createWeightBuffer(cs, weightsSize, 1, _halfPrecision);
 
-            randomUniform(vl._weightsVisible[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weightsVisible, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
@@ -86,8 +89,8 @@ SparseFeaturesReLU::SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrPro
             cs.getQueue().enqueueFillImage(vl._predictions[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
         }
 
-        vl._samples = createDoubleBuffer3D(cs, { vld._size.x, vld._size.y, numSamples }, CL_R, CL_FLOAT);
-        cs.getQueue().enqueueFillImage(vl._samples[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(numSamples) });
+        vl._samples = cl::Image3D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), vld._size.x, vld._size.y, numSamples + 1);
+        cs.getQueue().enqueueFillImage(vl._samples, zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(numSamples + 1) });
     }
 
     // Hidden state data
@@ -117,6 +120,9 @@ void SparseFeaturesReLU::activate(ComputeSystem &cs, const std::vector<cl::Image
     cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
     cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl_uint>(_hiddenSize.x), static_cast<cl_uint>(_hiddenSize.y), 1 };
 
+    // Oldest sample slice becomes the newest
+    _sampleHead = (_sampleHead + _numSamples) % (_numSamples + 1);
+
     // Start by clearing stimulus summation buffer to biases
     cs.getQueue().enqueueFillImage(_hiddenSummationTemp[_back], cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, zeroOrigin, hiddenRegion);
     //cs.getQueue().enqueueCopyImage(_hiddenBiases[_back], _hiddenSummationTemp[_back], zeroOrigin, zeroOrigin, hiddenRegion);
@@ -142,9 +148,8 @@ void SparseFeaturesReLU::activate(ComputeSystem &cs, const std::vector<cl::Image
             int argIndex = 0;
 
             _addSampleKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _addSampleKernel.setArg(argIndex++, vl._samples[_back]);
-            _addSampleKernel.setArg(argIndex++, vl._samples[_front]);
-            _addSampleKernel.setArg(argIndex++, _numSamples);
+            _addSampleKernel.setArg(argIndex++, vl._samples);
+            _addSampleKernel.setArg(argIndex++, _sampleHead);
 
             cs.getQueue().enqueueNDRangeKernel(_addSampleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
         }
@@ -152,15 +157,19 @@ void SparseFeaturesReLU::activate(ComputeSystem &cs, const std::vector<cl::Image
         {
             int argIndex = 0;
 
-            _stimulusKernel.setArg(argIndex++, vl._samples[_front]);
+            _stimulusKernel.setArg(argIndex++, vl._samples);
             _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
             _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weightsHidden[_back]);
+            _stimulusKernel.setArg(argIndex++, vl._weightsHidden._buffer);
+            _stimulusKernel.setArg(argIndex++, _hiddenSize);
             _stimulusKernel.setArg(argIndex++, vld._size);
             _stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
             _stimulusKernel.setArg(argIndex++, vld._radiusHidden);
             _stimulusKernel.setArg(argIndex++, _numSamples);
+            _stimulusKernel.setArg(argIndex++, _sampleHead);
+            _stimulusKernel.setArg(argIndex++, _numSamples + 1);
             _stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            _stimulusKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
             cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
@@ -193,11 +202,13 @@ void SparseFeaturesReLU::activate(ComputeSystem &cs, const std::vector<cl::Image
             int argIndex = 0;
 
             _predictKernel.setArg(argIndex++, _hiddenStates[_front]);
-            _predictKernel.setArg(argIndex++, vl._weightsVisible[_back]);
+            _predictKernel.setArg(argIndex++, vl._weightsVisible._buffer);
             _predictKernel.setArg(argIndex++, vl._predictions[_front]);
+            _predictKernel.setArg(argIndex++, vld._size);
             _predictKernel.setArg(argIndex++, _hiddenSize);
             _predictKernel.setArg(argIndex++, vl._visibleToHidden);
             _predictKernel.setArg(argIndex++, vld._radiusVisible);
+            _predictKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
             cs.getQueue().enqueueNDRangeKernel(_predictKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
         }
@@ -216,7 +227,6 @@ void SparseFeaturesReLU::stepEnd(ComputeSystem &cs) {
         VisibleLayerDesc &vld = _visibleLayerDescs[vli];
 
         std::swap(vl._derivedInput[_front], vl._derivedInput[_back]);
-        std::swap(vl._samples[_front], vl._samples[_back]);
         std::swap(vl._predictions[_front], vl._predictions[_back]);
     }
 }
@@ -242,13 +252,14 @@ void SparseFeaturesReLU::learn(ComputeSystem &cs, const cl::Image2D &predictions
                 _errorPropKernel.setArg(argIndex++, _hiddenStates[_front]);
                 _errorPropKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
                 _errorPropKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-                _errorPropKernel.setArg(argIndex++, vl._weightsVisible[_back]);
+                _errorPropKernel.setArg(argIndex++, vl._weightsVisible._buffer);
                 _errorPropKernel.setArg(argIndex++, vld._size);
                 _errorPropKernel.setArg(argIndex++, _hiddenSize);
                 _errorPropKernel.setArg(argIndex++, vl._visibleToHidden);
                 _errorPropKernel.setArg(argIndex++, vl._hiddenToVisible);
                 _errorPropKernel.setArg(argIndex++, vld._radiusVisible);
                 _errorPropKernel.setArg(argIndex++, vl._reverseRadiiVisible);
+                _errorPropKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
                 cs.getQueue().enqueueNDRangeKernel(_errorPropKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
 
@@ -260,18 +271,17 @@ void SparseFeaturesReLU::learn(ComputeSystem &cs, const cl::Image2D &predictions
                 int argIndex = 0;
 
                 _learnWeightsVisibleKernel.setArg(argIndex++, _hiddenStates[_front]);
-                _learnWeightsVisibleKernel.setArg(argIndex++, vl._weightsVisible[_back]);
-                _learnWeightsVisibleKernel.setArg(argIndex++, vl._weightsVisible[_front]);
+                _learnWeightsVisibleKernel.setArg(argIndex++, vl._weightsVisible._buffer);
                 _learnWeightsVisibleKernel.setArg(argIndex++, vl._derivedInput[_front]);
                 _learnWeightsVisibleKernel.setArg(argIndex++, vl._predictions[_back]);
+                _learnWeightsVisibleKernel.setArg(argIndex++, vld._size);
                 _learnWeightsVisibleKernel.setArg(argIndex++, _hiddenSize);
                 _learnWeightsVisibleKernel.setArg(argIndex++, vl._visibleToHidden);
                 _learnWeightsVisibleKernel.setArg(argIndex++, vld._radiusVisible);
                 _learnWeightsVisibleKernel.setArg(argIndex++, vld._weightAlphaVisible);
+                _learnWeightsVisibleKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
                 cs.getQueue().enqueueNDRangeKernel(_learnWeightsVisibleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
-
-                std::swap(vl._weightsVisible[_front], vl._weightsVisible[_back]);
             }
         }
     }
@@ -287,20 +297,21 @@ void SparseFeaturesReLU::learn(ComputeSystem &cs, const cl::Image2D &predictions
 
             _learnWeightsHiddenKernel.setArg(argIndex++, _hiddenStates[_back]);
             _learnWeightsHiddenKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-            _learnWeightsHiddenKernel.setArg(argIndex++, vl._samples[_back]);
-            _learnWeightsHiddenKernel.setArg(argIndex++, vl._weightsHidden[_back]);
-            _learnWeightsHiddenKernel.setArg(argIndex++, vl._weightsHidden[_front]);
+            _learnWeightsHiddenKernel.setArg(argIndex++, vl._samples);
+            _learnWeightsHiddenKernel.setArg(argIndex++, vl._weightsHidden._buffer);
+            _learnWeightsHiddenKernel.setArg(argIndex++, _hiddenSize);
             _learnWeightsHiddenKernel.setArg(argIndex++, vld._size);
             _learnWeightsHiddenKernel.setArg(argIndex++, vl._hiddenToVisible);
             _learnWeightsHiddenKernel.setArg(argIndex++, vld._radiusHidden);
             _learnWeightsHiddenKernel.setArg(argIndex++, vld._weightAlphaHidden);
             _learnWeightsHiddenKernel.setArg(argIndex++, _numSamples);
+            _learnWeightsHiddenKernel.setArg(argIndex++, (_sampleHead + 1) % (_numSamples + 1)); // History before this step's sample
+            _learnWeightsHiddenKernel.setArg(argIndex++, _numSamples + 1);
             _learnWeightsHiddenKernel.setArg(argIndex++, _activeRatio);
+            _learnWeightsHiddenKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
             cs.getQueue().enqueueNDRangeKernel(_learnWeightsHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
-
-        std::swap(vl._weightsHidden[_front], vl._weightsHidden[_back]);
     }
 
     {
@@ -343,16 +354,49 @@ void SparseFeaturesReLU::clearMemory(ComputeSystem &cs) {
     // Clear buffers
     cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
 
+    _sampleHead = 0;
+
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
         VisibleLayer &vl = _visibleLayers[vli];
         VisibleLayerDesc &vld = _visibleLayerDescs[vli];
 
         cs.getQueue().enqueueFillImage(vl._derivedInput[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
-        cs.getQueue().enqueueFillImage(vl._samples[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(_numSamples) });
+        cs.getQueue().enqueueFillImage(vl._samples, zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(_numSamples + 1) });
         cs.getQueue().enqueueFillImage(vl._predictions[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), static_cast<cl::size_type>(_numSamples) });
     }
 }
 
+std::shared_ptr<SparseFeatures> SparseFeaturesReLU::createSession(ComputeSystem &cs) const {
+    // Copy shares all image handles, then replace the working memory with private copies
+    std::shared_ptr<SparseFeaturesReLU> session = std::make_shared<SparseFeaturesReLU>(*this);
+
+    session->_hiddenStates = cloneDoubleBuffer2D(cs, _hiddenStates);
+
+    for (int vli = 0; vli < session->_visibleLayers.size(); vli++) {
+        VisibleLayer &vl = session->_visibleLayers[vli];
+
+        vl._derivedInput = cloneDoubleBuffer2D(cs, vl._derivedInput);
+        vl._predictions = cloneDoubleBuffer2D(cs, vl._predictions);
+        vl._samples = cloneImage3D(cs, vl._samples);
+    }
+
+    session->_hiddenSummationTemp = cloneDoubleBuffer2D(cs, _hiddenSummationTemp);
+
+    // Own kernels, arguments are set per object
+    session->_addSampleKernel = cloneKernel(_addSampleKernel);
+    session->_stimulusKernel = cloneKernel(_stimulusKernel);
+    session->_inhibitKernel = cloneKernel(_inhibitKernel);
+    session->_predictKernel = cloneKernel(_predictKernel);
+    session->_inhibitOtherKernel = cloneKernel(_inhibitOtherKernel);
+    session->_errorPropKernel = cloneKernel(_errorPropKernel);
+    session->_learnWeightsHiddenKernel = cloneKernel(_learnWeightsHiddenKernel);
+    session->_learnWeightsVisibleKernel = cloneKernel(_learnWeightsVisibleKernel);
+    session->_learnBiasesKernel = cloneKernel(_learnBiasesKernel);
+    session->_deriveInputsKernel = cloneKernel(_deriveInputsKernel);
+
+    return session;
+}
+
 void SparseFeaturesReLU::VisibleLayerDesc::load(const schemas::VisibleReLULayerDesc* fbVisibleReLULayerDesc, ComputeSystem &cs) {
     _size = cl_int2{ fbVisibleReLULayerDesc->_size().x(), fbVisibleReLULayerDesc->_size().y() };
     _radiusHidden = fbVisibleReLULayerDesc->_radiusHidden();
@@ -372,7 +416,23 @@ schemas::VisibleReLULayerDesc SparseFeaturesReLU::VisibleLayerDesc::save(flatbuf
 void SparseFeaturesReLU::VisibleLayer::load(const schemas::VisibleReLULayer* fbVisibleReLULayer, ComputeSystem &cs) {
     ogmaneo::load(_derivedInput, fbVisibleReLULayer->_derivedInput(), cs);
     ogmaneo::load(_predictions, fbVisibleReLULayer->_predictions(), cs);
-    ogmaneo::load(_samples, fbVisibleReLULayer->_samples(), cs);
+
+    // Ring buffer is stored as the back buffer
+    const schemas::Image3D* fbSamples = fbVisibleReLULayer->_samples()->_back();
+
+    if (fbSamples->depth() == _samples.getImageInfo<CL_IMAGE_DEPTH>())
+        ogmaneo::load(_samples, fbSamples, cs);
+    else {
+        // Older files hold the shifted history without the extra slice, which is the ring at head 0
+        cl::array<cl::size_type, 3> region = { fbSamples->width(), fbSamples->height(), fbSamples->depth() };
+
+        cl::Image3D history(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), region[0], region[1], region[2]);
+
+        ogmaneo::load(history, fbSamples, cs);
+
+        cs.getQueue().enqueueCopyImage(history, _samples, { 0, 0, 0 }, { 0, 0, 0 }, region);
+    }
+
     ogmaneo::load(_weightsHidden, fbVisibleReLULayer->_weightsHidden(), cs);
     ogmaneo::load(_weightsVisible, fbVisibleReLULayer->_weightsVisible(), cs);
     _hiddenToVisible = cl_float2{ fbVisibleReLULayer->_hiddenToVisible()->x(), fbVisibleReLULayer->_hiddenToVisible()->y() };
@@ -387,10 +447,13 @@ flatbuffers::Offset<schemas::VisibleReLULayer> SparseFeaturesReLU::VisibleLayer:
     schemas::int2 reverseRadiiHidden(_reverseRadiiHidden.x, _reverseRadiiHidden.y);
     schemas::int2 reverseRadiiVisible(_reverseRadiiVisible.x, _reverseRadiiVisible.y);
 
+    // Single ring buffer image, stored as both halves of the double buffer (loaded from _back)
+    flatbuffers::Offset<schemas::Image3D> samples = ogmaneo::save(_samples, builder, cs);
+
     return schemas::CreateVisibleReLULayer(builder,
         ogmaneo::save(_derivedInput, builder, cs),
         ogmaneo::save(_predictions, builder, cs),
-        ogmaneo::save(_samples, builder, cs),
+        schemas::CreateDoubleBuffer3D(builder, samples, samples),
         ogmaneo::save(_weightsHidden, builder, cs),
         ogmaneo::save(_weightsVisible, builder, cs),
         &hiddenToVisible, &visibleToHidden, &reverseRadiiHidden, &reverseRadiiVisible);
@@ -408,6 +471,7 @@ void SparseFeaturesReLU::SparseFeaturesReLUDesc::load(const schemas::SparseFeatu
     _activeRatio = fbSparseFeaturesReLUDesc->_activeRatio();
     _biasAlpha = fbSparseFeaturesReLUDesc->_biasAlpha();
     _initWeightRange = cl_float2{ fbSparseFeaturesReLUDesc->_initWeightRange()->x(), fbSparseFeaturesReLUDesc->_initWeightRange()->y() };
+    _halfPrecision = fbSparseFeaturesReLUDesc->_halfPrecision();
 
     for (flatbuffers::uoffset_t i = 0; i < fbSparseFeaturesReLUDesc->_visibleLayerDescs()->Length(); i++) {
         _visibleLayerDescs[i].load(fbSparseFeaturesReLUDesc->_visibleLayerDescs()->Get(i), cs);
@@ -419,12 +483,13 @@ flatbuffers::Offset<schemas::SparseFeaturesReLUDesc> SparseFeaturesReLU::SparseF
     schemas::float2 initWeightRange(_initWeightRange.x, _initWeightRange.y);
 
     std::vector<schemas::VisibleReLULayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     return schemas::CreateSparseFeaturesReLUDesc(builder,
         &hiddenSize, _numSamples, _lateralRadius, _gamma, _activeRatio, _biasAlpha,
-        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs));
+        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs),
+        _halfPrecision);
 }
 
 void SparseFeaturesReLU::load(const schemas::SparseFeatures* fbSparseFeatures, ComputeSystem &cs) {
@@ -443,6 +508,10 @@ void SparseFeaturesReLU::load(const schemas::SparseFeatures* fbSparseFeatures, C
     _gamma = fbSparseFeaturesReLU->_gamma();
     _activeRatio = fbSparseFeaturesReLU->_activeRatio();
     _biasAlpha = fbSparseFeaturesReLU->_biasAlpha();
+    _sampleHead = fbSparseFeaturesReLU->_sampleHead();
+
+    // Storage precision is fixed at construction (from the desc), buffers must match
+    assert(_halfPrecision == fbSparseFeaturesReLU->_halfPrecision());
 
     ogmaneo::load(_hiddenStates, fbSparseFeaturesReLU->_hiddenStates(), cs);
     ogmaneo::load(_hiddenBiases, fbSparseFeaturesReLU->_hiddenBiases(), cs);
@@ -461,21 +530,22 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesReLU::save(flatbuffer
     schemas::int2 hiddenSize(_hiddenSize.x, _hiddenSize.y);
 
     std::vector<schemas::VisibleReLULayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::VisibleReLULayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     flatbuffers::Offset<schemas::SparseFeaturesReLU> sf = schemas::CreateSparseFeaturesReLU(builder,
         ogmaneo::save(_hiddenStates, builder, cs),
         ogmaneo::save(_hiddenBiases, builder, cs),
         &hiddenSize,
-        ogmaneo::save(_hiddenSummationTemp, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTemp, builder, cs),
         _numSamples, _lateralRadius, _gamma, _activeRatio, _biasAlpha,
         builder.CreateVectorOfStructs(visibleLayerDescs),
-        builder.CreateVector(visibleLayers));
+        builder.CreateVector(visibleLayers),
+        _sampleHead, _halfPrecision);
 
     return schemas::CreateSparseFeatures(builder,
         schemas::SparseFeaturesType::SparseFeaturesType_SparseFeaturesReLU, sf.Union());
@@ -94,15 +94,17 @@ namespace ogmaneo {
 
             /*!
             \brief Samples (time sliced derived inputs)
+            Ring buffer of _numSamples + 1 slices (the extra one keeps the previous history for learning),
+            sample s (0 is newest) is in slice (_sampleHead + s) % (_numSamples + 1).
             */
-            DoubleBuffer3D _samples;
+            cl::Image3D _samples;
 
             //!@{
             /*!
             \brief Weights
             */
-            DoubleBuffer3D _weightsHidden;
-            DoubleBuffer3D _weightsVisible;
+            WeightBuffer _weightsHidden;
+            WeightBuffer _weightsVisible;
             //!@}
 
             //!@{
@@ -144,6 +146,7 @@ namespace ogmaneo {
             cl_float _activeRatio;
             cl_float _biasAlpha;
             cl_float2 _initWeightRange;
+            bool _halfPrecision;
             std::mt19937 _rng;
             //!@}
 
@@ -155,6 +158,7 @@ namespace ogmaneo {
                 _numSamples(1), _lateralRadius(6),
                 _gamma(0.92f), _activeRatio(0.02f), _biasAlpha(0.005f),
                 _initWeightRange({ -0.01f, 0.01f }),
+                _halfPrecision(false),
                 _rng()
             {
                 _name = "ReLU";
@@ -176,7 +180,7 @@ namespace ogmaneo {
             \brief Factory
             */
             std::shared_ptr<SparseFeatures> sparseFeaturesFactory() override {
-                return std::make_shared<SparseFeaturesReLU>(*_cs, *_sfrProgram, _visibleLayerDescs, _hiddenSize, _numSamples, _lateralRadius, _gamma, _activeRatio, _biasAlpha, _initWeightRange, _rng);
+                return std::make_shared<SparseFeaturesReLU>(*_cs, *_sfrProgram, _visibleLayerDescs, _hiddenSize, _numSamples, _lateralRadius, _gamma, _activeRatio, _biasAlpha, _initWeightRange, _halfPrecision, _rng);
             }
 
             //!@{
@@ -231,6 +235,16 @@ namespace ogmaneo {
         cl::Kernel _deriveInputsKernel;
         //!@}
 
+        /*!
+        \brief Slice of the newest sample in the sample ring buffers
+        */
+        int _sampleHead;
+
+        /*!
+        \brief Whether the weights are stored in half precision (accumulation is still fp32)
+        */
+        bool _halfPrecision;
+
     public:
         //!@{
         /*!
@@ -246,13 +260,16 @@ namespace ogmaneo {
         /*!
         \brief Default constructor
         */
-        SparseFeaturesReLU() {};
+        SparseFeaturesReLU()
+            : _sampleHead(0), _halfPrecision(false)
+        {}
 
         /*!
         \brief Create a comparison sparse coder with random initialization
         Requires the compute system, program with the NeoRL kernels, and initialization information.
         \param visibleLayerDescs descriptors for each input layer.
         \param hiddenSize hidden layer (SDR) size (2D).
+        \param halfPrecision store weights as fp16.
         \param rng a random number generator.
         */
         SparseFeaturesReLU(ComputeSystem &cs, ComputeProgram &sfrProgram,
@@ -260,6 +277,7 @@ namespace ogmaneo {
             int numSamples, int lateralRadius,
             cl_float gamma, cl_float activeRatio, cl_float biasAlpha,
             cl_float2 initWeightRange,
+            bool halfPrecision,
             std::mt19937 &rng);
 
         /*!
@@ -289,6 +307,13 @@ namespace ogmaneo {
         */
         void inhibit(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, std::mt19937 &rng) override;
 
+        /*!
+        \brief Whether the weights are stored in half precision
+        */
+        bool getHalfPrecision() const {
+            return _halfPrecision;
+        }
+
         /*!
         \brief Get number of visible layers
         */
@@ -343,6 +368,11 @@ namespace ogmaneo {
         */
         void clearMemory(ComputeSystem &cs) override;
 
+        /*!
+        \brief Create an inference session sharing this encoder's weights and biases
+        */
+        std::shared_ptr<SparseFeatures> createSession(ComputeSystem &cs) const override;
+
         //!@{
         /*!
         \brief Serialization
@@ -14,8 +14,10 @@ SparseFeaturesSTDP::SparseFeaturesSTDP(ComputeSystem &cs, ComputeProgram &sfhPro
     const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize,
     cl_int inhibitionRadius, cl_float biasAlpha,
     cl_float activeRatio, cl_float gamma, cl_float2 initWeightRange,
+    cl_int inhibitionStride,
+    bool halfPrecision,
     std::mt19937 &rng)
-    : _hiddenSize(hiddenSize), _inhibitionRadius(inhibitionRadius), _activeRatio(activeRatio), _biasAlpha(biasAlpha), _gamma(gamma)
+    : _hiddenSize(hiddenSize), _inhibitionRadius(inhibitionRadius), _inhibitionStride(clampInhibitionStride(inhibitionStride, inhibitionRadius)), _halfPrecision(halfPrecision), _activeRatio(activeRatio), _biasAlpha(biasAlpha), _gamma(gamma)
 {
     cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
 
@@ -29,7 +31,7 @@ SparseFeaturesSTDP::SparseFeaturesSTDP(ComputeSystem &cs, ComputeProgram &sfhPro
     _visibleLayers.resize(_visibleLayerDescs.size());
 
     cl::Kernel randomUniform2DKernel = cl::Kernel(sfhProgram.getProgram(), "randomUniform2D");
-    cl::Kernel randomUniform3DKernel = cl::Kernel(sfhProgram.getProgram(), "randomUniform3D");
+    cl::Kernel randomUniformWeightsKernel = cl::Kernel(sfhProgram.getProgram(), "randomUniformWeights");
 
     // Create layers
     for (int vli = 0; vli < _visibleLayers.size(); vli++) {
@@ -55,9 +57,9 @@ SparseFeaturesSTDP::SparseFeaturesSTDP(ComputeSystem &cs, ComputeProgram &sfhPro
 
             cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
 
-            vl._weights = createDoubleBuffer3D(cs, weightsSize, CL_R, CL_FLOAT);
+            vl._weights = createWeightBuffer(cs, weightsSize, 1, _halfPrecision);
 
-            randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+            randomUniform(vl._weights, cs, randomUniformWeightsKernel, initWeightRange, rng);
         }
 
         vl._derivedInput = createDoubleBuffer2D(cs, vld._size, CL_RG, CL_FLOAT);
@@ -82,6 +84,7 @@ SparseFeaturesSTDP::SparseFeaturesSTDP(ComputeSystem &cs, ComputeProgram &sfhPro
 
     // Create kernels
     _stimulusKernel = cl::Kernel(sfhProgram.getProgram(), "sfsStimulus");
+    _stimulusTiledKernel = cl::Kernel(sfhProgram.getProgram(), "sfsStimulusTiled");
     _activateKernel = cl::Kernel(sfhProgram.getProgram(), "sfsActivate");
     _inhibitKernel = cl::Kernel(sfhProgram.getProgram(), "sfsInhibit");
     _inhibitOtherKernel = cl::Kernel(sfhProgram.getProgram(), "sfsInhibitOther");
@@ -114,18 +117,27 @@ void SparseFeaturesSTDP::activate(ComputeSystem &cs, const std::vector<cl::Image
         }
 
         {
-            int argIndex = 0;
+            LocalTile tile = getLocalTile(cs, _stimulusTiledKernel, vl._hiddenToVisible, vld._radius);
+
+            cl::Kernel &stimulusKernel = tile._enabled ? _stimulusTiledKernel : _stimulusKernel;
 
-            _stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-            _stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-            _stimulusKernel.setArg(argIndex++, vl._weights[_back]);
-            _stimulusKernel.setArg(argIndex++, vld._size);
-            _stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
-            _stimulusKernel.setArg(argIndex++, vld._radius);
-            _stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            int argIndex = 0;
 
-            cs.getQueue().enqueueNDRangeKernel(_stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+            stimulusKernel.setArg(argIndex++, vl._derivedInput[_front]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+            stimulusKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+            stimulusKernel.setArg(argIndex++, vl._weights._buffer);
+            stimulusKernel.setArg(argIndex++, _hiddenSize);
+            stimulusKernel.setArg(argIndex++, vld._size);
+            stimulusKernel.setArg(argIndex++, vl._hiddenToVisible);
+            stimulusKernel.setArg(argIndex++, vld._radius);
+            stimulusKernel.setArg(argIndex++, vld._ignoreMiddle);
+            stimulusKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
+
+            if (tile._enabled)
+                enqueueTiled(cs, stimulusKernel, argIndex, tile, _hiddenSize);
+            else
+                cs.getQueue().enqueueNDRangeKernel(stimulusKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
 
         // Swap buffers
@@ -159,6 +171,7 @@ void SparseFeaturesSTDP::activate(ComputeSystem &cs, const std::vector<cl::Image
         _inhibitKernel.setArg(argIndex++, _hiddenStates[_front]);
         _inhibitKernel.setArg(argIndex++, _hiddenSize);
         _inhibitKernel.setArg(argIndex++, _inhibitionRadius);
+        _inhibitKernel.setArg(argIndex++, _inhibitionStride);
         _inhibitKernel.setArg(argIndex++, _activeRatio);
         _inhibitKernel.setArg(argIndex++, _gamma);
 
@@ -196,17 +209,16 @@ void SparseFeaturesSTDP::learn(ComputeSystem &cs, const cl::Image2D &predictions
             _learnWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
             _learnWeightsKernel.setArg(argIndex++, vl._derivedInput[_front]);
             _learnWeightsKernel.setArg(argIndex++, vl._derivedInput[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-            _learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
+            _learnWeightsKernel.setArg(argIndex++, vl._weights._buffer);
+            _learnWeightsKernel.setArg(argIndex++, _hiddenSize);
             _learnWeightsKernel.setArg(argIndex++, vld._size);
             _learnWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
             _learnWeightsKernel.setArg(argIndex++, vld._radius);
             _learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
+            _learnWeightsKernel.setArg(argIndex++, static_cast<cl_uchar>(_halfPrecision));
 
             cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
         }
-
-        std::swap(vl._weights[_front], vl._weights[_back]);
     }
 
     // Bias update
@@ -227,18 +239,30 @@ void SparseFeaturesSTDP::learn(ComputeSystem &cs, const cl::Image2D &predictions
 }
 
 void SparseFeaturesSTDP::inhibit(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, std::mt19937 &rng) {
-    // Inhibit
-    {
-        int argIndex = 0;
+    inhibitOther(cs, activations, states, _inhibitionStride);
+}
 
-        _inhibitOtherKernel.setArg(argIndex++, activations);
-        _inhibitOtherKernel.setArg(argIndex++, states);
-        _inhibitOtherKernel.setArg(argIndex++, _hiddenSize);
-        _inhibitOtherKernel.setArg(argIndex++, _inhibitionRadius);
-        _inhibitOtherKernel.setArg(argIndex++, _activeRatio);
+void SparseFeaturesSTDP::inhibitOther(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, cl_int stride) {
+    int argIndex = 0;
 
-        cs.getQueue().enqueueNDRangeKernel(_inhibitOtherKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-    }
+    _inhibitOtherKernel.setArg(argIndex++, activations);
+    _inhibitOtherKernel.setArg(argIndex++, states);
+    _inhibitOtherKernel.setArg(argIndex++, _hiddenSize);
+    _inhibitOtherKernel.setArg(argIndex++, _inhibitionRadius);
+    _inhibitOtherKernel.setArg(argIndex++, stride);
+    _inhibitOtherKernel.setArg(argIndex++, _activeRatio);
+
+    cs.getQueue().enqueueNDRangeKernel(_inhibitOtherKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+}
+
+float SparseFeaturesSTDP::getInhibitionError(ComputeSystem &cs, const cl::Image2D &activations) {
+    cl::Image2D exactStates = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _hiddenSize.x, _hiddenSize.y);
+    cl::Image2D stridedStates = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), _hiddenSize.x, _hiddenSize.y);
+
+    inhibitOther(cs, activations, exactStates, 1);
+    inhibitOther(cs, activations, stridedStates, _inhibitionStride);
+
+    return getStateDisagreement(cs, exactStates, stridedStates, _hiddenSize);
 }
 
 void SparseFeaturesSTDP::clearMemory(ComputeSystem &cs) {
@@ -259,6 +283,34 @@ void SparseFeaturesSTDP::clearMemory(ComputeSystem &cs) {
     }
 }
 
+std::shared_ptr<SparseFeatures> SparseFeaturesSTDP::createSession(ComputeSystem &cs) const {
+    // Copy shares all image handles, then replace the working memory with private copies
+    std::shared_ptr<SparseFeaturesSTDP> session = std::make_shared<SparseFeaturesSTDP>(*this);
+
+    session->_hiddenActivations = cloneDoubleBuffer2D(cs, _hiddenActivations);
+    session->_hiddenStates = cloneDoubleBuffer2D(cs, _hiddenStates);
+
+    for (int vli = 0; vli < session->_visibleLayers.size(); vli++) {
+        VisibleLayer &vl = session->_visibleLayers[vli];
+
+        vl._derivedInput = cloneDoubleBuffer2D(cs, vl._derivedInput);
+    }
+
+    session->_hiddenSummationTemp = cloneDoubleBuffer2D(cs, _hiddenSummationTemp);
+
+    // Own kernels, arguments are set per object
+    session->_stimulusKernel = cloneKernel(_stimulusKernel);
+    session->_stimulusTiledKernel = cloneKernel(_stimulusTiledKernel);
+    session->_activateKernel = cloneKernel(_activateKernel);
+    session->_inhibitKernel = cloneKernel(_inhibitKernel);
+    session->_inhibitOtherKernel = cloneKernel(_inhibitOtherKernel);
+    session->_learnWeightsKernel = cloneKernel(_learnWeightsKernel);
+    session->_learnBiasesKernel = cloneKernel(_learnBiasesKernel);
+    session->_deriveInputsKernel = cloneKernel(_deriveInputsKernel);
+
+    return session;
+}
+
 void SparseFeaturesSTDP::VisibleLayerDesc::load(const schemas::VisibleSTDPLayerDesc* fbVisibleSTDPLayerDesc, ComputeSystem &cs) {
     _size = cl_int2{ fbVisibleSTDPLayerDesc->_size().x(), fbVisibleSTDPLayerDesc->_size().y() };
     _radius = fbVisibleSTDPLayerDesc->_radius();
@@ -301,6 +353,8 @@ void SparseFeaturesSTDP::SparseFeaturesSTDPDesc::load(const schemas::SparseFeatu
     _activeRatio = fbSparseFeaturesSTDPDesc->_activeRatio();
     _gamma = fbSparseFeaturesSTDPDesc->_gamma();
     _initWeightRange = cl_float2{ fbSparseFeaturesSTDPDesc->_initWeightRange()->x(), fbSparseFeaturesSTDPDesc->_initWeightRange()->y() };
+    _inhibitionStride = fbSparseFeaturesSTDPDesc->_inhibitionStride();
+    _halfPrecision = fbSparseFeaturesSTDPDesc->_halfPrecision();
 
     for (flatbuffers::uoffset_t i = 0; i < fbSparseFeaturesSTDPDesc->_visibleLayerDescs()->Length(); i++) {
         _visibleLayerDescs[i].load(fbSparseFeaturesSTDPDesc->_visibleLayerDescs()->Get(i), cs);
@@ -312,12 +366,13 @@ flatbuffers::Offset<schemas::SparseFeaturesSTDPDesc> SparseFeaturesSTDP::SparseF
     schemas::float2 initWeightRange(_initWeightRange.x, _initWeightRange.y);
 
     std::vector<schemas::VisibleSTDPLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     return schemas::CreateSparseFeaturesSTDPDesc(builder,
         &hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio, _gamma, 
-        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs));
+        &initWeightRange, builder.CreateVectorOfStructs(visibleLayerDescs), _inhibitionStride,
+        _halfPrecision);
 }
 
 void SparseFeaturesSTDP::load(const schemas::SparseFeatures* fbSparseFeatures, ComputeSystem &cs) {
@@ -333,6 +388,10 @@ void SparseFeaturesSTDP::load(const schemas::SparseFeatures* fbSparseFeatures, C
     _hiddenSize = cl_int2{ fbSparseFeaturesSTDP->_hiddenSize()->x(), fbSparseFeaturesSTDP->_hiddenSize()->y() };
 
     _inhibitionRadius = fbSparseFeaturesSTDP->_inhibitionRadius();
+    _inhibitionStride = clampInhibitionStride(fbSparseFeaturesSTDP->_inhibitionStride(), _inhibitionRadius);
+
+    // Storage precision is fixed at construction (from the desc), buffers must match
+    assert(_halfPrecision == fbSparseFeaturesSTDP->_halfPrecision());
 
     ogmaneo::load(_hiddenActivations, fbSparseFeaturesSTDP->_hiddenActivations(), cs);
     ogmaneo::load(_hiddenStates, fbSparseFeaturesSTDP->_hiddenStates(), cs);
@@ -352,11 +411,11 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesSTDP::save(flatbuffer
     schemas::int2 hiddenSize(_hiddenSize.x, _hiddenSize.y);
 
     std::vector<schemas::VisibleSTDPLayerDesc> visibleLayerDescs;
-    for (VisibleLayerDesc layerDesc : _visibleLayerDescs)
+    for (VisibleLayerDesc &layerDesc : _visibleLayerDescs)
         visibleLayerDescs.push_back(layerDesc.save(builder, cs));
 
     std::vector<flatbuffers::Offset<schemas::VisibleSTDPLayer>> visibleLayers;
-    for (VisibleLayer layer : _visibleLayers)
+    for (VisibleLayer &layer : _visibleLayers)
         visibleLayers.push_back(layer.save(builder, cs));
 
     flatbuffers::Offset<schemas::SparseFeaturesSTDP> sf = schemas::CreateSparseFeaturesSTDP(builder,
@@ -364,10 +423,11 @@ flatbuffers::Offset<schemas::SparseFeatures> SparseFeaturesSTDP::save(flatbuffer
         ogmaneo::save(_hiddenStates, builder, cs),
         ogmaneo::save(_hiddenBiases, builder, cs),
         &hiddenSize, _inhibitionRadius,
-        ogmaneo::save(_hiddenSummationTemp, builder, cs),
+        ogmaneo::saveScratch(_hiddenSummationTemp, builder, cs),
         _biasAlpha, _activeRatio, _gamma,
         builder.CreateVectorOfStructs(visibleLayerDescs),
-        builder.CreateVector(visibleLayers));
+        builder.CreateVector(visibleLayers),
+        _inhibitionStride, _halfPrecision);
 
     return schemas::CreateSparseFeatures(builder,
         schemas::SparseFeaturesType::SparseFeaturesType_SparseFeaturesSTDP, sf.Union());
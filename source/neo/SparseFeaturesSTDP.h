@@ -77,7 +77,7 @@ namespace ogmaneo {
             /*!
             \brief Weights
             */
-            DoubleBuffer3D _weights; // Encoding weights (creates spatio-temporal sparse code)
+            WeightBuffer _weights; // Encoding weights (creates spatio-temporal sparse code)
 
             //!@{
             /*!
@@ -116,6 +116,8 @@ namespace ogmaneo {
             cl_float _activeRatio;
             cl_float _gamma;
             cl_float2 _initWeightRange;
+            cl_int _inhibitionStride;
+            bool _halfPrecision;
             std::mt19937 _rng;
             //!@}
 
@@ -127,6 +129,8 @@ namespace ogmaneo {
                 _inhibitionRadius(6),
                 _biasAlpha(0.001f), _activeRatio(0.01f), _gamma(0.96f),
                 _initWeightRange({ 0.0f, 0.05f }),
+                _inhibitionStride(1),
+                _halfPrecision(false),
                 _rng()
             {
                 _name = "STDP";
@@ -148,7 +152,7 @@ namespace ogmaneo {
             \brief Factory
             */
             std::shared_ptr<SparseFeatures> sparseFeaturesFactory() override {
-                return std::make_shared<SparseFeaturesSTDP>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio, _gamma, _initWeightRange, _rng);
+                return std::make_shared<SparseFeaturesSTDP>(*_cs, *_sfcProgram, _visibleLayerDescs, _hiddenSize, _inhibitionRadius, _biasAlpha, _activeRatio, _gamma, _initWeightRange, _inhibitionStride, _halfPrecision, _rng);
             }
 
             //!@{
@@ -180,11 +184,21 @@ namespace ogmaneo {
         */
         cl_int _inhibitionRadius;
 
+        /*!
+        \brief Inhibition neighbourhood sampling stride, 1 is exact
+        */
+        cl_int _inhibitionStride;
+
         /*!
         \brief Hidden summation temporary buffer
         */
         DoubleBuffer2D _hiddenSummationTemp;
 
+        /*!
+        \brief Whether the weights are stored in half precision (accumulation is still fp32)
+        */
+        bool _halfPrecision;
+
         //!@{
         /*!
         \brief Layers and descs
@@ -198,6 +212,7 @@ namespace ogmaneo {
         \brief Kernels
         */
         cl::Kernel _stimulusKernel;
+        cl::Kernel _stimulusTiledKernel;
         cl::Kernel _activateKernel;
         cl::Kernel _inhibitKernel;
         cl::Kernel _inhibitOtherKernel;
@@ -206,6 +221,11 @@ namespace ogmaneo {
         cl::Kernel _deriveInputsKernel;
         //!@}
 
+        /*!
+        \brief Inhibit with a given neighbourhood stride
+        */
+        void inhibitOther(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, cl_int stride);
+
     public:
         //!@{
         /*!
@@ -219,13 +239,17 @@ namespace ogmaneo {
         /*!
         \brief Default constructor
         */
-        SparseFeaturesSTDP() {};
+        SparseFeaturesSTDP()
+            : _halfPrecision(false)
+        {}
 
         /*!
         \brief Create a comparison sparse coder with random initialization
         Requires the compute system, program with the NeoRL kernels, and initialization information.
         \param visibleLayerDescs descriptors for each input layer.
         \param hiddenSize hidden layer (SDR) size (2D).
+        \param inhibitionStride inhibition compares against every stride-th neighbour per axis (1 is exact, cost falls with stride^2, clamped to the radius).
+        \param halfPrecision store weights as fp16.
         \param rng a random number generator.
         */
         SparseFeaturesSTDP(ComputeSystem &cs, ComputeProgram &sfhProgram,
@@ -235,6 +259,8 @@ namespace ogmaneo {
             cl_float activeRatio,
             cl_float gamma,
             cl_float2 initWeightRange,
+            cl_int inhibitionStride,
+            bool halfPrecision,
             std::mt19937 &rng);
 
         /*!
@@ -264,6 +290,26 @@ namespace ogmaneo {
         */
         void inhibit(ComputeSystem &cs, const cl::Image2D &activations, cl::Image2D &states, std::mt19937 &rng) override;
 
+        /*!
+        \brief Error rate of the strided inhibition
+        Fraction of units whose state differs from the exact rule (stride 1) for the given activations. Blocking.
+        */
+        float getInhibitionError(ComputeSystem &cs, const cl::Image2D &activations);
+
+        /*!
+        \brief Get inhibition stride
+        */
+        cl_int getInhibitionStride() const {
+            return _inhibitionStride;
+        }
+
+        /*!
+        \brief Whether the weights are stored in half precision
+        */
+        bool getHalfPrecision() const {
+            return _halfPrecision;
+        }
+
         /*!
         \brief Get number of visible layers
         */
@@ -318,6 +364,11 @@ namespace ogmaneo {
         */
         void clearMemory(ComputeSystem &cs) override;
 
+        /*!
+        \brief Create an inference session sharing this encoder's weights and biases
+        */
+        std::shared_ptr<SparseFeatures> createSession(ComputeSystem &cs) const override;
+
         //!@{
         /*!
         \brief Serialization
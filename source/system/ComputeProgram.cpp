@@ -11,6 +11,14 @@
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <functional>
 
 #include "kernels/neoKernelsHierarchy.h"
 #include "kernels/neoKernelsPredictor.h"
@@ -116,15 +124,204 @@ bool ComputeProgram::loadFromFile(const std::string &name, ComputeSystem &cs) {
     return loadFromString(kernel, cs);
 }
 
-bool ComputeProgram::loadFromString(const std::string& kernel, ComputeSystem &cs) {
+bool ComputeProgram::loadFromString(const std::string& kernel, ComputeSystem &cs, const std::string &options) {
+    std::shared_ptr<ProgramCache> cache = cs.getProgramCache();
+
+    std::string buildOptions = options;
+
+    if (cs.getWeightLayout() == ComputeSystem::_unitMajor)
+        buildOptions += " -D WEIGHTS_UNIT_MAJOR";
+
+    unsigned long long key = 0;
+
+    if (cache != nullptr) {
+        key = ProgramCache::computeKey(kernel, buildOptions, cs);
+
+        if (cache->load(key, buildOptions, cs, _program))
+            return true;
+    }
+
     _program = cl::Program(cs.getContext(), kernel);
 
-    if (_program.build(std::vector<cl::Device>(1, cs.getDevice())) != CL_SUCCESS) {
+    if (_program.build(std::vector<cl::Device>(1, cs.getDevice()), buildOptions.c_str()) != CL_SUCCESS) {
 #ifdef SYS_DEBUG
         std::cerr << "Error building: " << _program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(cs.getDevice()) << std::endl;
 #endif
         return false;
     }
 
+    if (cache != nullptr)
+        cache->store(key, cs, _program);
+
+    return true;
+}
+
+namespace {
+    const char programCacheMagic[8] = { 'O', 'G', 'M', 'A', 'B', 'I', 'N', '1' };
+
+    // 64 bit FNV-1a
+    unsigned long long hashString(const std::string &s, unsigned long long hash = 14695981039346656037ULL) {
+        for (int i = 0; i < s.size(); i++) {
+            hash ^= static_cast<unsigned char>(s[i]);
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+}
+
+unsigned long long ProgramCache::computeKey(const std::string &source, const std::string &options, ComputeSystem &cs) {
+    unsigned long long hash = hashString(source);
+
+    // Separators keep adjacent fields from aliasing
+    hash = hashString("\n" + options, hash);
+    hash = hashString("\n" + cs.getPlatform().getInfo<CL_PLATFORM_VERSION>(), hash);
+    hash = hashString("\n" + cs.getDevice().getInfo<CL_DEVICE_NAME>(), hash);
+    hash = hashString("\n" + cs.getDevice().getInfo<CL_DEVICE_VERSION>(), hash);
+    hash = hashString("\n" + cs.getDevice().getInfo<CL_DRIVER_VERSION>(), hash);
+
+    return hash;
+}
+
+std::string ProgramCache::getFileName(unsigned long long hash) const {
+    std::ostringstream os;
+
+    os << _directory;
+
+    if (!_directory.empty() && _directory.back() != '/' && _directory.back() != '\\')
+        os << '/';
+
+    os << "ogmaneo_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+
+    return os.str();
+}
+
+bool ProgramCache::load(unsigned long long key, const std::string &options, ComputeSystem &cs, cl::Program &program) {
+    std::ifstream fromFile(getFileName(key), std::ios::binary);
+
+    if (!fromFile.is_open()) {
+        _misses++;
+
+        return false;
+    }
+
+    char magic[sizeof(programCacheMagic)];
+    unsigned long long storedKey = 0;
+    unsigned long long size = 0;
+
+    fromFile.read(magic, sizeof(magic));
+    fromFile.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+    fromFile.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    if (!fromFile.good() || !std::equal(magic, magic + sizeof(magic), programCacheMagic) || storedKey != key) {
+        _misses++;
+
+        return false;
+    }
+
+    // A truncated or corrupt file must not drive the allocation
+    std::streamoff headerEnd = fromFile.tellg();
+
+    fromFile.seekg(0, std::ios::end);
+
+    std::streamoff remaining = fromFile.tellg() - headerEnd;
+
+    fromFile.seekg(headerEnd);
+
+    if (headerEnd < 0 || remaining < 0 || size == 0 || size > static_cast<unsigned long long>(remaining)) {
+        _misses++;
+
+        return false;
+    }
+
+    cl::Program::Binaries binaries(1, std::vector<unsigned char>(size));
+
+    fromFile.read(reinterpret_cast<char*>(binaries[0].data()), size);
+
+    if (!fromFile.good()) {
+        _misses++;
+
+        return false;
+    }
+
+    std::vector<cl::Device> devices(1, cs.getDevice());
+    std::vector<cl_int> binaryStatus;
+    cl_int err = CL_SUCCESS;
+
+    cl::Program binaryProgram(cs.getContext(), devices, binaries, &binaryStatus, &err);
+
+    if (err != CL_SUCCESS || binaryStatus.empty() || binaryStatus[0] != CL_SUCCESS
+        || binaryProgram.build(devices, options.c_str()) != CL_SUCCESS)
+    {
+#ifdef SYS_DEBUG
+        std::cerr << "Discarding stale program binary " << getFileName(key) << std::endl;
+#endif
+        _misses++;
+
+        return false;
+    }
+
+    program = binaryProgram;
+
+    _hits++;
+
+    return true;
+}
+
+bool ProgramCache::store(unsigned long long key, ComputeSystem &cs, cl::Program &program) {
+    // Single device programs, so only one binary
+    cl::Program::Binaries binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+
+    if (binaries.empty() || binaries[0].empty())
+        return false;
+
+    std::string fileName = getFileName(key);
+
+    // Write to a temporary first so concurrent processes never see a partial file.
+    // The suffix is random (mixed with the time and thread), a program address alone repeats across processes
+    std::random_device device;
+
+    unsigned long long suffix = (static_cast<unsigned long long>(device()) << 32) ^ device()
+        ^ static_cast<unsigned long long>(std::chrono::high_resolution_clock::now().time_since_epoch().count())
+        ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    std::ostringstream tempName;
+    tempName << fileName << "." << std::hex << suffix << ".tmp";
+
+    {
+        std::ofstream toFile(tempName.str(), std::ios::binary);
+
+        if (!toFile.is_open()) {
+#ifdef SYS_DEBUG
+            std::cerr << "Could not write program cache file " << tempName.str() << "!" << std::endl;
+#endif
+            return false;
+        }
+
+        unsigned long long size = binaries[0].size();
+
+        toFile.write(programCacheMagic, sizeof(programCacheMagic));
+        toFile.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        toFile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        toFile.write(reinterpret_cast<const char*>(binaries[0].data()), size);
+
+        if (!toFile.good()) {
+            toFile.close();
+
+            std::remove(tempName.str().c_str());
+
+            return false;
+        }
+    }
+
+    // rename does not replace an existing file on all platforms
+    std::remove(fileName.c_str());
+
+    if (std::rename(tempName.str().c_str(), fileName.c_str()) != 0) {
+        std::remove(tempName.str().c_str());
+
+        return false;
+    }
+
     return true;
 }
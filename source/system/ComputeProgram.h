@@ -11,6 +11,7 @@
 #include <system/ComputeSystem.h>
 
 #include <assert.h>
+#include <atomic>
 
 namespace ogmaneo {
     /*!
@@ -20,6 +21,72 @@ namespace ogmaneo {
         _stdp, _delay, _chunk, _ReLU
     };
 
+    /*!
+    \brief Program binary cache.
+    Stores built program binaries on disk, keyed by a hash of the source, build options, device and driver version.
+    Attach to a ComputeSystem with ComputeSystem::setProgramCache.
+    */
+    class ProgramCache {
+    private:
+        /*!
+        \brief Directory binaries are stored in (must exist)
+        */
+        std::string _directory;
+
+        //!@{
+        /*!
+        \brief Statistics
+        */
+        std::atomic<int> _hits;
+        std::atomic<int> _misses;
+        //!@}
+
+        /*!
+        \brief Cache file name for a key hash
+        */
+        std::string getFileName(unsigned long long hash) const;
+
+    public:
+        ProgramCache(const std::string &directory)
+            : _directory(directory), _hits(0), _misses(0)
+        {}
+
+        /*!
+        \brief Hash of everything a program binary depends on
+        */
+        static unsigned long long computeKey(const std::string &source, const std::string &options, ComputeSystem &cs);
+
+        /*!
+        \brief Try to create and build a program from a cached binary, counts a hit or a miss
+        */
+        bool load(unsigned long long key, const std::string &options, ComputeSystem &cs, cl::Program &program);
+
+        /*!
+        \brief Store the binary of a built program
+        */
+        bool store(unsigned long long key, ComputeSystem &cs, cl::Program &program);
+
+        //!@{
+        /*!
+        \brief Get cache statistics
+        */
+        int getNumHits() const {
+            return _hits;
+        }
+
+        int getNumMisses() const {
+            return _misses;
+        }
+        //!@}
+
+        /*!
+        \brief Get cache directory
+        */
+        const std::string &getDirectory() const {
+            return _directory;
+        }
+    };
+
     /*!
     \brief Compute program.
     Holds OpenCL compute program with their associated kernels.
@@ -33,8 +100,9 @@ namespace ogmaneo {
 
         /*!
         \brief Load kernel code from a string
+        Uses the ComputeSystem's ProgramCache if one is set, falling back to a source build.
         */
-        bool loadFromString(const std::string& kernel, ComputeSystem &cs);
+        bool loadFromString(const std::string& kernel, ComputeSystem &cs, const std::string &options = "");
 
     public:
         /*!
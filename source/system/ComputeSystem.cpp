@@ -13,6 +13,19 @@
 using namespace ogmaneo;
 
 bool ComputeSystem::create(DeviceType type, int platformIndex, int deviceIndex, bool createFromGLContext) {
+    _deviceType = type;
+
+    // Native layers only need the host workers
+    if (type == _native) {
+        _pool.create();
+
+#ifdef SYS_DEBUG
+        std::cout << "Using native host engine with " << _pool.getNumWorkers() << " worker thread(s)." << std::endl << std::endl;
+#endif
+
+        return true;
+    }
+
     int index;
     std::vector<cl::Platform> allPlatforms;
     cl::Platform::get(&allPlatforms);
@@ -56,6 +69,7 @@ bool ComputeSystem::create(DeviceType type, int platformIndex, int deviceIndex,
         _platform.getDevices(CL_DEVICE_TYPE_GPU, &allDevices);
         break;
     case _all:
+    default:
         _platform.getDevices(CL_DEVICE_TYPE_ALL, &allDevices);
         break;
     }
@@ -151,5 +165,68 @@ bool ComputeSystem::create(DeviceType type, int platformIndex, int deviceIndex,
 
     _queue = cl::CommandQueue(_context, _device);
 
+    // Tiled kernels only pay off with dedicated local memory (emulated local memory on CPUs just adds barriers)
+    _localMemSize = _device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+
+    size_t maxWorkGroupSize = _device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+
+    if (_device.getInfo<CL_DEVICE_LOCAL_MEM_TYPE>() == CL_LOCAL && maxWorkGroupSize >= 64)
+        _tileSize = maxWorkGroupSize >= 256 ? cl_int2{ 16, 16 } : cl_int2{ 8, 8 };
+    else
+        _tileSize = cl_int2{ 0, 0 };
+
+#ifdef SYS_DEBUG
+    std::cout << "Tile size: " << _tileSize.x << "x" << _tileSize.y << " (" << _localMemSize << " bytes local memory)." << std::endl;
+#endif
+
+    _pool.create();
+
+#ifdef SYS_DEBUG
+    std::cout << "Using " << _pool.getNumWorkers() << " host worker thread(s)." << std::endl << std::endl;
+#endif
+
     return true;
 }
+
+
+void ComputeSystem::createAuxQueues(int numQueues) {
+    _auxQueues.clear();
+
+    for (int i = 0; i < numQueues; i++)
+        _auxQueues.push_back(cl::CommandQueue(_context, _device));
+
+    _activeQueue = -1;
+}
+
+void ComputeSystem::fork() {
+    if (_auxQueues.empty())
+        return;
+
+    std::vector<cl::Event> events(1);
+
+    _queue.enqueueMarkerWithWaitList(nullptr, &events[0]);
+    _queue.flush();
+
+    for (int i = 0; i < _auxQueues.size(); i++)
+        _auxQueues[i].enqueueBarrierWithWaitList(&events);
+}
+
+void ComputeSystem::selectQueue(int workIndex) {
+    _activeQueue = _auxQueues.empty() ? -1 : workIndex % static_cast<int>(_auxQueues.size());
+}
+
+void ComputeSystem::join() {
+    _activeQueue = -1;
+
+    if (_auxQueues.empty())
+        return;
+
+    std::vector<cl::Event> events(_auxQueues.size());
+
+    for (int i = 0; i < _auxQueues.size(); i++) {
+        _auxQueues[i].enqueueMarkerWithWaitList(nullptr, &events[i]);
+        _auxQueues[i].flush();
+    }
+
+    _queue.enqueueBarrierWithWaitList(&events);
+}
\ No newline at end of file
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <system/Uncopyable.h>
+#include <system/ThreadPool.h>
 
 //#define CL_HPP_MINIMUM_OPENCL_VERSION 200
 //#define CL_HPP_TARGET_OPENCL_VERSION 200
@@ -25,21 +26,50 @@
 
 #define SYS_ALLOW_CL_GL_CONTEXT 0
 
+#include <memory>
+
 namespace ogmaneo {
+    class ProgramCache;
+
     /*!
     \brief Compute system
-    Holds OpenCL platform, device, context, and command queue
+    Holds OpenCL platform, device, context, and command queue, as well as a pool of host worker threads
     */
     class ComputeSystem : private Uncopyable {
     public:
         /*!
-        \brief OpenCL device types
+        \brief Device types
+        _native does not use OpenCL at all, only the host thread pool is created (for the native layers, e.g. NativePredictorLayer).
+        The OpenCL handles stay empty, so Resources and Architect (and with them Hierarchy and Agent) reject _native systems.
         */
         enum DeviceType {
-            _cpu, _gpu, _all
+            _cpu, _gpu, _all, _native
+        };
+
+        /*!
+        \brief Weight buffer layouts
+        _imageOrder: x fastest, then y, then weight index (consecutive units coalesce, default).
+        _unitMajor: [y][x][weight index], the weights of a unit are contiguous.
+        */
+        enum WeightLayout {
+            _imageOrder, _unitMajor
+        };
+
+        /*!
+        \brief Checkpoint profiles
+        _full: everything, both halves of double buffers (default).
+        _compact: live state only, the back half of double buffers and no scratch images (recreated on load).
+        */
+        enum CheckpointProfile {
+            _full, _compact
         };
 
     private:
+        /*!
+        \brief Device type the system was created with
+        */
+        DeviceType _deviceType;
+
         //!@{
         /*!
         \brief OpenCL handles
@@ -50,14 +80,69 @@ namespace ogmaneo {
         cl::CommandQueue _queue;
         //!@}
 
+        //!@{
+        /*!
+        \brief Auxiliary queues for independent work, and which queue getQueue currently returns (-1 is the primary queue)
+        */
+        std::vector<cl::CommandQueue> _auxQueues;
+        int _activeQueue;
+        //!@}
+
+        /*!
+        \brief Host worker threads, for CPU-side work
+        */
+        ThreadPool _pool;
+
+        /*!
+        \brief Optional on-disk cache of program binaries (see ComputeProgram)
+        */
+        std::shared_ptr<ProgramCache> _programCache;
+
+        /*!
+        \brief Layout of weight buffers, programs are built for it
+        */
+        WeightLayout _weightLayout;
+
+        /*!
+        \brief What save writes
+        */
+        CheckpointProfile _checkpointProfile;
+
+        //!@{
+        /*!
+        \brief Work-group size of local memory tiled kernels ({ 0, 0 } disables them), and local memory available per work-group
+        */
+        cl_int2 _tileSize;
+        cl_ulong _localMemSize;
+        //!@}
+
     public:
+        ComputeSystem()
+            : _deviceType(_all), _activeQueue(-1), _weightLayout(_imageOrder), _checkpointProfile(_full), _tileSize({ 0, 0 }), _localMemSize(0)
+        {}
+
         /*!
         \brief Create an OpenCL compute system with a given device type.
         Optional: Create from a platform index, device index, and an OpenGL context
         Default: Use the last platform and last device discovered
+        With _native no OpenCL platform is touched, the other arguments are ignored.
         */
         bool create(DeviceType type, int platformIndex = -1, int deviceIndex = -1, bool createFromGLContext = false);
 
+        /*!
+        \brief Get the device type the system was created with
+        */
+        DeviceType getDeviceType() const {
+            return _deviceType;
+        }
+
+        /*!
+        \brief Whether this is a native (host only) system, without OpenCL handles
+        */
+        bool isNative() const {
+            return _deviceType == _native;
+        }
+
         /*!
         \brief Get underlying OpenCL platform
         */
@@ -80,10 +165,116 @@ namespace ogmaneo {
         }
 
         /*!
-        \brief Get underlying OpenCL command queue
+        \brief Get the active OpenCL command queue
+        This is the primary queue unless selectQueue was called between fork and join.
         */
         cl::CommandQueue &getQueue() {
+            return _activeQueue < 0 ? _queue : _auxQueues[_activeQueue];
+        }
+
+        /*!
+        \brief Get the primary OpenCL command queue
+        */
+        cl::CommandQueue &getPrimaryQueue() {
             return _queue;
         }
+
+        /*!
+        \brief Create auxiliary in-order queues, used to run independent layers concurrently
+        0 (default) keeps everything on the primary queue.
+        */
+        void createAuxQueues(int numQueues);
+
+        /*!
+        \brief Get number of auxiliary queues
+        */
+        size_t getNumAuxQueues() const {
+            return _auxQueues.size();
+        }
+
+        //!@{
+        /*!
+        \brief Fork/join of independent work.
+        fork makes all auxiliary queues wait on the work submitted so far, selectQueue(i) then routes getQueue
+        to an auxiliary queue (round robin on i), and join makes the primary queue wait on all auxiliary work and reselects it.
+        All are no-ops without auxiliary queues.
+        */
+        void fork();
+        void selectQueue(int workIndex);
+        void join();
+        //!@}
+
+        /*!
+        \brief Get host thread pool
+        */
+        ThreadPool &getPool() {
+            return _pool;
+        }
+
+        /*!
+        \brief Set the program binary cache, nullptr disables caching (default)
+        */
+        void setProgramCache(const std::shared_ptr<ProgramCache> &programCache) {
+            _programCache = programCache;
+        }
+
+        /*!
+        \brief Get the program binary cache, nullptr if disabled
+        */
+        const std::shared_ptr<ProgramCache> &getProgramCache() const {
+            return _programCache;
+        }
+
+        /*!
+        \brief Set the weight buffer layout
+        Must be set before any programs are loaded and weights are created. Saved files use the same order regardless.
+        */
+        void setWeightLayout(WeightLayout weightLayout) {
+            _weightLayout = weightLayout;
+        }
+
+        /*!
+        \brief Get the weight buffer layout
+        */
+        WeightLayout getWeightLayout() const {
+            return _weightLayout;
+        }
+
+        /*!
+        \brief Set the checkpoint profile used by save
+        Both profiles load with the same code, compact checkpoints are roughly half the size.
+        */
+        void setCheckpointProfile(CheckpointProfile checkpointProfile) {
+            _checkpointProfile = checkpointProfile;
+        }
+
+        /*!
+        \brief Get the checkpoint profile
+        */
+        CheckpointProfile getCheckpointProfile() const {
+            return _checkpointProfile;
+        }
+
+        /*!
+        \brief Set the tile (work-group) size of local memory tiled kernels, { 0, 0 } disables tiling
+        create picks one for the device, 16x16 or 8x8 depending on the work-group limit, and none if local memory is not dedicated.
+        */
+        void setTileSize(cl_int2 tileSize) {
+            _tileSize = tileSize;
+        }
+
+        /*!
+        \brief Get the tile size of local memory tiled kernels
+        */
+        cl_int2 getTileSize() const {
+            return _tileSize;
+        }
+
+        /*!
+        \brief Get local memory available per work-group (bytes)
+        */
+        cl_ulong getLocalMemSize() const {
+            return _localMemSize;
+        }
     };
 }
\ No newline at end of file
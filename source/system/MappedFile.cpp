@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#if defined _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace ogmaneo;
+
+bool MappedFile::open(const std::string &fileName) {
+    close();
+
+#if defined _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mapping != nullptr) {
+            // The view keeps the mapping alive
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+            CloseHandle(mapping);
+
+            if (view != nullptr) {
+                _data = static_cast<const uint8_t*>(view);
+                _size = static_cast<size_t>(size.QuadPart);
+                _mapped = true;
+            }
+        }
+    }
+
+    CloseHandle(file);
+#else
+    int file = ::open(fileName.c_str(), O_RDONLY);
+
+    if (file == -1)
+        return false;
+
+    struct stat info;
+
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (view != MAP_FAILED) {
+            // Loading reads the file front to back once
+            madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+            _data = static_cast<const uint8_t*>(view);
+            _size = static_cast<size_t>(info.st_size);
+            _mapped = true;
+        }
+    }
+
+    // The mapping stays valid after closing the descriptor
+    ::close(file);
+#endif
+
+    if (_mapped)
+        return true;
+
+    // Fall back to reading the file
+    FILE* stream = fopen(fileName.c_str(), "rb");
+
+    if (stream == nullptr)
+        return false;
+
+    fseek(stream, 0L, SEEK_END);
+    _buffer.resize(static_cast<size_t>(ftell(stream)));
+    fseek(stream, 0L, SEEK_SET);
+
+    _size = fread(_buffer.data(), sizeof(uint8_t), _buffer.size(), stream);
+    _data = _buffer.data();
+
+    fclose(stream);
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (_mapped) {
+#if defined _WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+    }
+
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+}
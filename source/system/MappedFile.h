@@ -0,0 +1,76 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <system/Uncopyable.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ogmaneo {
+    /*!
+    \brief Read-only memory mapped file
+    Maps the whole file, so its contents are paged in straight from the page cache on access.
+    Falls back to reading the file into memory if it cannot be mapped.
+    */
+    class MappedFile : private Uncopyable {
+    private:
+        //!@{
+        /*!
+        \brief File contents
+        */
+        const uint8_t* _data;
+        size_t _size;
+        //!@}
+
+        /*!
+        \brief Whether _data is a mapping (else it points into _buffer)
+        */
+        bool _mapped;
+
+        /*!
+        \brief Fallback storage
+        */
+        std::vector<uint8_t> _buffer;
+
+    public:
+        MappedFile()
+            : _data(nullptr), _size(0), _mapped(false)
+        {}
+
+        ~MappedFile() {
+            close();
+        }
+
+        /*!
+        \brief Map a file, returns false if it could not be opened
+        */
+        bool open(const std::string &fileName);
+
+        /*!
+        \brief Unmap the file, invalidates all pointers into it
+        */
+        void close();
+
+        /*!
+        \brief Get the file contents
+        */
+        const uint8_t* getData() const {
+            return _data;
+        }
+
+        /*!
+        \brief Get the file size in bytes
+        */
+        size_t getSize() const {
+            return _size;
+        }
+    };
+}
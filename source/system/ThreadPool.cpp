@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+using namespace ogmaneo;
+
+namespace {
+    // Pool the calling thread works for, nullptr outside of workers
+    thread_local ThreadPool* currentPool = nullptr;
+}
+
+void ThreadPool::create(int numWorkers) {
+    destroy();
+
+    if (numWorkers <= 0)
+        numWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    _stop = false;
+
+    for (int i = 0; i < numWorkers; i++)
+        _workers.push_back(std::thread(&ThreadPool::work, this));
+}
+
+void ThreadPool::destroy() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _stop = true;
+    }
+
+    _taskCondition.notify_all();
+
+    for (int i = 0; i < _workers.size(); i++)
+        _workers[i].join();
+
+    _workers.clear();
+}
+
+bool ThreadPool::isWorkerThread() const {
+    return currentPool == this;
+}
+
+void ThreadPool::work() {
+    currentPool = this;
+
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _taskCondition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+
+            // Drain the queue before stopping
+            if (_tasks.empty())
+                return;
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+std::future<void> ThreadPool::enqueue(const std::function<void()> &task) {
+    std::shared_ptr<std::packaged_task<void()>> packagedTask = std::make_shared<std::packaged_task<void()>>(task);
+
+    std::future<void> result = packagedTask->get_future();
+
+    if (_workers.empty()) {
+        (*packagedTask)();
+
+        return result;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _tasks.push_back([packagedTask] { (*packagedTask)(); });
+    }
+
+    _taskCondition.notify_one();
+
+    return result;
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)> &func, int minChunkSize) {
+    int count = end - begin;
+
+    if (count <= 0)
+        return;
+
+    int numChunks = std::min(static_cast<int>(_workers.size()), (count + minChunkSize - 1) / std::max(1, minChunkSize));
+
+    // Not worth dispatching. Workers also run inline, waiting on chunks queued behind their own task could deadlock
+    if (numChunks <= 1 || isWorkerThread()) {
+        func(begin, end);
+
+        return;
+    }
+
+    int chunkSize = (count + numChunks - 1) / numChunks;
+
+    std::vector<std::future<void>> results;
+
+    std::exception_ptr error;
+
+    try {
+        // Calling thread takes the first chunk itself
+        for (int first = begin + chunkSize; first < end; first += chunkSize) {
+            int last = std::min(end, first + chunkSize);
+
+            results.push_back(enqueue([&func, first, last] { func(first, last); }));
+        }
+
+        func(begin, std::min(end, begin + chunkSize));
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    // Queued chunks reference func, so all of them must finish before returning (or rethrowing)
+    for (int i = 0; i < results.size(); i++) {
+        try {
+            results[i].get();
+        }
+        catch (...) {
+            if (error == nullptr)
+                error = std::current_exception();
+        }
+    }
+
+    if (error != nullptr)
+        std::rethrow_exception(error);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <system/Uncopyable.h>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace ogmaneo {
+    /*!
+    \brief Thread pool
+    Fixed set of host worker threads, used for CPU-side work that runs alongside the OpenCL device
+    */
+    class ThreadPool : private Uncopyable {
+    private:
+        //!@{
+        /*!
+        \brief Workers and pending tasks
+        */
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _tasks;
+        //!@}
+
+        //!@{
+        /*!
+        \brief Synchronization
+        */
+        std::mutex _mutex;
+        std::condition_variable _taskCondition;
+        bool _stop;
+        //!@}
+
+        /*!
+        \brief Worker loop
+        */
+        void work();
+
+    public:
+        ThreadPool()
+            : _stop(false)
+        {}
+
+        ~ThreadPool() {
+            destroy();
+        }
+
+        /*!
+        \brief Start the worker threads
+        \param numWorkers number of threads to start, 0 uses the hardware concurrency.
+        */
+        void create(int numWorkers = 0);
+
+        /*!
+        \brief Finish pending tasks and join all worker threads
+        */
+        void destroy();
+
+        /*!
+        \brief Queue a task, returns a future that becomes ready once it has run
+        Runs the task immediately on the calling thread if the pool has no workers.
+        */
+        std::future<void> enqueue(const std::function<void()> &task);
+
+        /*!
+        \brief Split [begin, end) into contiguous chunks and process them on the workers
+        Blocks until all chunks are done. func receives a sub range [first, last).
+        Called from one of the pool's own workers, the whole range runs inline on that worker.
+        If a chunk throws, the first exception is rethrown once all chunks have finished.
+        \param begin start of the range.
+        \param end end of the range (exclusive).
+        \param func function called once per chunk.
+        \param minChunkSize smallest chunk worth handing to a worker.
+        */
+        void parallelFor(int begin, int end, const std::function<void(int, int)> &func, int minChunkSize = 1);
+
+        /*!
+        \brief Whether the calling thread is one of this pool's workers
+        */
+        bool isWorkerThread() const;
+
+        /*!
+        \brief Get number of worker threads
+        */
+        size_t getNumWorkers() const {
+            return _workers.size();
+        }
+    };
+}
@@ -0,0 +1,158 @@
+// ----------------------------------------------------------------------------
+//  OgmaNeo
+//  Copyright(c) 2016 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of OgmaNeo is licensed to you under the terms described
+//  in the OGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+// Steps the same predictor layer on the native engine and on an OpenCL CPU device (e.g. pocl) and reports the time per step.
+// Only the layer step (activate, stepEnd, learn) is timed on both sides, input generation and uploads are excluded.
+// Usage: OgmaNeoNativeBenchmark [hiddenSize visibleSize radius steps platformIndex]
+
+#include "neo/NativePredictorLayer.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace ogmaneo;
+
+namespace {
+    struct Settings {
+        int _hiddenSize = 64;
+        int _visibleSize = 64;
+        int _radius = 8;
+        int _steps = 200;
+        int _platformIndex = -1;
+    };
+
+    // Sinusoid patterns, so both engines see the same inputs
+    void fillInputs(std::vector<float> &inputs, int size, int step) {
+        for (int y = 0; y < size; y++)
+            for (int x = 0; x < size; x++)
+                inputs[x + y * size] = std::sin(0.1f * (x + step)) * std::cos(0.07f * (y - step)) > 0.0f ? 1.0f : 0.0f;
+    }
+
+    double benchmarkNative(const Settings &settings, const std::vector<PredictorLayer::VisibleLayerDesc> &descs) {
+        ComputeSystem cs;
+
+        if (!cs.create(ComputeSystem::_native))
+            return -1.0;
+
+        std::mt19937 rng(1234);
+
+        NativePredictorLayer layer;
+        layer.createRandom(cs, { settings._hiddenSize, settings._hiddenSize }, descs, { -0.01f, 0.01f }, rng);
+
+        std::vector<std::vector<float>> inputs(1, std::vector<float>(settings._visibleSize * settings._visibleSize));
+        std::vector<float> targets(settings._hiddenSize * settings._hiddenSize);
+
+        double total = 0.0;
+
+        for (int s = 0; s < settings._steps; s++) {
+            fillInputs(inputs[0], settings._visibleSize, s);
+            fillInputs(targets, settings._hiddenSize, s + 1);
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            layer.activate(cs, inputs);
+            layer.stepEnd(cs);
+            layer.learn(cs, targets);
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            total += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        return total / settings._steps;
+    }
+
+    double benchmarkOpenCL(const Settings &settings, const std::vector<PredictorLayer::VisibleLayerDesc> &descs) {
+        ComputeSystem cs;
+
+        if (!cs.create(ComputeSystem::_cpu, settings._platformIndex))
+            return -1.0;
+
+        ComputeProgram program;
+
+        if (!program.loadPredictorKernel(cs))
+            return -1.0;
+
+        std::mt19937 rng(1234);
+
+        PredictorLayer layer;
+        layer.createRandom(cs, program, { settings._hiddenSize, settings._hiddenSize }, descs, nullptr, { -0.01f, 0.01f }, rng);
+
+        cl::Image2D inputImage(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), settings._visibleSize, settings._visibleSize);
+        cl::Image2D targetImage(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), settings._hiddenSize, settings._hiddenSize);
+
+        std::vector<cl::Image2D> inputImages(1, inputImage);
+
+        std::vector<float> inputs(settings._visibleSize * settings._visibleSize);
+        std::vector<float> targets(settings._hiddenSize * settings._hiddenSize);
+
+        cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+        cl::array<cl::size_type, 3> visibleRegion = { static_cast<cl::size_type>(settings._visibleSize), static_cast<cl::size_type>(settings._visibleSize), 1 };
+        cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl::size_type>(settings._hiddenSize), static_cast<cl::size_type>(settings._hiddenSize), 1 };
+
+        double total = 0.0;
+
+        for (int s = 0; s < settings._steps; s++) {
+            fillInputs(inputs, settings._visibleSize, s);
+            fillInputs(targets, settings._hiddenSize, s + 1);
+
+            // Uploads stay outside the timed region, the native layer reads host memory directly
+            cs.getQueue().enqueueWriteImage(inputImage, CL_TRUE, zeroOrigin, visibleRegion, 0, 0, inputs.data());
+            cs.getQueue().enqueueWriteImage(targetImage, CL_TRUE, zeroOrigin, hiddenRegion, 0, 0, targets.data());
+
+            cs.getQueue().finish();
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            layer.activate(cs, inputImages, rng);
+            layer.stepEnd(cs);
+            layer.learn(cs, targetImage);
+
+            // Native steps are synchronous, so wait for the kernels to match
+            cs.getQueue().finish();
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            total += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        return total / settings._steps;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+
+    if (argc > 1) settings._hiddenSize = std::stoi(argv[1]);
+    if (argc > 2) settings._visibleSize = std::stoi(argv[2]);
+    if (argc > 3) settings._radius = std::stoi(argv[3]);
+    if (argc > 4) settings._steps = std::stoi(argv[4]);
+    if (argc > 5) settings._platformIndex = std::stoi(argv[5]);
+
+    std::vector<PredictorLayer::VisibleLayerDesc> descs(1);
+    descs[0]._size = { settings._visibleSize, settings._visibleSize };
+    descs[0]._radius = settings._radius;
+
+    std::cout << "Predictor layer " << settings._hiddenSize << "x" << settings._hiddenSize
+        << ", input " << settings._visibleSize << "x" << settings._visibleSize
+        << ", radius " << settings._radius << ", " << settings._steps << " steps" << std::endl;
+
+    double nativeTime = benchmarkNative(settings, descs);
+    double openCLTime = benchmarkOpenCL(settings, descs);
+
+    std::cout << "Native: " << nativeTime << " ms/step" << std::endl;
+
+    if (openCLTime < 0.0)
+        std::cout << "OpenCL CPU device not available" << std::endl;
+    else
+        std::cout << "OpenCL CPU device: " << openCLTime << " ms/step (" << openCLTime / nativeTime << "x native)" << std::endl;
+
+    return 0;
+}